@@ -1,12 +1,20 @@
 #include <cassert>
 #include <chrono>
 #include <cmath>
+#include <deque>
 #include <functional>
 #include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
 
+#include <magic_func/cache_line_isolated.h>
+#include <magic_func/closed_function.h>
 #include <magic_func/function.h>
+#include <magic_func/function_queue.h>
 #include <magic_func/make_function.h>
 #include <magic_func/member_function.h>
+#include <magic_func/rate_limit.h>
 
 // The fast delegate implementation does not build in MSVC 2015.
 #ifdef _MSC_VER
@@ -17,6 +25,12 @@
 
 static constexpr size_t kNumExperiments = 100;
 static constexpr size_t kNumIterations = 10000000;
+static constexpr size_t kNumGrowthIterations = 100;
+static constexpr size_t kNumGrowthFunctions = 10000;
+static constexpr size_t kNumCounterExperiments = 10;
+static constexpr size_t kNumCounterThreads = 4;
+static constexpr size_t kNumQueueIterations = 1000;
+static constexpr size_t kNumQueueClosures = 1000;
 
 using Clock = std::chrono::high_resolution_clock;
 
@@ -25,6 +39,11 @@ using mf::make_function;
 using mf::MemberFunction;
 
 void FreeFunction(size_t& value);
+void AddOne(size_t& value);
+void AddTwo(size_t& value);
+void AddThree(size_t& value);
+void AddFive(size_t& value);
+void Escape(const void* pointer);
 
 struct Object {
   Object() : value(0) {}
@@ -63,6 +82,113 @@ void TestFunction(double& mean, double& stdev,
   stdev = sqrt(stdev / (double)(kNumExperiments - 1));
 }
 
+// Measures the time to fill a vector of functions without reserving memory.
+// Growing the vector moves its functions unless their moves can throw, in
+// which case they are copied along with any callables they store.
+template <typename FunctionType, typename Callable>
+void TestContainerGrowth(double& mean, double& stdev,
+                         const Callable& callable) {
+  std::unique_ptr<double[]> experiment_mean(new double[kNumExperiments]);
+  mean = 0.0;
+
+  for (size_t i = 0; i < kNumExperiments; ++i) {
+    auto start = Clock::now();
+    for (size_t j = 0; j < kNumGrowthIterations; ++j) {
+      std::vector<FunctionType> functions;
+      for (size_t k = 0; k < kNumGrowthFunctions; ++k)
+        functions.emplace_back(callable);
+    }
+    auto end = Clock::now();
+
+    Clock::duration duration =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+    experiment_mean[i] = (long double) duration.count() /
+        (kNumGrowthIterations * kNumGrowthFunctions);
+    mean += experiment_mean[i];
+  }
+
+  mean /= (double) kNumExperiments;
+  stdev = 0.0;
+  for (size_t i = 0; i < kNumExperiments; ++i) {
+    double diff = experiment_mean[i] - mean;
+    stdev += diff * diff;
+  }
+
+  stdev = sqrt(stdev / (double)(kNumExperiments - 1));
+}
+
+// Measures the time for multiple threads to call their own function at the
+// same time. Each function is only ever called by a single thread.
+void TestThreadCounters(double& mean, double& stdev,
+                        std::vector<Function<void()>>& functions) {
+  std::unique_ptr<double[]> experiment_mean(
+      new double[kNumCounterExperiments]);
+  mean = 0.0;
+
+  for (size_t i = 0; i < kNumCounterExperiments; ++i) {
+    std::vector<std::thread> threads;
+    auto start = Clock::now();
+    for (auto& function : functions) {
+      threads.emplace_back([&function]() {
+        for (size_t j = 0; j < kNumIterations; ++j)
+          function();
+      });
+    }
+
+    for (auto& thread : threads)
+      thread.join();
+    auto end = Clock::now();
+
+    Clock::duration duration =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+    experiment_mean[i] = (long double) duration.count() / kNumIterations;
+    mean += experiment_mean[i];
+  }
+
+  mean /= (double) kNumCounterExperiments;
+  stdev = 0.0;
+  for (size_t i = 0; i < kNumCounterExperiments; ++i) {
+    double diff = experiment_mean[i] - mean;
+    stdev += diff * diff;
+  }
+
+  stdev = sqrt(stdev / (double)(kNumCounterExperiments - 1));
+}
+
+// Measures the time to push a batch of closures into a queue and then run
+// them all, as done by a task loop consuming the work of each iteration.
+template <typename Push, typename Drain>
+void TestQueue(double& mean, double& stdev, const Push& push,
+               const Drain& drain) {
+  std::unique_ptr<double[]> experiment_mean(new double[kNumExperiments]);
+  mean = 0.0;
+
+  for (size_t i = 0; i < kNumExperiments; ++i) {
+    auto start = Clock::now();
+    for (size_t j = 0; j < kNumQueueIterations; ++j) {
+      for (size_t k = 0; k < kNumQueueClosures; ++k)
+        push(k);
+      drain();
+    }
+    auto end = Clock::now();
+
+    Clock::duration duration =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+    experiment_mean[i] = (long double) duration.count() /
+        (kNumQueueIterations * kNumQueueClosures);
+    mean += experiment_mean[i];
+  }
+
+  mean /= (double) kNumExperiments;
+  stdev = 0.0;
+  for (size_t i = 0; i < kNumExperiments; ++i) {
+    double diff = experiment_mean[i] - mean;
+    stdev += diff * diff;
+  }
+
+  stdev = sqrt(stdev / (double)(kNumExperiments - 1));
+}
+
 }  // anonymous namespace
 
 void BenchmarkFunction() {
@@ -174,9 +300,287 @@ void BenchmarkBoundMemberFunctionAddressAndPointer() {
 #endif
 }
 
+void BenchmarkContainerGrowth() {
+  std::cout << "# Adding a lambda to a growing vector (mean, stdev)."
+            << std::endl;
+
+  // Captures enough state to require heap storage in both implementations.
+  size_t state[8] = {};
+  auto lambda = [state]() { return state[0]; };
+
+  double mean_std = 0.0, stdev_std = 0.0;
+  TestContainerGrowth<std::function<size_t()>>(mean_std, stdev_std, lambda);
+  std::cout << "std::function " << mean_std << " " << stdev_std << std::endl;
+
+  double mean_mf = 0.0, stdev_mf = 0.0;
+  TestContainerGrowth<Function<size_t()>>(mean_mf, stdev_mf, lambda);
+  std::cout << "mf::Function " << mean_mf << " " << stdev_mf << std::endl;
+  std::cout << "Speed-up " << (mean_std / mean_mf) << "x (std)\n" << std::endl;
+}
+
+void BenchmarkReassignment() {
+  std::cout << "# Re-assigning a lambda of the same type (mean, stdev)."
+            << std::endl;
+
+  // Captures enough state to require heap storage in both implementations.
+  size_t state[8] = {};
+  auto make_lambda = [&state](size_t value) {
+    state[0] = value;
+    return [state]() { return state[0]; };
+  };
+
+  double mean_std = 0.0, stdev_std = 0.0;
+  {
+    std::function<size_t()> function;
+    size_t value = 0;
+    TestFunction(mean_std, stdev_std,
+                 [&]() { function = make_lambda(++value); });
+  }
+  std::cout << "std::function " << mean_std << " " << stdev_std << std::endl;
+
+  double mean_mf = 0.0, stdev_mf = 0.0;
+  {
+    Function<size_t()> function;
+    size_t value = 0;
+    TestFunction(mean_mf, stdev_mf,
+                 [&]() { function = make_lambda(++value); });
+  }
+  std::cout << "mf::Function " << mean_mf << " " << stdev_mf << std::endl;
+  std::cout << "Speed-up " << (mean_std / mean_mf) << "x (std)\n" << std::endl;
+}
+
+void BenchmarkThreadCounters() {
+  std::cout << "# Calling counter lambdas from " << kNumCounterThreads
+            << " threads (mean, stdev)." << std::endl;
+
+  // Small callables are usually allocated next to each other, so the counters
+  // of different threads can end up sharing cache lines.
+  double mean_shared = 0.0, stdev_shared = 0.0;
+  {
+    std::vector<Function<void()>> functions;
+    for (size_t i = 0; i < kNumCounterThreads; ++i) {
+      size_t count = 0;
+      functions.emplace_back([count]() mutable { ++count; });
+    }
+    TestThreadCounters(mean_shared, stdev_shared, functions);
+  }
+  std::cout << "mf::Function " << mean_shared << " " << stdev_shared
+            << std::endl;
+
+  double mean_isolated = 0.0, stdev_isolated = 0.0;
+  {
+    std::vector<Function<void()>> functions;
+    for (size_t i = 0; i < kNumCounterThreads; ++i) {
+      size_t count = 0;
+      functions.emplace_back(mf::MakeIsolated([count]() mutable { ++count; }));
+    }
+    TestThreadCounters(mean_isolated, stdev_isolated, functions);
+  }
+  std::cout << "mf::Function (isolated) " << mean_isolated << " "
+            << stdev_isolated << std::endl;
+  std::cout << "Speed-up " << (mean_shared / mean_isolated) << "x (shared)\n"
+            << std::endl;
+}
+
+void BenchmarkClosedFunction() {
+  std::cout << "# Calling one of a set of functions (mean, stdev)."
+            << std::endl;
+
+  // The function called depends on the current value, so that the target of
+  // each call changes in a hard to predict way.
+  double mean_mf = 0.0, stdev_mf = 0.0;
+  {
+    size_t value = 0;
+    Function<void(size_t&)> functions[] = {
+        MF_MakeFunction(&AddOne), MF_MakeFunction(&AddTwo),
+        MF_MakeFunction(&AddThree), MF_MakeFunction(&AddFive) };
+    auto function = [&functions](size_t& value) {
+      functions[value & 3](value);
+    };
+    TestFunction(mean_mf, stdev_mf, function, value);
+  }
+  std::cout << "mf::Function " << mean_mf << " " << stdev_mf << std::endl;
+
+  double mean_closed = 0.0, stdev_closed = 0.0;
+  {
+    using Closed = mf::ClosedFunction<void(size_t&), &AddOne, &AddTwo,
+                                      &AddThree, &AddFive>;
+    size_t value = 0;
+    Closed functions[] = { &AddOne, &AddTwo, &AddThree, &AddFive };
+    auto function = [&functions](size_t& value) {
+      functions[value & 3](value);
+    };
+    TestFunction(mean_closed, stdev_closed, function, value);
+  }
+  std::cout << "mf::ClosedFunction " << mean_closed << " " << stdev_closed
+            << std::endl;
+  std::cout << "Speed-up " << (mean_mf / mean_closed) << "x (mf::Function)\n"
+            << std::endl;
+}
+
+void BenchmarkLazyFunction() {
+  std::cout << "# Calling a lazily resolved function (mean, stdev)."
+            << std::endl;
+
+  double mean_mf = 0.0, stdev_mf = 0.0;
+  {
+    size_t call_count = 0;
+    auto function = Function<void(size_t&)>::FromFunction<&FreeFunction>();
+    TestFunction(mean_mf, stdev_mf, function, call_count);
+  }
+  std::cout << "mf::Function " << mean_mf << " " << stdev_mf << std::endl;
+
+  double mean_lazy = 0.0, stdev_lazy = 0.0;
+  {
+    size_t call_count = 0;
+    auto function = Function<void(size_t&)>::FromResolver(
+        []() { return &FreeFunction; });
+    TestFunction(mean_lazy, stdev_lazy, function, call_count);
+  }
+  std::cout << "mf::Function (lazy) " << mean_lazy << " " << stdev_lazy
+            << std::endl;
+  std::cout << "Speed-up " << (mean_mf / mean_lazy) << "x (eager)\n"
+            << std::endl;
+
+  std::cout << "# Creating and calling once a lazily resolved function "
+               "(mean, stdev)." << std::endl;
+
+  double mean_create = 0.0, stdev_create = 0.0;
+  {
+    size_t call_count = 0;
+    TestFunction(mean_create, stdev_create, [&call_count]() {
+      auto function = Function<void(size_t&)>::FromFunction<&FreeFunction>();
+      function(call_count);
+      Escape(&function);
+    });
+  }
+  std::cout << "mf::Function " << mean_create << " " << stdev_create
+            << std::endl;
+
+  double mean_create_lazy = 0.0, stdev_create_lazy = 0.0;
+  {
+    size_t call_count = 0;
+    TestFunction(mean_create_lazy, stdev_create_lazy, [&call_count]() {
+      auto function = Function<void(size_t&)>::FromResolver(
+          []() { return &FreeFunction; });
+      function(call_count);
+      Escape(&function);
+    });
+  }
+  std::cout << "mf::Function (lazy) " << mean_create_lazy << " "
+            << stdev_create_lazy << std::endl;
+  std::cout << "Speed-up " << (mean_create / mean_create_lazy)
+            << "x (eager)\n" << std::endl;
+}
+
+void BenchmarkFunctionQueue() {
+  std::cout << "# Pushing and running a closure in a queue (mean, stdev)."
+            << std::endl;
+
+  // Captures enough state to require heap storage in mf::Function.
+  size_t state[4] = {};
+  size_t sum = 0;
+
+  double mean_deque = 0.0, stdev_deque = 0.0;
+  {
+    std::deque<Function<void(size_t&)>> queue;
+    TestQueue(mean_deque, stdev_deque,
+              [&](size_t k) {
+                state[0] = k;
+                queue.emplace_back([state](size_t& sum) { sum += state[0]; });
+              },
+              [&]() {
+                for (auto& function : queue)
+                  function(sum);
+                queue.clear();
+              });
+  }
+  std::cout << "std::deque<mf::Function> " << mean_deque << " " << stdev_deque
+            << std::endl;
+
+  double mean_queue = 0.0, stdev_queue = 0.0;
+  {
+    mf::FunctionQueue<void(size_t&)> queue(64 * 1024);
+    TestQueue(mean_queue, stdev_queue,
+              [&](size_t k) {
+                state[0] = k;
+                queue.TryPush([state](size_t& sum) { sum += state[0]; });
+              },
+              [&]() { queue.InvokeAll(sum); });
+  }
+  std::cout << "mf::FunctionQueue " << mean_queue << " " << stdev_queue
+            << std::endl;
+  assert(sum > 0);
+  std::cout << "Speed-up " << (mean_deque / mean_queue) << "x (deque)\n"
+            << std::endl;
+}
+
+void BenchmarkRateLimit() {
+  std::cout << "# Calling a rate limited function (mean, stdev)." << std::endl;
+  auto interval = std::chrono::hours(1);
+
+  // Typical hand-written limiter storing the latest call under a mutex.
+  double mean_std = 0.0, stdev_std = 0.0;
+  {
+    std::mutex mutex;
+    Clock::time_point next_call = Clock::time_point::min();
+    size_t latest = 0, call_count = 0;
+    std::function<void(size_t)> function = [&](size_t value) {
+      std::lock_guard<std::mutex> lock(mutex);
+      latest = value;
+      auto now = Clock::now();
+      if (now < next_call)
+        return;
+      next_call = now + interval;
+      call_count += latest;
+    };
+    TestFunction(mean_std, stdev_std, function, 1);
+  }
+  std::cout << "std::function (mutex) " << mean_std << " " << stdev_std
+            << std::endl;
+
+  double mean_throttle = 0.0, stdev_throttle = 0.0;
+  {
+    size_t call_count = 0;
+    Function<void(size_t)> function = [&](size_t value) {
+      call_count += value;
+    };
+    auto throttled = mf::Throttle<Clock>(function, interval);
+    TestFunction(mean_throttle, stdev_throttle, throttled, 1);
+  }
+  std::cout << "mf::Throttle " << mean_throttle << " " << stdev_throttle
+            << std::endl;
+
+  // The executor keeps the task, so only the fast path is measured.
+  double mean_debounce = 0.0, stdev_debounce = 0.0;
+  {
+    size_t call_count = 0;
+    Function<void(size_t)> function = [&](size_t value) {
+      call_count += value;
+    };
+    Function<void()> task;
+    auto debounced = mf::Debounce<Clock>(function, interval,
+        [&task](const Function<void()>& new_task, Clock::duration) {
+          task = new_task;
+        });
+    TestFunction(mean_debounce, stdev_debounce, debounced, 1);
+  }
+  std::cout << "mf::Debounce " << mean_debounce << " " << stdev_debounce
+            << std::endl;
+  std::cout << "Speed-up " << (mean_std / mean_throttle) << "x (throttle) -- "
+            << (mean_std / mean_debounce) << "x (debounce)\n" << std::endl;
+}
+
 int main() {
   BenchmarkFunction();
   BenchmarkBoundMemberFunctionAddressAndPointer();
   BenchmarkFunctionLambda();
+  BenchmarkContainerGrowth();
+  BenchmarkReassignment();
+  BenchmarkThreadCounters();
+  BenchmarkClosedFunction();
+  BenchmarkLazyFunction();
+  BenchmarkFunctionQueue();
+  BenchmarkRateLimit();
   return 0;
 }
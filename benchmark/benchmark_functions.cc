@@ -2,6 +2,11 @@
 
 void FreeFunction(size_t& value) { ++value; }
 
+void AddOne(size_t& value) { value += 1; }
+void AddTwo(size_t& value) { value += 2; }
+void AddThree(size_t& value) { value += 3; }
+void AddFive(size_t& value) { value += 5; }
+
 struct Object {
   Object() : value(0) {}
 
@@ -12,3 +17,6 @@ struct Object {
 void Object::Function(int delta) {
   value += delta;
 }
+
+// Used to keep benchmarked objects from being optimized away.
+void Escape(const void* pointer) {}
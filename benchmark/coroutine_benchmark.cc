@@ -0,0 +1,159 @@
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include <magic_func/allocator.h>
+#include <magic_func/coroutine.h>
+
+#if defined(MF_HAS_COROUTINES)
+
+static constexpr size_t kNumExperiments = 100;
+static constexpr size_t kNumIterations = 1000000;
+static constexpr size_t kPoolBlockSize = 256;
+static constexpr size_t kPoolNumBlocks = 64;
+
+using Clock = std::chrono::high_resolution_clock;
+
+using mf::AsyncFunction;
+using mf::CustomAllocatorPromiseBase;
+using mf::Task;
+
+namespace {
+
+// Allocates fixed-size blocks from a free list, as a typical pool would.
+class PoolAllocator {
+ public:
+  PoolAllocator()
+      : buffer_(new Block[kPoolNumBlocks]), free_list_(nullptr) {
+    for (size_t i = 0; i < kPoolNumBlocks; ++i) {
+      buffer_[i].next = free_list_;
+      free_list_ = &buffer_[i];
+    }
+  }
+
+  void* Allocate(size_t size) {
+    if (size > kPoolBlockSize || !free_list_)
+      return ::operator new(size);
+
+    Block* block = free_list_;
+    free_list_ = block->next;
+    return block;
+  }
+
+  void Deallocate(void* address, size_t size) {
+    if (size > kPoolBlockSize) {
+      ::operator delete(address);
+      return;
+    }
+
+    Block* block = static_cast<Block*>(address);
+    block->next = free_list_;
+    free_list_ = block;
+  }
+
+ private:
+  union Block {
+    Block* next;
+    alignas(__STDCPP_DEFAULT_NEW_ALIGNMENT__) char data[kPoolBlockSize];
+  };
+
+  std::unique_ptr<Block[]> buffer_;
+  Block* free_list_;
+};
+
+Task<size_t> Add(size_t a, size_t b) { co_return a + b; }
+
+Task<size_t, CustomAllocatorPromiseBase> PooledAdd(size_t a, size_t b) {
+  co_return a + b;
+}
+
+// Measures the time to create, run and destroy a task.
+template <typename Coroutine>
+void TestCoroutine(double& mean, double& stdev, const Coroutine& coroutine) {
+  std::unique_ptr<double[]> experiment_mean(new double[kNumExperiments]);
+  mean = 0.0;
+
+  size_t sum = 0;
+  for (size_t i = 0; i < kNumExperiments; ++i) {
+    auto start = Clock::now();
+    for (size_t j = 0; j < kNumIterations; ++j) {
+      auto task = coroutine(sum, j);
+      task.Resume();
+      sum = task.Result();
+    }
+    auto end = Clock::now();
+
+    Clock::duration duration =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+    experiment_mean[i] = (long double) duration.count() / kNumIterations;
+    mean += experiment_mean[i];
+  }
+
+  mean /= (double) kNumExperiments;
+  stdev = 0.0;
+  for (size_t i = 0; i < kNumExperiments; ++i) {
+    double diff = experiment_mean[i] - mean;
+    stdev += diff * diff;
+  }
+
+  stdev = sqrt(stdev / (double)(kNumExperiments - 1));
+  if (sum == 0)
+    std::cout << "Unexpected result" << std::endl;
+}
+
+}  // anonymous namespace
+
+void BenchmarkFrameAllocation() {
+  std::cout << "# Creating and running a coroutine task (mean, stdev)."
+            << std::endl;
+
+  double mean_default = 0.0, stdev_default = 0.0;
+  {
+    AsyncFunction<size_t(size_t, size_t)> function =
+        AsyncFunction<size_t(size_t, size_t)>::FromFunction<&Add>();
+    TestCoroutine(mean_default, stdev_default, function);
+  }
+  std::cout << "operator new " << mean_default << " " << stdev_default
+            << std::endl;
+
+  double mean_pool = 0.0, stdev_pool = 0.0;
+  {
+    PoolAllocator pool;
+    mf::SetCustomAllocator(
+        [](size_t size, size_t, void* context) {
+          return static_cast<PoolAllocator*>(context)->Allocate(size);
+        }, &pool,
+
+        [](void* address, size_t size, size_t, void* context) {
+          static_cast<PoolAllocator*>(context)->Deallocate(address, size);
+          return true;
+        }, &pool);
+
+    using PooledFunction =
+        AsyncFunction<size_t(size_t, size_t), CustomAllocatorPromiseBase>;
+    PooledFunction function = PooledFunction::FromFunction<&PooledAdd>();
+    TestCoroutine(mean_pool, stdev_pool, function);
+
+    mf::SetCustomAllocator(nullptr, nullptr, nullptr, nullptr);
+  }
+  std::cout << "custom allocator (pool) " << mean_pool << " " << stdev_pool
+            << std::endl;
+  std::cout << "Speed-up " << (mean_default / mean_pool)
+            << "x (operator new)\n" << std::endl;
+}
+
+int main() {
+  BenchmarkFrameAllocation();
+  return 0;
+}
+
+#else
+
+int main() {
+  std::cout << "Coroutines are not supported." << std::endl;
+  return 0;
+}
+
+#endif  // defined(MF_HAS_COROUTINES)
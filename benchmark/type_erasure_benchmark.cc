@@ -0,0 +1,245 @@
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <memory>
+
+#include <magic_func/function.h>
+
+static constexpr size_t kNumExperiments = 20;
+static constexpr size_t kNumIterations = 10000000;
+
+using Clock = std::chrono::high_resolution_clock;
+
+using mf::Function;
+
+// Defined in benchmark_functions.cc so that calls cannot be optimized away.
+void AddOne(size_t& value);
+void Escape(const void* pointer);
+
+// Callable small enough to be stored inline by most function wrappers.
+struct SmallCallable {
+  void operator ()() const { AddOne(*counter); }
+  size_t* counter;
+};
+
+// Callable too large to be stored inline by any function wrapper.
+struct LargeCallable {
+  void operator ()() const { AddOne(*counter); }
+  size_t* counter;
+  size_t padding[15];
+};
+
+// Hand-written virtual interface callback, as commonly used instead of generic
+// function wrappers. Stores the callable in the heap.
+class Callback {
+ public:
+  virtual ~Callback() {}
+  virtual void Run() const = 0;
+  virtual std::unique_ptr<Callback> Clone() const = 0;
+};
+
+template <typename Callable>
+class CallbackImpl : public Callback {
+ public:
+  explicit CallbackImpl(const Callable& callable) : callable_(callable) {}
+
+  void Run() const override { callable_(); }
+  std::unique_ptr<Callback> Clone() const override {
+    return std::unique_ptr<Callback>(new CallbackImpl(callable_));
+  }
+
+ private:
+  Callable callable_;
+};
+
+// Raw function pointer plus an untyped pointer to a callable owned elsewhere.
+// Does not manage the lifetime of the callable at all.
+struct RawCallback {
+  template <typename Callable>
+  explicit RawCallback(const Callable& callable)
+      : function(&Trampoline<Callable>), data(&callable) {}
+
+  void operator ()() const { function(data); }
+
+  template <typename Callable>
+  static void Trampoline(const void* data) {
+    (*static_cast<const Callable*>(data))();
+  }
+
+  void (*function)(const void*);
+  const void* data;
+};
+
+namespace {
+
+// Measures the mean time and standard deviation in nanoseconds of running an
+// operation kNumIterations times.
+template <typename Operation>
+void TestOperation(double& mean, double& stdev, const Operation& operation) {
+  std::unique_ptr<double[]> experiment_mean(new double[kNumExperiments]);
+  mean = 0.0;
+
+  for (size_t i = 0; i < kNumExperiments; ++i) {
+    auto start = Clock::now();
+    for (size_t j = 0; j < kNumIterations; ++j)
+      operation();
+    auto end = Clock::now();
+
+    Clock::duration duration =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+    experiment_mean[i] = (long double) duration.count() / kNumIterations;
+    mean += experiment_mean[i];
+  }
+
+  mean /= (double) kNumExperiments;
+  stdev = 0.0;
+  for (size_t i = 0; i < kNumExperiments; ++i) {
+    double diff = experiment_mean[i] - mean;
+    stdev += diff * diff;
+  }
+
+  stdev = sqrt(stdev / (double)(kNumExperiments - 1));
+}
+
+// Runs an operation and prints its results, returning the mean.
+template <typename Operation>
+double RunOperation(const char* name, const Operation& operation) {
+  double mean = 0.0, stdev = 0.0;
+  TestOperation(mean, stdev, operation);
+  std::cout << name << " " << mean << " " << stdev << std::endl;
+  return mean;
+}
+
+// Prints the speed-up of mf::Function over the other type-erased designs.
+void PrintSpeedUp(double mean_mf, double mean_std, double mean_virtual) {
+  std::cout << "Speed-up " << (mean_std / mean_mf) << "x (std) -- "
+            << (mean_virtual / mean_mf) << "x (virtual)\n" << std::endl;
+}
+
+}  // anonymous namespace
+
+template <typename Callable>
+void BenchmarkCall(const char* size_name) {
+  std::cout << "# Calling a " << size_name << " callable (mean, stdev)."
+            << std::endl;
+
+  size_t counter = 0;
+  Callable callable{};
+  callable.counter = &counter;
+
+  RunOperation("direct", [&callable]() { callable(); });
+
+  RawCallback raw(callable);
+  RunOperation("pointer+void*", [&raw]() { raw(); });
+
+  std::unique_ptr<Callback> callback(new CallbackImpl<Callable>(callable));
+  double mean_virtual = RunOperation("virtual", [&callback]() {
+    callback->Run();
+  });
+
+  std::function<void()> std_function(callable);
+  double mean_std = RunOperation("std::function", [&std_function]() {
+    std_function();
+  });
+
+#ifdef __cpp_lib_move_only_function
+  std::move_only_function<void() const> move_only_function(callable);
+  RunOperation("std::move_only_function", [&move_only_function]() {
+    move_only_function();
+  });
+#endif
+
+  Function<void()> mf_function(callable);
+  double mean_mf = RunOperation("mf::Function", [&mf_function]() {
+    mf_function();
+  });
+
+  PrintSpeedUp(mean_mf, mean_std, mean_virtual);
+}
+
+template <typename Callable>
+void BenchmarkConstruction(const char* size_name) {
+  std::cout << "# Constructing and destroying from a " << size_name
+            << " callable (mean, stdev)." << std::endl;
+
+  size_t counter = 0;
+  Callable callable{};
+  callable.counter = &counter;
+
+  RunOperation("pointer+void*", [&callable]() {
+    RawCallback raw(callable);
+    Escape(&raw);
+  });
+
+  double mean_virtual = RunOperation("virtual", [&callable]() {
+    std::unique_ptr<Callback> callback(new CallbackImpl<Callable>(callable));
+    Escape(callback.get());
+  });
+
+  double mean_std = RunOperation("std::function", [&callable]() {
+    std::function<void()> function(callable);
+    Escape(&function);
+  });
+
+#ifdef __cpp_lib_move_only_function
+  RunOperation("std::move_only_function", [&callable]() {
+    std::move_only_function<void() const> function(callable);
+    Escape(&function);
+  });
+#endif
+
+  double mean_mf = RunOperation("mf::Function", [&callable]() {
+    Function<void()> function(callable);
+    Escape(&function);
+  });
+
+  PrintSpeedUp(mean_mf, mean_std, mean_virtual);
+}
+
+template <typename Callable>
+void BenchmarkCopy(const char* size_name) {
+  std::cout << "# Copying a function with a " << size_name
+            << " callable (mean, stdev)." << std::endl;
+
+  size_t counter = 0;
+  Callable callable{};
+  callable.counter = &counter;
+
+  RawCallback raw(callable);
+  RunOperation("pointer+void*", [&raw]() {
+    RawCallback copy(raw);
+    Escape(&copy);
+  });
+
+  std::unique_ptr<Callback> callback(new CallbackImpl<Callable>(callable));
+  double mean_virtual = RunOperation("virtual", [&callback]() {
+    std::unique_ptr<Callback> copy = callback->Clone();
+    Escape(copy.get());
+  });
+
+  std::function<void()> std_function(callable);
+  double mean_std = RunOperation("std::function", [&std_function]() {
+    std::function<void()> copy(std_function);
+    Escape(&copy);
+  });
+
+  // std::move_only_function cannot be copied.
+  Function<void()> mf_function(callable);
+  double mean_mf = RunOperation("mf::Function", [&mf_function]() {
+    Function<void()> copy(mf_function);
+    Escape(&copy);
+  });
+
+  PrintSpeedUp(mean_mf, mean_std, mean_virtual);
+}
+
+int main() {
+  BenchmarkCall<SmallCallable>("small");
+  BenchmarkCall<LargeCallable>("large");
+  BenchmarkConstruction<SmallCallable>("small");
+  BenchmarkConstruction<LargeCallable>("large");
+  BenchmarkCopy<SmallCallable>("small");
+  BenchmarkCopy<LargeCallable>("large");
+  return 0;
+}
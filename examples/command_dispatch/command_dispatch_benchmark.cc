@@ -0,0 +1,142 @@
+// Copyright (c) 2020, Leandro Graciá Gil
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <magic_func/function.h>
+#include <magic_func/make_function.h>
+
+#include "command_table.h"
+
+static constexpr size_t kNumExperiments = 20;
+static constexpr size_t kNumLookups = 1000000;
+
+using Clock = std::chrono::high_resolution_clock;
+
+void Open(size_t& value) { value += 1; }
+void Close(size_t& value) { value += 2; }
+void Read(size_t& value) { value += 3; }
+void Write(size_t& value) { value += 4; }
+void Seek(size_t& value) { value += 5; }
+void Flush(size_t& value) { value += 6; }
+void Stat(size_t& value) { value += 7; }
+void Sync(size_t& value) { value += 8; }
+
+constexpr auto kCommands = MakeCommandTable<void(size_t&)>({
+    {"open", &Open}, {"close", &Close}, {"read", &Read}, {"write", &Write},
+    {"seek", &Seek}, {"flush", &Flush}, {"stat", &Stat}, {"sync", &Sync},
+});
+
+namespace {
+
+// Measures the mean time and standard deviation in nanoseconds per command of
+// running a provided experiment that dispatches kNumLookups commands.
+template <typename Experiment>
+void TestLookups(double& mean, double& stdev, Experiment&& experiment) {
+  std::unique_ptr<double[]> experiment_mean(new double[kNumExperiments]);
+  mean = 0.0;
+
+  for (size_t i = 0; i < kNumExperiments; ++i) {
+    auto start = Clock::now();
+    experiment();
+    auto end = Clock::now();
+
+    Clock::duration duration =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+    experiment_mean[i] = (long double) duration.count() / kNumLookups;
+    mean += experiment_mean[i];
+  }
+
+  mean /= (double) kNumExperiments;
+  stdev = 0.0;
+  for (size_t i = 0; i < kNumExperiments; ++i) {
+    double diff = experiment_mean[i] - mean;
+    stdev += diff * diff;
+  }
+
+  stdev = sqrt(stdev / (double)(kNumExperiments - 1));
+}
+
+}  // anonymous namespace
+
+void BenchmarkCommandLookup() {
+  std::cout << "# Dispatching commands by name (mean, stdev)." << std::endl;
+
+  const std::vector<std::string> names = {
+      "open", "read", "write", "seek", "unknown", "close", "stat", "flush",
+      "sync", "read", "write" };
+
+  double mean_map = 0.0, stdev_map = 0.0;
+  {
+    std::unordered_map<std::string, mf::Function<void(size_t&)>> commands = {
+        {"open", MF_MakeFunction(&Open)}, {"close", MF_MakeFunction(&Close)},
+        {"read", MF_MakeFunction(&Read)}, {"write", MF_MakeFunction(&Write)},
+        {"seek", MF_MakeFunction(&Seek)}, {"flush", MF_MakeFunction(&Flush)},
+        {"stat", MF_MakeFunction(&Stat)}, {"sync", MF_MakeFunction(&Sync)},
+    };
+
+    size_t value = 0;
+    TestLookups(mean_map, stdev_map, [&]() {
+      for (size_t i = 0, j = 0; i < kNumLookups; ++i) {
+        auto it = commands.find(names[j]);
+        if (it != commands.end())
+          it->second(value);
+        j = j + 1 < names.size() ? j + 1 : 0;
+      }
+    });
+  }
+  std::cout << "std::unordered_map " << mean_map << " " << stdev_map
+            << std::endl;
+
+  double mean_table = 0.0, stdev_table = 0.0;
+  {
+    size_t value = 0;
+    TestLookups(mean_table, stdev_table, [&]() {
+      for (size_t i = 0, j = 0; i < kNumLookups; ++i) {
+        if (auto handler = kCommands.Find(names[j]))
+          handler(value);
+        j = j + 1 < names.size() ? j + 1 : 0;
+      }
+    });
+  }
+  std::cout << "CommandTable " << mean_table << " " << stdev_table << std::endl;
+  std::cout << "Speed-up " << (mean_map / mean_table) << "x (map)\n"
+            << std::endl;
+}
+
+int main() {
+  BenchmarkCommandLookup();
+  return 0;
+}
@@ -0,0 +1,304 @@
+// Copyright (c) 2020, Leandro Graciá Gil
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MAGIC_FUNC_EXAMPLES_COMMAND_DISPATCH_COMMAND_TABLE_H_
+#define MAGIC_FUNC_EXAMPLES_COMMAND_DISPATCH_COMMAND_TABLE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <utility>
+
+#include <magic_func/function.h>
+
+// Name of a command and the address of the function handling it.
+template <typename Signature>
+struct Command {
+  const char* name;
+  Signature* handler;
+};
+
+namespace command_table_internal {
+
+// Length of a null-terminated string.
+constexpr size_t Length(const char* str) {
+  size_t length = 0;
+  while (str[length] != '\0')
+    ++length;
+  return length;
+}
+
+// Compares two strings of the same length.
+constexpr bool Equal(const char* a, const char* b, size_t length) {
+  for (size_t i = 0; i < length; ++i) {
+    if (a[i] != b[i])
+      return false;
+  }
+  return true;
+}
+
+// Hash of a string. Mixes 8 bytes at a time, so that long names need fewer
+// multiplications than with a byte by byte hash like FNV-1a.
+constexpr uint64_t Hash(const char* str, size_t length) {
+  uint64_t hash = 0xcbf29ce484222325ull ^ length;
+  size_t i = 0;
+  for (; i + 8 <= length; i += 8) {
+    uint64_t word = 0;
+    for (size_t j = 0; j < 8; ++j)
+      word |= uint64_t(static_cast<unsigned char>(str[i + j])) << (8 * j);
+    hash = (hash ^ word) * 0x100000001b3ull;
+    hash ^= hash >> 29;
+  }
+
+  uint64_t tail = 0;
+  for (size_t j = 0; i + j < length; ++j)
+    tail |= uint64_t(static_cast<unsigned char>(str[i + j])) << (8 * j);
+  hash = (hash ^ tail) * 0x9e3779b97f4a7c15ull;
+  return hash ^ (hash >> 32);
+}
+
+// Smallest power of two greater or equal than a value.
+constexpr size_t NextPowerOfTwo(size_t value) {
+  size_t power = 1;
+  while (power < value)
+    power <<= 1;
+  return power;
+}
+
+// These are intentionally not constexpr. Reaching them while building a table
+// in a constant expression makes the build fail, pointing at the problem.
+// Tables built at runtime abort instead.
+[[noreturn]] inline void DuplicateCommandName() {
+  std::fputs("Duplicate command name.\n", stderr);
+  std::abort();
+}
+
+[[noreturn]] inline void PerfectHashNotFound() {
+  std::fputs("No perfect hash found for the command names.\n", stderr);
+  std::abort();
+}
+
+}  // namespace command_table_internal
+
+// Read-only table of commands indexed by name with a perfect hash.
+//
+// The table is built entirely at compile time from a fixed set of commands,
+// so it needs neither heap allocations nor any initialization at startup.
+// Every name is hashed once into a bucket and a displacement value chosen for
+// that bucket, which places it into a slot of its own without collisions.
+// Looking up a name costs one hash, one displacement read and one string
+// comparison to discard unknown names.
+//
+// Example:
+// void Help(const Args& args);
+// void Quit(const Args& args);
+//
+// constexpr auto kCommands = MakeCommandTable<void(const Args&)>({
+//     {"help", &Help},
+//     {"quit", &Quit},
+// });
+//
+// if (auto handler = kCommands.Find(name))
+//   handler(args);
+//
+// Building fails if two commands have the same name. Tables that are not built
+// in a constant expression check this at runtime and abort instead, so tables
+// are better declared constexpr to get such errors at compile time.
+template <typename Signature, size_t NumCommands>
+class CommandTable;
+
+template <typename Return, typename... Args, size_t NumCommands>
+class CommandTable<Return(Args...), NumCommands> {
+ public:
+  static_assert(NumCommands > 0, "At least one command is required.");
+  static_assert(NumCommands <= (1 << 16), "Too many commands.");
+
+  using HandlerType = Return (*)(Args...);
+
+  enum : size_t { kNumCommands = NumCommands };
+
+  // Number of slots in the table. Kept at a load factor of 0.5 or lower so
+  // that suitable displacements are found quickly at compile time.
+  enum : size_t {
+    kNumSlots = command_table_internal::NextPowerOfTwo(2 * NumCommands)
+  };
+
+  // Number of buckets of names sharing a displacement value.
+  enum : size_t {
+    kNumBuckets = command_table_internal::NextPowerOfTwo(NumCommands)
+  };
+
+  // Builds the table. Meant to be evaluated at compile time.
+  constexpr explicit CommandTable(
+      const Command<Return(Args...)> (&commands)[NumCommands])
+      : displacements_(), slots_() {
+    using namespace command_table_internal;
+
+    uint64_t hashes[NumCommands] = {};
+    size_t lengths[NumCommands] = {};
+    size_t bucket_sizes[kNumBuckets] = {};
+    size_t max_bucket_size = 0;
+    for (size_t i = 0; i < NumCommands; ++i) {
+      lengths[i] = Length(commands[i].name);
+      hashes[i] = Hash(commands[i].name, lengths[i]);
+      for (size_t j = 0; j < i; ++j) {
+        if (lengths[i] == lengths[j] &&
+            Equal(commands[i].name, commands[j].name, lengths[i]))
+          DuplicateCommandName();
+      }
+
+      size_t bucket_size = ++bucket_sizes[GetBucket(hashes[i])];
+      if (bucket_size > max_bucket_size)
+        max_bucket_size = bucket_size;
+    }
+
+    // Place the largest buckets first, while most slots are still free.
+    bool used[kNumSlots] = {};
+    for (size_t size = max_bucket_size; size > 0; --size) {
+      for (size_t bucket = 0; bucket < kNumBuckets; ++bucket) {
+        if (bucket_sizes[bucket] != size)
+          continue;
+
+        uint32_t displacement = FindDisplacement(bucket, hashes, used);
+        displacements_[bucket] = displacement;
+        for (size_t i = 0; i < NumCommands; ++i) {
+          if (GetBucket(hashes[i]) != bucket)
+            continue;
+
+          size_t slot = GetSlot(hashes[i], displacement);
+          used[slot] = true;
+          slots_[slot].name = commands[i].name;
+          slots_[slot].length = lengths[i];
+          slots_[slot].handler = commands[i].handler;
+        }
+      }
+    }
+  }
+
+  // Returns the handler of a command, or nullptr if the name is unknown.
+  constexpr HandlerType Find(const char* name, size_t length) const {
+    const Slot* slot = FindSlot(name, length);
+    return slot ? slot->handler : nullptr;
+  }
+
+  constexpr HandlerType Find(const char* name) const {
+    return Find(name, command_table_internal::Length(name));
+  }
+
+  HandlerType Find(const std::string& name) const {
+    return Find(name.data(), name.size());
+  }
+
+  // Returns the handler of a command as a Function, for code that stores
+  // handlers together with other callables. Empty if the name is unknown.
+  //
+  // The function refers to the slot of the command in the table instead of
+  // storing a copy of its handler, so it needs no heap allocations. The table
+  // must outlive it, which constexpr tables at namespace scope always do.
+  mf::Function<Return(Args...)> FindFunction(const std::string& name) const {
+    const Slot* slot = FindSlot(name.data(), name.size());
+    if (!slot)
+      return mf::Function<Return(Args...)>();
+    return mf::Function<Return(Args...)>::template FromMemberFunction<
+        const Slot, &Slot::Call>(slot);
+  }
+
+ private:
+  struct Slot {
+    Return Call(Args... args) const {
+      return handler(std::forward<Args>(args)...);
+    }
+
+    const char* name = nullptr;
+    size_t length = 0;
+    HandlerType handler = nullptr;
+  };
+
+  // Returns the slot of a command, or nullptr if the name is unknown.
+  constexpr const Slot* FindSlot(const char* name, size_t length) const {
+    uint64_t hash = command_table_internal::Hash(name, length);
+    const Slot& slot = slots_[GetSlot(hash, displacements_[GetBucket(hash)])];
+    return slot.length == length && slot.handler &&
+           command_table_internal::Equal(slot.name, name, length) ?
+        &slot : nullptr;
+  }
+
+  // Buckets, strides and initial slots are taken from separate hash bits so
+  // that names sharing a bucket are still spread independently.
+  static constexpr size_t GetBucket(uint64_t hash) {
+    return static_cast<size_t>(hash >> 40) & (kNumBuckets - 1);
+  }
+
+  // Displacements encode two values that move names around the table: a
+  // multiple of a stride taken from the hash, and a constant offset.
+  static constexpr size_t GetSlot(uint64_t hash, uint32_t displacement) {
+    uint64_t stride = (hash >> 20) | 1;
+    return static_cast<size_t>(hash + (displacement / kNumSlots) * stride +
+                               displacement % kNumSlots) & (kNumSlots - 1);
+  }
+
+  // Finds a displacement that places every name of a bucket in a free slot.
+  static constexpr uint32_t FindDisplacement(
+      size_t bucket, const uint64_t (&hashes)[NumCommands],
+      const bool (&used)[kNumSlots]) {
+    for (uint32_t displacement = 0;
+         displacement < kNumSlots * kNumSlots; ++displacement) {
+      bool taken[kNumSlots] = {};
+      bool valid = true;
+      for (size_t i = 0; i < NumCommands && valid; ++i) {
+        if (GetBucket(hashes[i]) != bucket)
+          continue;
+
+        size_t slot = GetSlot(hashes[i], displacement);
+        valid = !used[slot] && !taken[slot];
+        taken[slot] = true;
+      }
+
+      if (valid)
+        return displacement;
+    }
+
+    command_table_internal::PerfectHashNotFound();
+    return 0;
+  }
+
+  uint32_t displacements_[kNumBuckets];
+  Slot slots_[kNumSlots];
+};
+
+// Builds a CommandTable deducing its size from a list of commands.
+template <typename Signature, size_t NumCommands>
+constexpr CommandTable<Signature, NumCommands> MakeCommandTable(
+    const Command<Signature> (&commands)[NumCommands]) {
+  return CommandTable<Signature, NumCommands>(commands);
+}
+
+#endif  // MAGIC_FUNC_EXAMPLES_COMMAND_DISPATCH_COMMAND_TABLE_H_
@@ -0,0 +1,127 @@
+// Copyright (c) 2020, Leandro Graciá Gil
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "command_table.h"
+
+namespace {
+
+int Add(int a, int b) { return a + b; }
+int Sub(int a, int b) { return a - b; }
+int Mul(int a, int b) { return a * b; }
+
+constexpr auto kArithmetic = MakeCommandTable<int(int, int)>({
+    {"add", &Add},
+    {"sub", &Sub},
+    {"mul", &Mul},
+});
+
+template <int N>
+int Return() { return N; }
+
+// Large enough to produce buckets with several names.
+constexpr auto kNumbers = MakeCommandTable<int()>({
+    {"zero", &Return<0>}, {"one", &Return<1>}, {"two", &Return<2>},
+    {"three", &Return<3>}, {"four", &Return<4>}, {"five", &Return<5>},
+    {"six", &Return<6>}, {"seven", &Return<7>}, {"eight", &Return<8>},
+    {"nine", &Return<9>}, {"ten", &Return<10>}, {"eleven", &Return<11>},
+    {"twelve", &Return<12>}, {"thirteen", &Return<13>},
+    {"fourteen", &Return<14>}, {"fifteen", &Return<15>},
+    {"sixteen", &Return<16>}, {"seventeen", &Return<17>},
+    {"eighteen", &Return<18>}, {"nineteen", &Return<19>},
+    {"twenty", &Return<20>}, {"thirty", &Return<30>},
+    {"forty", &Return<40>}, {"fifty", &Return<50>},
+    {"sixty", &Return<60>}, {"seventy", &Return<70>},
+    {"eighty", &Return<80>}, {"ninety", &Return<90>},
+    {"hundred", &Return<100>}, {"thousand", &Return<1000>},
+    {"million", &Return<1000000>}, {"", &Return<-1>},
+});
+
+// Lookups can also be done at compile time.
+static_assert(kArithmetic.Find("sub") == &Sub, "Wrong handler.");
+static_assert(kArithmetic.Find("div") == nullptr, "Unexpected handler.");
+static_assert(decltype(kArithmetic)::kNumSlots == 8, "Unexpected size.");
+
+}  // anonymous namespace
+
+TEST(CommandTable, Find) {
+  EXPECT_EQ(kArithmetic.Find("add")(5, 3), 8);
+  EXPECT_EQ(kArithmetic.Find(std::string("sub"))(5, 3), 2);
+  EXPECT_EQ(kArithmetic.Find("mul", 3)(5, 3), 15);
+}
+
+TEST(CommandTable, UnknownCommands) {
+  EXPECT_EQ(kArithmetic.Find("div"), nullptr);
+  EXPECT_EQ(kArithmetic.Find(""), nullptr);
+  EXPECT_EQ(kArithmetic.Find("ad"), nullptr);
+  EXPECT_EQ(kArithmetic.Find("addd"), nullptr);
+  EXPECT_EQ(kArithmetic.Find("ADD"), nullptr);
+
+  // Names are compared with their length, not up to a null character.
+  EXPECT_EQ(kArithmetic.Find(std::string("add\0", 4)), nullptr);
+  EXPECT_EQ(kArithmetic.Find("address", 3), &Add);
+}
+
+TEST(CommandTable, ManyCommands) {
+  const char* names[] = {
+      "zero", "one", "two", "three", "four", "five", "six", "seven", "eight",
+      "nine", "ten", "eleven", "twelve", "thirteen", "fourteen", "fifteen",
+      "sixteen", "seventeen", "eighteen", "nineteen" };
+  for (int i = 0; i < 20; ++i) {
+    ASSERT_NE(kNumbers.Find(names[i]), nullptr) << names[i];
+    EXPECT_EQ(kNumbers.Find(names[i])(), i);
+  }
+
+  EXPECT_EQ(kNumbers.Find("ninety")(), 90);
+  EXPECT_EQ(kNumbers.Find("million")(), 1000000);
+  EXPECT_EQ(kNumbers.Find("")(), -1);
+  EXPECT_EQ(kNumbers.Find("billion"), nullptr);
+}
+
+TEST(CommandTable, FindFunction) {
+  mf::Function<int(int, int)> function = kArithmetic.FindFunction("mul");
+  ASSERT_TRUE(function);
+  EXPECT_EQ(function(5, 3), 15);
+
+  // The function refers to the table instead of owning a copy of the handler.
+  EXPECT_NE(function.GetObject(), nullptr);
+  mf::Function<int(int, int)> copy = function;
+  EXPECT_EQ(copy.GetObject(), function.GetObject());
+
+  EXPECT_FALSE(kArithmetic.FindFunction("div"));
+}
+
+TEST(CommandTable, RuntimeDuplicateNames) {
+  // Tables built at runtime cannot fail to compile, so they abort instead.
+  const Command<int(int, int)> commands[] = {{"add", &Add}, {"add", &Sub}};
+  EXPECT_DEATH(MakeCommandTable(commands), "Duplicate command name");
+}
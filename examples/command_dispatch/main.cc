@@ -0,0 +1,92 @@
+// Copyright (c) 2020, Leandro Graciá Gil
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "command_table.h"
+
+using Args = std::vector<std::string>;
+
+namespace {
+
+void Echo(const Args& args) {
+  for (const auto& arg : args)
+    std::cout << arg << " ";
+  std::cout << std::endl;
+}
+
+void Sum(const Args& args) {
+  long sum = 0;
+  for (const auto& arg : args)
+    sum += std::stol(arg);
+  std::cout << sum << std::endl;
+}
+
+void Count(const Args& args) {
+  std::cout << args.size() << " arguments" << std::endl;
+}
+
+// Built at compile time. No allocations or initialization happen at startup.
+constexpr auto kCommands = MakeCommandTable<void(const Args&)>({
+    {"echo", &Echo},
+    {"sum", &Sum},
+    {"count", &Count},
+});
+
+}  // anonymous namespace
+
+int main() {
+  const char* lines[] = {
+    "echo hello world",
+    "sum 1 2 3 4",
+    "count a b c",
+    "unknown command",
+  };
+
+  for (const char* line : lines) {
+    std::istringstream stream(line);
+    std::string name;
+    stream >> name;
+
+    Args args;
+    for (std::string arg; stream >> arg;)
+      args.push_back(arg);
+
+    std::cout << "> " << line << std::endl;
+    if (auto handler = kCommands.Find(name))
+      handler(args);
+    else
+      std::cout << "Unknown command: " << name << std::endl;
+  }
+
+  return 0;
+}
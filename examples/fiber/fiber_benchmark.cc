@@ -0,0 +1,233 @@
+// Copyright (c) 2020, Leandro Graciá Gil
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <ucontext.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+
+#include "fiber_context.h"
+#include "fiber_scheduler.h"
+
+static constexpr size_t kNumExperiments = 10;
+static constexpr size_t kNumSwitches = 1000000;
+static constexpr size_t kNumTasks = 100000;
+static constexpr size_t kNumWaitingFibers = 1000000;
+static constexpr size_t kStackSize = 16 * 1024;
+
+using Clock = std::chrono::high_resolution_clock;
+
+namespace {
+
+// Measures the mean time and standard deviation in nanoseconds per operation
+// of running a provided experiment that performs a number of them.
+template <typename Experiment>
+void TestOperations(double& mean, double& stdev, size_t num_operations,
+                    Experiment&& experiment) {
+  std::unique_ptr<double[]> experiment_mean(new double[kNumExperiments]);
+  mean = 0.0;
+
+  for (size_t i = 0; i < kNumExperiments; ++i) {
+    auto start = Clock::now();
+    experiment();
+    auto end = Clock::now();
+
+    Clock::duration duration =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+    experiment_mean[i] = (long double) duration.count() / num_operations;
+    mean += experiment_mean[i];
+  }
+
+  mean /= (double) kNumExperiments;
+  stdev = 0.0;
+  for (size_t i = 0; i < kNumExperiments; ++i) {
+    double diff = experiment_mean[i] - mean;
+    stdev += diff * diff;
+  }
+
+  stdev = sqrt(stdev / (double)(kNumExperiments - 1));
+}
+
+// Contexts switching back and forth with ucontext.
+struct UContextPingPong {
+  ucontext_t main;
+  ucontext_t fiber;
+};
+
+UContextPingPong* ucontext_ping_pong = nullptr;
+
+void UContextEntry() {
+  while (true)
+    swapcontext(&ucontext_ping_pong->fiber, &ucontext_ping_pong->main);
+}
+
+// Contexts switching back and forth with SwitchFiberContext.
+struct FiberPingPong {
+  FiberContext main;
+  FiberContext fiber;
+};
+
+void PingPongEntry(void* arg) {
+  auto state = static_cast<FiberPingPong*>(arg);
+  while (true)
+    SwitchFiberContext(&state->fiber, &state->main);
+}
+
+// Resident memory of the process in bytes, or 0 if unknown.
+size_t ResidentMemory() {
+  FILE* file = fopen("/proc/self/statm", "r");
+  if (!file)
+    return 0;
+
+  size_t size = 0, resident = 0;
+  if (fscanf(file, "%zu %zu", &size, &resident) != 2)
+    resident = 0;
+  fclose(file);
+  return resident * sysconf(_SC_PAGESIZE);
+}
+
+}  // anonymous namespace
+
+void BenchmarkContextSwitch() {
+  std::cout << "# Switching to a context and back (mean, stdev)." << std::endl;
+  std::unique_ptr<char[]> stack(new char[kStackSize]);
+
+  double mean_ucontext = 0.0, stdev_ucontext = 0.0;
+  {
+    UContextPingPong state;
+    ucontext_ping_pong = &state;
+    getcontext(&state.fiber);
+    state.fiber.uc_stack.ss_sp = stack.get();
+    state.fiber.uc_stack.ss_size = kStackSize;
+    state.fiber.uc_link = nullptr;
+    makecontext(&state.fiber, &UContextEntry, 0);
+
+    TestOperations(mean_ucontext, stdev_ucontext, kNumSwitches, [&state]() {
+      for (size_t i = 0; i < kNumSwitches; ++i)
+        swapcontext(&state.main, &state.fiber);
+    });
+  }
+  std::cout << "ucontext " << mean_ucontext << " " << stdev_ucontext
+            << std::endl;
+
+  double mean_fiber = 0.0, stdev_fiber = 0.0;
+  {
+    FiberPingPong state;
+    InitFiberContext(&state.fiber, stack.get(), kStackSize, &PingPongEntry,
+                     &state);
+    TestOperations(mean_fiber, stdev_fiber, kNumSwitches, [&state]() {
+      for (size_t i = 0; i < kNumSwitches; ++i)
+        SwitchFiberContext(&state.main, &state.fiber);
+    });
+  }
+  std::cout << "SwitchFiberContext " << mean_fiber << " " << stdev_fiber
+            << std::endl;
+  std::cout << "Speed-up " << (mean_ucontext / mean_fiber) << "x (ucontext)\n"
+            << std::endl;
+}
+
+void BenchmarkYield() {
+  std::cout << "# Yielding between two fibers (mean, stdev)." << std::endl;
+
+  double mean, stdev;
+  TestOperations(mean, stdev, 2 * kNumSwitches, []() {
+    FiberScheduler scheduler;
+    for (int i = 0; i < 2; ++i) {
+      scheduler.Spawn([]() {
+        for (size_t j = 0; j < kNumSwitches; ++j)
+          FiberScheduler::Yield();
+      });
+    }
+    scheduler.Run();
+  });
+  std::cout << "FiberScheduler::Yield " << mean << " " << stdev << "\n"
+            << std::endl;
+}
+
+void BenchmarkSpawn() {
+  std::cout << "# Spawning and running a short task (mean, stdev)."
+            << std::endl;
+
+  // The scheduler is reused, as the first time a stack is used its memory is
+  // mapped by the kernel, which dominates the cost.
+  FiberScheduler scheduler;
+  double mean, stdev;
+  TestOperations(mean, stdev, kNumTasks, [&scheduler]() {
+    size_t count = 0;
+    for (size_t i = 0; i < kNumTasks; ++i)
+      scheduler.Spawn([&count]() { ++count; });
+    scheduler.Run();
+  });
+  std::cout << "FiberScheduler::Spawn " << mean << " " << stdev << "\n"
+            << std::endl;
+}
+
+void BenchmarkWaitingFibers() {
+  std::cout << "# Memory used by " << kNumWaitingFibers
+            << " fibers waiting on an event." << std::endl;
+
+  // Stacks smaller than a page share pages with their neighbours.
+  for (size_t stack_size : {1024, 2048, 4096}) {
+    FiberScheduler::Options options;
+    options.stack_size = stack_size;
+    options.max_fibers = kNumWaitingFibers;
+    FiberScheduler scheduler(options);
+
+    FiberEvent event;
+    for (size_t i = 0; i < kNumWaitingFibers; ++i)
+      scheduler.Spawn([&event]() { event.Wait(); });
+
+    size_t memory_before = ResidentMemory();
+    auto start = Clock::now();
+    scheduler.Run();
+    event.Set();
+    scheduler.Run();
+    auto end = Clock::now();
+    size_t memory = ResidentMemory() - memory_before;
+
+    std::cout << "stack size " << stack_size << ": "
+              << memory / kNumWaitingFibers << " bytes per fiber, "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(
+                     end - start).count()
+              << " ms" << std::endl;
+  }
+  std::cout << std::endl;
+}
+
+int main() {
+  BenchmarkContextSwitch();
+  BenchmarkYield();
+  BenchmarkSpawn();
+  BenchmarkWaitingFibers();
+  return 0;
+}
@@ -0,0 +1,146 @@
+// Copyright (c) 2020, Leandro Graciá Gil
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "fiber_context.h"
+
+#include <cstdint>
+
+#if defined(FIBER_CONTEXT_X86_64)
+
+extern "C" void MagicFuncSwitchFiber(void** from_stack_pointer,
+                                     void* to_stack_pointer);
+extern "C" void MagicFuncStartFiber();
+
+// Pushes the callee-saved registers of the System V ABI and the floating point
+// control words to the current stack, swaps stack pointers and pops the ones
+// of the other context. The return address popped by ret is the point where
+// the other context switched away, or MagicFuncStartFiber for new fibers,
+// which calls the entry function stored in r13 with the argument in r12.
+asm(R"(
+  .pushsection .text
+  .globl MagicFuncSwitchFiber
+  .type MagicFuncSwitchFiber, @function
+  .p2align 4
+MagicFuncSwitchFiber:
+  pushq %rbp
+  pushq %rbx
+  pushq %r12
+  pushq %r13
+  pushq %r14
+  pushq %r15
+  subq $8, %rsp
+  stmxcsr (%rsp)
+  fnstcw 4(%rsp)
+  movq %rsp, (%rdi)
+  movq %rsi, %rsp
+  ldmxcsr (%rsp)
+  fldcw 4(%rsp)
+  addq $8, %rsp
+  popq %r15
+  popq %r14
+  popq %r13
+  popq %r12
+  popq %rbx
+  popq %rbp
+  ret
+  .size MagicFuncSwitchFiber, .-MagicFuncSwitchFiber
+
+  .globl MagicFuncStartFiber
+  .type MagicFuncStartFiber, @function
+  .p2align 4
+MagicFuncStartFiber:
+  movq %r12, %rdi
+  callq *%r13
+  ud2
+  .size MagicFuncStartFiber, .-MagicFuncStartFiber
+  .popsection
+)");
+
+void InitFiberContext(FiberContext* context, void* stack, size_t stack_size,
+                      FiberEntry entry, void* arg) {
+  // Build the frame popped by MagicFuncSwitchFiber. The stack pointer after
+  // popping the return address must be 16-byte aligned, so that the entry
+  // function is called with the alignment required by the ABI.
+  uintptr_t top = reinterpret_cast<uintptr_t>(stack) + stack_size;
+  top = (top & ~static_cast<uintptr_t>(15)) - 16;
+  uint64_t* frame = reinterpret_cast<uint64_t*>(top) - 8;
+
+  frame[0] = 0x037F00001F80;  // Default x87 control word and MXCSR.
+  frame[1] = 0;  // r15.
+  frame[2] = 0;  // r14.
+  frame[3] = reinterpret_cast<uint64_t>(entry);  // r13.
+  frame[4] = reinterpret_cast<uint64_t>(arg);  // r12.
+  frame[5] = 0;  // rbx.
+  frame[6] = 0;  // rbp.
+  frame[7] = reinterpret_cast<uint64_t>(&MagicFuncStartFiber);
+  context->stack_pointer = frame;
+}
+
+void SwitchFiberContext(FiberContext* from, FiberContext* to) {
+  MagicFuncSwitchFiber(&from->stack_pointer, to->stack_pointer);
+}
+
+#else
+
+namespace {
+
+// makecontext only passes int arguments, so pointers are split in two.
+void StartFiber(unsigned entry_high, unsigned entry_low,
+                unsigned arg_high, unsigned arg_low) {
+  auto join = [](unsigned high, unsigned low) {
+    return (static_cast<uintptr_t>(high) << 16 << 16) | low;
+  };
+
+  auto entry = reinterpret_cast<FiberEntry>(join(entry_high, entry_low));
+  entry(reinterpret_cast<void*>(join(arg_high, arg_low)));
+}
+
+}  // anonymous namespace
+
+void InitFiberContext(FiberContext* context, void* stack, size_t stack_size,
+                      FiberEntry entry, void* arg) {
+  uintptr_t entry_bits = reinterpret_cast<uintptr_t>(entry);
+  uintptr_t arg_bits = reinterpret_cast<uintptr_t>(arg);
+
+  getcontext(&context->context);
+  context->context.uc_stack.ss_sp = stack;
+  context->context.uc_stack.ss_size = stack_size;
+  context->context.uc_link = nullptr;
+  makecontext(&context->context, reinterpret_cast<void (*)()>(&StartFiber), 4,
+              static_cast<unsigned>(entry_bits >> 16 >> 16),
+              static_cast<unsigned>(entry_bits),
+              static_cast<unsigned>(arg_bits >> 16 >> 16),
+              static_cast<unsigned>(arg_bits));
+}
+
+void SwitchFiberContext(FiberContext* from, FiberContext* to) {
+  swapcontext(&from->context, &to->context);
+}
+
+#endif  // defined(FIBER_CONTEXT_X86_64)
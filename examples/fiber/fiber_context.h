@@ -0,0 +1,70 @@
+// Copyright (c) 2020, Leandro Graciá Gil
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MAGIC_FUNC_EXAMPLES_FIBER_FIBER_CONTEXT_H_
+#define MAGIC_FUNC_EXAMPLES_FIBER_FIBER_CONTEXT_H_
+
+#include <cstddef>
+
+// Context switches are implemented in assembly for x86-64 ELF targets.
+#if defined(__x86_64__) && defined(__ELF__)
+#define FIBER_CONTEXT_X86_64 1
+#else
+#include <ucontext.h>
+#endif
+
+// Entry point of a fiber. Must never return.
+using FiberEntry = void (*)(void* arg);
+
+// Saved execution context of a fiber.
+//
+// In x86-64 ELF targets only the stack pointer is kept, as the callee-saved
+// registers and the floating point control words are pushed to the stack of
+// the fiber when switching away from it. Switching contexts is then a handful
+// of instructions without any syscalls. Other platforms fall back to
+// ucontext, which is much slower because it saves and restores the signal
+// mask.
+struct FiberContext {
+#if defined(FIBER_CONTEXT_X86_64)
+  void* stack_pointer = nullptr;
+#else
+  ucontext_t context;
+#endif
+};
+
+// Prepares a context that starts running entry(arg) on the provided stack when
+// switched to. The stack must be at least 16-byte aligned.
+void InitFiberContext(FiberContext* context, void* stack, size_t stack_size,
+                      FiberEntry entry, void* arg);
+
+// Saves the current execution context into from and resumes the one in to.
+// Returns when some other context switches back to from.
+void SwitchFiberContext(FiberContext* from, FiberContext* to);
+
+#endif  // MAGIC_FUNC_EXAMPLES_FIBER_FIBER_CONTEXT_H_
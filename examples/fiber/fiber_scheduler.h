@@ -0,0 +1,364 @@
+// Copyright (c) 2020, Leandro Graciá Gil
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MAGIC_FUNC_EXAMPLES_FIBER_FIBER_SCHEDULER_H_
+#define MAGIC_FUNC_EXAMPLES_FIBER_FIBER_SCHEDULER_H_
+
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include <magic_func/function.h>
+
+#include "fiber_context.h"
+
+class FiberEvent;
+
+// Cooperative scheduler running mf::Function tasks in fibers.
+//
+// Each task runs in a fiber with a small stack of its own, and keeps running
+// until it finishes, yields or waits on an event. Fibers are then switched in
+// user space, saving and restoring only a few registers. All the fibers of a
+// scheduler run in the thread calling Run.
+//
+// Stacks are fixed-size slices of a single memory mapping reserved up front
+// for the maximum number of fibers, so memory use is bounded by the options.
+// Only the pages actually touched by fibers become resident, so a fiber
+// waiting on an event with a shallow call stack costs about one page, or less
+// if stacks are smaller than a page. The state of each fiber is kept at the
+// top of its stack, so running a task does not allocate any more memory.
+// Tasks spawned while all stacks are in use wait until some fiber finishes.
+//
+// Stacks are not protected by guard pages, since a mapping per fiber would
+// exceed the system limits with millions of fibers. Tasks must not use more
+// stack than configured, and must not let exceptions escape.
+//
+// Example:
+// FiberScheduler scheduler;
+// FiberEvent ready;
+// scheduler.Spawn([&ready]() {
+//   ready.Wait();
+//   std::cout << "Ready" << std::endl;
+// });
+// scheduler.Spawn([&ready]() {
+//   FiberScheduler::Yield();
+//   ready.Set();
+// });
+// scheduler.Run();
+class FiberScheduler {
+ public:
+  struct Options {
+    // Size of the stack of each fiber in bytes. Must be a multiple of 16.
+    size_t stack_size = 16 * 1024;
+
+    // Maximum number of fibers alive at the same time.
+    size_t max_fibers = 64 * 1024;
+  };
+
+  FiberScheduler() : FiberScheduler(Options()) {}
+
+  explicit FiberScheduler(const Options& options)
+      : stack_size_(options.stack_size),
+        max_fibers_(options.max_fibers) {
+    assert(stack_size_ % 16 == 0 && stack_size_ >= sizeof(Fiber) + 256);
+    num_stack_colors_ = std::max<size_t>(1, std::min<size_t>(
+        kMaxStackColors, stack_size_ / 4 / kStackColorSize));
+    stacks_size_ = stack_size_ * max_fibers_;
+    void* stacks = mmap(nullptr, stacks_size_, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (stacks == MAP_FAILED)
+      std::abort();
+    stacks_ = static_cast<uint8_t*>(stacks);
+  }
+
+  // Fibers still waiting on events are abandoned without unwinding their
+  // stacks, but their tasks are destroyed. Events they were waiting on must
+  // not be set afterwards.
+  ~FiberScheduler() {
+    assert(!current_fiber());
+    std::vector<bool> free_stacks(num_stacks_, false);
+    for (size_t index : free_stacks_)
+      free_stacks[index] = true;
+    for (size_t index = 0; index < num_stacks_; ++index) {
+      if (!free_stacks[index])
+        GetFiber(index)->~Fiber();
+    }
+
+    munmap(stacks_, stacks_size_);
+  }
+
+  FiberScheduler(const FiberScheduler&) = delete;
+  FiberScheduler& operator =(const FiberScheduler&) = delete;
+
+  // Queues a task to run in a fiber of its own. Can be called from fibers.
+  void Spawn(mf::Function<void()> task) {
+    pending_tasks_.push_back(std::move(task));
+  }
+
+  // Runs fibers until all of them finish or wait on events. Can be called
+  // again after setting events to resume the fibers waiting on them.
+  void Run() {
+    assert(!current_fiber());
+    while (true) {
+      StartPendingTasks();
+      Fiber* fiber = ready_.Pop();
+      if (!fiber)
+        break;
+
+      current_fiber() = fiber;
+      SwitchFiberContext(&context_, &fiber->context);
+      current_fiber() = nullptr;
+
+      if (fiber->finished)
+        Release(fiber);
+    }
+  }
+
+  // Lets other ready fibers run before continuing. Must be called from a
+  // fiber.
+  static void Yield() {
+    Fiber* fiber = current_fiber();
+    assert(fiber);
+    fiber->scheduler->ready_.Push(fiber);
+    fiber->scheduler->Suspend(fiber);
+  }
+
+  // Returns the scheduler running the current fiber, or nullptr if not called
+  // from a fiber.
+  static FiberScheduler* Current() {
+    Fiber* fiber = current_fiber();
+    return fiber ? fiber->scheduler : nullptr;
+  }
+
+  // Number of fibers started and not finished yet.
+  size_t num_fibers() const { return num_fibers_; }
+
+  // Number of tasks waiting for a fiber to run.
+  size_t num_pending_tasks() const { return pending_tasks_.size(); }
+
+  // Bytes reserved for stacks. Only touched pages are actually used.
+  size_t reserved_memory() const { return stacks_size_; }
+
+ private:
+  friend class FiberEvent;
+
+  // State of a fiber, placed at the top of its stack.
+  struct Fiber {
+    FiberContext context;
+    FiberScheduler* scheduler;
+    mf::Function<void()> task;
+    Fiber* next = nullptr;
+    size_t index;
+    bool finished = false;
+  };
+
+  // Intrusive FIFO list of fibers.
+  class FiberList {
+   public:
+    void Push(Fiber* fiber) {
+      fiber->next = nullptr;
+      if (tail_)
+        tail_->next = fiber;
+      else
+        head_ = fiber;
+      tail_ = fiber;
+      ++size_;
+    }
+
+    Fiber* Pop() {
+      Fiber* fiber = head_;
+      if (fiber) {
+        head_ = fiber->next;
+        if (!head_)
+          tail_ = nullptr;
+        --size_;
+      }
+      return fiber;
+    }
+
+    bool empty() const { return !head_; }
+    size_t size() const { return size_; }
+
+   private:
+    Fiber* head_ = nullptr;
+    Fiber* tail_ = nullptr;
+    size_t size_ = 0;
+  };
+
+  // Stacks are colored to use different cache sets, using up to a quarter of
+  // each stack.
+  enum : size_t { kMaxStackColors = 16, kStackColorSize = 64 };
+
+  // Number of ready fibers below which pending tasks keep being started.
+  enum : size_t { kMaxReadyToStart = 64 };
+
+  static Fiber*& current_fiber() {
+    static thread_local Fiber* fiber = nullptr;
+    return fiber;
+  }
+
+  static void FiberMain(void* arg) {
+    Fiber* fiber = static_cast<Fiber*>(arg);
+    fiber->task();
+    fiber->task = nullptr;
+    fiber->finished = true;
+    SwitchFiberContext(&fiber->context, &fiber->scheduler->context_);
+
+    // Finished fibers are never resumed.
+    std::abort();
+  }
+
+  // Starts fibers for pending tasks while there are stacks available.
+  //
+  // Tasks are started as long as there are few fibers ready to run, so that
+  // the stacks of finished fibers are reused while still in cache instead of
+  // touching one new stack per task in large bursts. At least one task is
+  // started each time, so that they are not delayed indefinitely by fibers
+  // that keep yielding.
+  void StartPendingTasks() {
+    size_t started = 0;
+    while (!pending_tasks_.empty() && num_fibers_ < max_fibers_ &&
+           (started == 0 || ready_.size() < kMaxReadyToStart)) {
+      ++started;
+
+      // Reuse the most recently released stacks first, as their pages are
+      // probably resident already.
+      size_t index;
+      if (!free_stacks_.empty()) {
+        index = free_stacks_.back();
+        free_stacks_.pop_back();
+      } else {
+        index = num_stacks_++;
+      }
+
+      uint8_t* stack = stacks_ + index * stack_size_;
+      size_t usable_size = GetUsableStackSize(index);
+      Fiber* fiber = new (stack + usable_size) Fiber();
+      fiber->scheduler = this;
+      fiber->task = std::move(pending_tasks_.front());
+      fiber->index = index;
+      pending_tasks_.pop_front();
+
+      InitFiberContext(&fiber->context, stack, usable_size, &FiberMain, fiber);
+      ++num_fibers_;
+      ready_.Push(fiber);
+    }
+  }
+
+  // Returns the size of a stack below the state of its fiber.
+  size_t GetUsableStackSize(size_t index) const {
+    // Stacks start at different offsets within a page, as otherwise the tops
+    // of all stacks compete for the same cache sets.
+    size_t offset = (index % num_stack_colors_) * kStackColorSize;
+    size_t usable_size = stack_size_ - sizeof(Fiber) - offset;
+    return usable_size & ~static_cast<size_t>(alignof(Fiber) - 1);
+  }
+
+  // Returns the state of the fiber using a stack.
+  Fiber* GetFiber(size_t index) const {
+    return reinterpret_cast<Fiber*>(stacks_ + index * stack_size_ +
+                                    GetUsableStackSize(index));
+  }
+
+  // Switches from a fiber back to the scheduler.
+  void Suspend(Fiber* fiber) {
+    SwitchFiberContext(&fiber->context, &context_);
+  }
+
+  void Release(Fiber* fiber) {
+    size_t index = fiber->index;
+    fiber->~Fiber();
+    --num_fibers_;
+    free_stacks_.push_back(index);
+  }
+
+  const size_t stack_size_;
+  const size_t max_fibers_;
+  size_t num_stack_colors_;
+  size_t stacks_size_;
+  uint8_t* stacks_;
+
+  FiberContext context_;
+  FiberList ready_;
+  std::deque<mf::Function<void()>> pending_tasks_;
+  std::vector<size_t> free_stacks_;
+
+  // Stacks used at some point. Stacks after these have never been touched.
+  size_t num_stacks_ = 0;
+  size_t num_fibers_ = 0;
+};
+
+// Event fibers can wait on until it is set.
+//
+// Events must only be used by fibers of the same scheduler, or by the thread
+// running it while it is not in Run.
+class FiberEvent {
+ public:
+  FiberEvent() = default;
+  FiberEvent(const FiberEvent&) = delete;
+  FiberEvent& operator =(const FiberEvent&) = delete;
+
+  // Suspends the current fiber until the event is set. Returns immediately if
+  // already set. Must be called from a fiber.
+  void Wait() {
+    if (set_)
+      return;
+
+    FiberScheduler::Fiber* fiber = FiberScheduler::current_fiber();
+    assert(fiber);
+    waiters_.Push(fiber);
+    fiber->scheduler->Suspend(fiber);
+  }
+
+  // Sets the event, making all the fibers waiting on it ready to run.
+  void Set() {
+    set_ = true;
+    while (FiberScheduler::Fiber* fiber = waiters_.Pop())
+      fiber->scheduler->ready_.Push(fiber);
+  }
+
+  // Clears the event, so that new calls to Wait suspend again.
+  void Reset() { set_ = false; }
+
+  bool is_set() const { return set_; }
+
+ private:
+  FiberScheduler::FiberList waiters_;
+  bool set_ = false;
+};
+
+#endif  // MAGIC_FUNC_EXAMPLES_FIBER_FIBER_SCHEDULER_H_
@@ -0,0 +1,201 @@
+// Copyright (c) 2020, Leandro Graciá Gil
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "fiber_context.h"
+#include "fiber_scheduler.h"
+
+namespace {
+
+struct PingPong {
+  FiberContext main;
+  FiberContext fiber;
+  std::vector<int> trace;
+};
+
+void PingPongEntry(void* arg) {
+  auto state = static_cast<PingPong*>(arg);
+  for (int i = 0; i < 3; ++i) {
+    state->trace.push_back(i);
+    SwitchFiberContext(&state->fiber, &state->main);
+  }
+
+  // Entry functions never return.
+  while (true)
+    SwitchFiberContext(&state->fiber, &state->main);
+}
+
+}  // anonymous namespace
+
+TEST(Fiber, SwitchContext) {
+  alignas(16) static char stack[16 * 1024];
+  PingPong state;
+  InitFiberContext(&state.fiber, stack, sizeof(stack), &PingPongEntry, &state);
+
+  for (int i = 0; i < 3; ++i) {
+    SwitchFiberContext(&state.main, &state.fiber);
+    state.trace.push_back(10 + i);
+  }
+
+  EXPECT_EQ(state.trace, std::vector<int>({0, 10, 1, 11, 2, 12}));
+}
+
+TEST(Fiber, RunTasks) {
+  FiberScheduler scheduler;
+  std::vector<int> trace;
+  for (int i = 0; i < 3; ++i)
+    scheduler.Spawn([&trace, i]() { trace.push_back(i); });
+  EXPECT_EQ(scheduler.num_pending_tasks(), 3u);
+
+  scheduler.Run();
+  EXPECT_EQ(trace, std::vector<int>({0, 1, 2}));
+  EXPECT_EQ(scheduler.num_fibers(), 0u);
+  EXPECT_EQ(scheduler.num_pending_tasks(), 0u);
+}
+
+TEST(Fiber, Yield) {
+  FiberScheduler scheduler;
+  std::string trace;
+  for (char name : std::string("ab")) {
+    scheduler.Spawn([&trace, name]() {
+      for (int i = 0; i < 3; ++i) {
+        trace += name;
+        FiberScheduler::Yield();
+      }
+    });
+  }
+
+  scheduler.Run();
+  EXPECT_EQ(trace, "ababab");
+}
+
+TEST(Fiber, Events) {
+  FiberScheduler scheduler;
+  FiberEvent started, released;
+  std::string trace;
+
+  scheduler.Spawn([&]() {
+    trace += "a";
+    started.Wait();
+    trace += "c";
+    released.Wait();
+    trace += "e";
+  });
+  scheduler.Spawn([&]() {
+    trace += "b";
+    started.Set();
+    FiberScheduler::Yield();
+    trace += "d";
+  });
+
+  // Fibers waiting on events stay suspended when Run returns.
+  scheduler.Run();
+  EXPECT_EQ(trace, "abcd");
+  EXPECT_EQ(scheduler.num_fibers(), 1u);
+
+  released.Set();
+  scheduler.Run();
+  EXPECT_EQ(trace, "abcde");
+  EXPECT_EQ(scheduler.num_fibers(), 0u);
+
+  // Set events do not suspend.
+  EXPECT_TRUE(released.is_set());
+  released.Reset();
+  EXPECT_FALSE(released.is_set());
+}
+
+TEST(Fiber, DestroyWaitingFibers) {
+  auto captured = std::make_shared<int>(0);
+  FiberEvent never_set;
+  {
+    FiberScheduler scheduler;
+    scheduler.Spawn([captured, &never_set]() { never_set.Wait(); });
+    scheduler.Spawn([captured]() {});
+    scheduler.Run();
+    EXPECT_EQ(scheduler.num_fibers(), 1u);
+    EXPECT_EQ(captured.use_count(), 2);
+  }
+
+  // The task of the waiting fiber is destroyed with the scheduler.
+  EXPECT_EQ(captured.use_count(), 1);
+}
+
+TEST(Fiber, MaxFibers) {
+  FiberScheduler::Options options;
+  options.max_fibers = 2;
+  FiberScheduler scheduler(options);
+
+  // Tasks wait for a stack when all of them are in use.
+  FiberEvent event;
+  size_t max_fibers_seen = 0, finished = 0;
+  for (int i = 0; i < 10; ++i) {
+    scheduler.Spawn([&]() {
+      max_fibers_seen = std::max(max_fibers_seen, scheduler.num_fibers());
+      EXPECT_EQ(FiberScheduler::Current(), &scheduler);
+      FiberScheduler::Yield();
+      ++finished;
+    });
+  }
+
+  scheduler.Run();
+  EXPECT_EQ(max_fibers_seen, 2u);
+  EXPECT_EQ(finished, 10u);
+  EXPECT_EQ(FiberScheduler::Current(), nullptr);
+}
+
+TEST(Fiber, ManyFibers) {
+  constexpr size_t kNumFibers = 10000;
+  FiberScheduler::Options options;
+  options.stack_size = 4096;
+  options.max_fibers = kNumFibers + 2;
+  FiberScheduler scheduler(options);
+
+  // All fibers are alive at the same time, waiting on the same event.
+  FiberEvent event;
+  size_t woken = 0;
+  for (size_t i = 0; i < kNumFibers; ++i) {
+    scheduler.Spawn([&]() {
+      event.Wait();
+      ++woken;
+    });
+  }
+
+  // Fibers can spawn new tasks too.
+  scheduler.Spawn([&]() { scheduler.Spawn([&]() { event.Set(); }); });
+
+  scheduler.Run();
+  EXPECT_EQ(woken, kNumFibers);
+  EXPECT_EQ(scheduler.num_fibers(), 0u);
+}
@@ -0,0 +1,111 @@
+// Copyright (c) 2020, Leandro Graciá Gil
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "fiber_scheduler.h"
+
+namespace {
+
+// Resident memory of the process in bytes, or 0 if unknown.
+size_t ResidentMemory() {
+  FILE* file = fopen("/proc/self/statm", "r");
+  if (!file)
+    return 0;
+
+  size_t size = 0, resident = 0;
+  if (fscanf(file, "%zu %zu", &size, &resident) != 2)
+    resident = 0;
+  fclose(file);
+  return resident * sysconf(_SC_PAGESIZE);
+}
+
+// Simulated connection waiting for requests to arrive.
+struct Connection {
+  FiberEvent readable;
+  int pending_requests = 0;
+  int handled_requests = 0;
+};
+
+}  // anonymous namespace
+
+int main() {
+  constexpr size_t kNumConnections = 100000;
+  constexpr int kRequestsPerConnection = 3;
+
+  FiberScheduler::Options options;
+  options.stack_size = 4096;
+  options.max_fibers = kNumConnections + 1;
+  FiberScheduler scheduler(options);
+
+  // One handler fiber per connection, blocking until its requests arrive.
+  std::vector<std::unique_ptr<Connection>> connections;
+  for (size_t i = 0; i < kNumConnections; ++i) {
+    connections.emplace_back(new Connection());
+    Connection* connection = connections.back().get();
+    scheduler.Spawn([connection]() {
+      for (int j = 0; j < kRequestsPerConnection; ++j) {
+        connection->readable.Wait();
+        connection->readable.Reset();
+        connection->handled_requests += connection->pending_requests;
+        connection->pending_requests = 0;
+      }
+    });
+  }
+
+  size_t memory_before = ResidentMemory();
+  scheduler.Run();
+  std::cout << scheduler.num_fibers() << " fibers waiting, using "
+            << (ResidentMemory() - memory_before) / scheduler.num_fibers()
+            << " bytes each" << std::endl;
+
+  // Poller fiber delivering requests to all the connections.
+  scheduler.Spawn([&connections]() {
+    for (int j = 0; j < kRequestsPerConnection; ++j) {
+      for (auto& connection : connections) {
+        ++connection->pending_requests;
+        connection->readable.Set();
+      }
+      FiberScheduler::Yield();
+    }
+  });
+  scheduler.Run();
+
+  size_t handled = 0;
+  for (auto& connection : connections)
+    handled += connection->handled_requests;
+  std::cout << handled << " requests handled, " << scheduler.num_fibers()
+            << " fibers left" << std::endl;
+  return 0;
+}
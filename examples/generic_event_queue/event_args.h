@@ -0,0 +1,112 @@
+// Copyright (c) 2020, Leandro Graciá Gil
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MAGIC_FUNC_EXAMPLES_GENERIC_EVENT_QUEUE_EVENT_ARGS_H_
+#define MAGIC_FUNC_EXAMPLES_GENERIC_EVENT_QUEUE_EVENT_ARGS_H_
+
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include <magic_func/error.h>
+
+#include "cpp14_helpers.h"
+
+// Wraps a tuple with the constructor arguments of an event argument.
+// Used to construct event arguments in place from multiple arguments.
+template <typename Tuple>
+struct PiecewiseArgs {
+  std::remove_reference_t<Tuple>* args;
+};
+
+template <typename T>
+struct IsPiecewiseArgs : std::false_type {};
+
+template <typename Tuple>
+struct IsPiecewiseArgs<PiecewiseArgs<Tuple>> : std::true_type {};
+
+// Storage for an argument of an enqueued event.
+//
+// The value can be constructed either from a single argument, as when calling
+// the event function, or in place from a PiecewiseArgs tuple of constructor
+// arguments. In both cases no temporary copies of the value are created.
+template <typename T>
+struct EventArg {
+  template <typename U,
+            typename = std::enable_if_t<
+                !std::is_same<std::decay_t<U>, EventArg>::value &&
+                !IsPiecewiseArgs<std::decay_t<U>>::value>>
+  EventArg(U&& arg) : value(std::forward<U>(arg)) {}
+
+  template <typename Tuple>
+  EventArg(PiecewiseArgs<Tuple> piecewise)
+      : EventArg(std::forward<Tuple>(*piecewise.args),
+                 std::make_index_sequence<
+                     std::tuple_size<std::decay_t<Tuple>>::value>()) {}
+
+  T value;
+
+ private:
+  template <typename Tuple, size_t... Indices>
+  EventArg(Tuple&& args, std::index_sequence<Indices...>)
+      : value(std::get<Indices>(std::forward<Tuple>(args))...) {}
+};
+
+// Storage for a const T& event argument enqueued as a std::shared_ptr to a
+// const T. Listeners receive a reference to the shared object, so it is never
+// copied, neither when enqueuing nor when dispatching.
+template <typename T>
+struct SharedEventArg {
+  using Type = T;
+
+  SharedEventArg(std::shared_ptr<const T> ptr) : ptr(std::move(ptr)) {
+    MAGIC_FUNC_CHECK(this->ptr, mf::Error::kInvalidObject);
+  }
+
+  std::shared_ptr<const T> ptr;
+};
+
+template <typename T>
+struct IsSharedEventArg : std::false_type {};
+
+template <typename T>
+struct IsSharedEventArg<SharedEventArg<T>> : std::true_type {};
+
+// Tells if an argument provided when enqueuing an event is a shared pointer
+// that can be shared by all the listeners of a parameter of type Param.
+// This is the case when Param is a const T& and the pointer is to a T.
+template <typename Arg, typename Param>
+struct IsSharedPayload : std::false_type {};
+
+template <typename T, typename U>
+struct IsSharedPayload<std::shared_ptr<T>, const U&>
+    : std::is_same<std::remove_const_t<T>, U> {};
+
+#endif  // MAGIC_FUNC_EXAMPLES_GENERIC_EVENT_QUEUE_EVENT_ARGS_H_
@@ -31,18 +31,27 @@
 #define MAGIC_FUNC_EXAMPLES_GENERIC_EVENT_QUEUE_EVENT_TUPLE_EXTRACTOR_H_
 
 #include "cpp14_helpers.h"
+#include "event_args.h"
 
-// Utility functions to extract elements from a tuple for use in callbacks.
+// Utility functions to extract elements from a tuple of event arguments for use
+// in callbacks.
 //
 // The following function proceed as follows:
 // 1. If the type is an lvalue reference then it's passed like that.
 // 2. If the type is an rvalue reference then it's moved.
-// 3. If the type is not a reference and it's copy-constructible, it's copied.
-// 4. If the type is not a reference nor not copy-constructible, it's moved.
+// 3. If the type is a SharedEventArg, a const reference to the shared object
+//    is passed, also in the last callback.
+// 4. If the type is not a reference and it's copy-constructible, a const
+//    reference is passed. Callbacks taking the argument by value copy it, but
+//    those taking a const reference don't.
+// 5. If the type is not a reference nor not copy-constructible, it's moved.
 //
 // This is designed to support both broadcasting and single observers taking
 // moveable-only or object references. To force an object to be moved even if
 // copy-constructible, use an rvalue reference type.
+//
+// ExpandLastEventArgs behaves the same except that copy-constructible types
+// are moved. It is meant for the last callback using the tuple.
 
 // Shortcut for getting the I-th type of a tuple of types.
 template <size_t I, typename... Types>
@@ -52,25 +61,35 @@ using IthType = std::tuple_element_t<I, std::tuple<Types...>>;
 template <size_t I, typename... Types>
 std::enable_if_t<std::is_lvalue_reference<IthType<I, Types...>>::value,
                  IthType<I, Types...>&>
-ExpandEventArgs(std::tuple<Types...>& tuple) {
-  return std::get<I>(tuple);
+ExpandEventArgs(std::tuple<EventArg<Types>...>& tuple) {
+  return std::get<I>(tuple).value;
 }
 
 // Return a rvalue reference for rvalue reference elements.
 template <size_t I, typename... Types>
 std::enable_if_t<std::is_rvalue_reference<IthType<I, Types...>>::value,
                  IthType<I, Types...>&&>
-ExpandEventArgs(std::tuple<Types...>& tuple) {
-  return std::move(std::get<I>(tuple));
+ExpandEventArgs(std::tuple<EventArg<Types>...>& tuple) {
+  return std::move(std::get<I>(tuple).value);
+}
+
+// Return a const reference to the object of shared event arguments.
+template <size_t I, typename... Types>
+std::enable_if_t<IsSharedEventArg<IthType<I, Types...>>::value,
+                 const typename IthType<I, Types...>::Type&>
+ExpandEventArgs(const std::tuple<EventArg<Types>...>& tuple) {
+  return *std::get<I>(tuple).value.ptr;
 }
 
-// Copy non-reference types if they are copy constructible.
+// Pass a const reference to non-reference types if they are copy
+// constructible.
 template <size_t I, typename... Types>
 std::enable_if_t<!std::is_reference<IthType<I, Types...>>::value &&
+                 !IsSharedEventArg<IthType<I, Types...>>::value &&
                  std::is_copy_constructible<IthType<I, Types...>>::value,
-                 IthType<I, Types...>>
-ExpandEventArgs(const std::tuple<Types...>& tuple) {
-  return std::get<I>(tuple);
+                 const IthType<I, Types...>&>
+ExpandEventArgs(const std::tuple<EventArg<Types>...>& tuple) {
+  return std::get<I>(tuple).value;
 }
 
 // Move non-reference types if they are not copy constructible.
@@ -78,10 +97,58 @@ template <size_t I, typename... Types>
 std::enable_if_t<!std::is_reference<IthType<I, Types...>>::value &&
                  !std::is_copy_constructible<IthType<I, Types...>>::value,
                  IthType<I, Types...>&&>
-ExpandEventArgs(std::tuple<Types...>& tuple) {
+ExpandEventArgs(std::tuple<EventArg<Types>...>& tuple) {
   static_assert(std::is_move_constructible<IthType<I, Types...>>::value,
                 "Type is not copy or move constructible.");
-  return std::move(std::get<I>(tuple));
+  return std::move(std::get<I>(tuple).value);
 }
 
+// Return a lvalue reference for lvalue reference elements in the last callback.
+template <size_t I, typename... Types>
+std::enable_if_t<std::is_lvalue_reference<IthType<I, Types...>>::value,
+                 IthType<I, Types...>&>
+ExpandLastEventArgs(std::tuple<EventArg<Types>...>& tuple) {
+  return std::get<I>(tuple).value;
+}
+
+// Shared event arguments are never moved, not even into the last callback.
+template <size_t I, typename... Types>
+std::enable_if_t<IsSharedEventArg<IthType<I, Types...>>::value,
+                 const typename IthType<I, Types...>::Type&>
+ExpandLastEventArgs(std::tuple<EventArg<Types>...>& tuple) {
+  return *std::get<I>(tuple).value.ptr;
+}
+
+// Move any other elements into the last callback.
+template <size_t I, typename... Types>
+std::enable_if_t<!std::is_lvalue_reference<IthType<I, Types...>>::value &&
+                 !IsSharedEventArg<IthType<I, Types...>>::value,
+                 IthType<I, Types...>&&>
+ExpandLastEventArgs(std::tuple<EventArg<Types>...>& tuple) {
+  static_assert(std::is_move_constructible<IthType<I, Types...>>::value,
+                "Type is not copy or move constructible.");
+  return std::move(std::get<I>(tuple).value);
+}
+
+// Checks if an argument type is never moved by ExpandEventArgs, so that it can
+// be shared by callbacks running concurrently.
+template <typename T>
+struct IsShareableEventArg
+    : std::integral_constant<bool,
+                             std::is_lvalue_reference<T>::value ||
+                             (!std::is_reference<T>::value &&
+                              std::is_copy_constructible<T>::value)> {};
+
+// Checks if all the types of a tuple are shareable event arguments.
+template <typename Tuple>
+struct AreShareableEventArgs;
+
+template <typename... Types>
+struct AreShareableEventArgs<std::tuple<Types...>>
+    : std::is_same<
+          std::integer_sequence<bool, true,
+                                IsShareableEventArg<Types>::value...>,
+          std::integer_sequence<bool, IsShareableEventArg<Types>::value...,
+                                true>> {};
+
 #endif  // MAGIC_FUNC_EXAMPLES_GENERIC_EVENT_QUEUE_EVENT_TUPLE_EXTRACTOR_H_
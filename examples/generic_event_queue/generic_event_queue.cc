@@ -27,128 +27,284 @@
 // ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 
+#include <algorithm>
+#include <memory>
+
 #include <magic_func/error.h>
 
 #include "generic_event_queue.h"
 
-GenericEventQueue::GenericEventQueue()
+template <typename Lock>
+void BasicGenericEventQueue<Lock>::ListenerHook::Unlink() {
+  if (!queue_)
+    return;
+
+  std::lock_guard<Lock> lock(queue_->lock_);
+  queue_->UnlinkHook(this);
+}
+
+template <typename Lock>
+BasicGenericEventQueue<Lock>::BasicGenericEventQueue()
     : last_id_(0),
       current_dispatch_event_(nullptr),
+      dispatch_cursor_{nullptr, nullptr, nullptr, nullptr},
+      parallel_dispatch_{nullptr, 0, {}},
       listeners_removed_during_dispatch_(false) {}
 
-GenericEventQueue::ListenerId GenericEventQueue::AddEventListener(
+template <typename Lock>
+BasicGenericEventQueue<Lock>::~BasicGenericEventQueue() {
+  // Detach any hooks still linked so that they don't try to unlink themselves
+  // from a destroyed queue, and delete the ones owned by the queue.
+  for (auto& entry : listener_map_) {
+    ListenerHook* hook = entry.second.first;
+    while (hook) {
+      ListenerHook* next = hook->next_;
+      hook->prev_ = nullptr;
+      hook->next_ = nullptr;
+      hook->queue_ = nullptr;
+      hook->list_ = nullptr;
+      if (hook->owned_)
+        delete hook;
+      hook = next;
+    }
+  }
+}
+
+template <typename Lock>
+typename BasicGenericEventQueue<Lock>::ListenerId
+BasicGenericEventQueue<Lock>::AddEventListener(
     void* event,
     mf::TypeErasedFunction&& listener) {
   if (!event || !listener)
     return 0;
 
-  // Add a listener list for this event if there isn't one already.
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  // Listeners added by id are stored in hooks owned by the queue.
+  std::unique_ptr<ListenerHook> hook(new ListenerHook);
+  hook->function_ = std::move(listener);
+  hook->owned_ = true;
+
+  std::lock_guard<Lock> lock(lock_);
   ListenerId id = ++last_id_;
-  ListenerList& listener_list = listener_map_[event];
+  hook->id_ = id;
+  LinkHook(event, hook.get());
+  hook.release();
+  return id;
+}
 
-  // Check if existing listeners have the same type id as the listener function
-  // we're setting. This is to detect possible errors caused by some compiler
-  // optimizations that merge multiple functions of different types into the
-  // same function address when they do the same (for example, are empty).
-  if (!listener_list.empty()) {
-    MAGIC_FUNC_CHECK(
-        listener.type_id() == listener_list.front().second.type_id(),
-        mf::Error::kIncompatibleType);
-  }
+template <typename Lock>
+bool BasicGenericEventQueue<Lock>::AddEventListener(
+    void* event,
+    ListenerHook& hook,
+    mf::TypeErasedFunction&& listener) {
+  if (!event || !listener || hook.linked())
+    return false;
 
-  listener_list.emplace_back(std::make_pair(id, std::move(listener)));
-  return id;
+  // The hook is not visible to the queue until linked.
+  hook.function_ = std::move(listener);
+
+  std::lock_guard<Lock> lock(lock_);
+  LinkHook(event, &hook);
+  return true;
 }
 
-bool GenericEventQueue::RemoveEventListener(void* event, ListenerId id) {
+template <typename Lock>
+bool BasicGenericEventQueue<Lock>::RemoveEventListener(void* event,
+                                                       ListenerId id) {
   if (!event || id == 0)
     return false;
 
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  std::lock_guard<Lock> lock(lock_);
   auto event_it = listener_map_.find(event);
   if (event_it == listener_map_.end())
     return false;
 
-  ListenerList& listener_list = event_it->second;
-  auto it = std::find_if(
-      listener_list.begin(), listener_list.end(),
-      [id](const Listener& listener) {
-        return listener.first == id;
-      });
+  ListenerHook* hook = event_it->second.first;
+  while (hook && (!hook->owned_ || hook->id_ != id))
+    hook = hook->next_;
 
-  if (it == listener_list.end())
+  if (!hook)
     return false;
 
   // Check if this is being removed from a dispatch for the same event.
   if (current_dispatch_event_ == event) {
     // If so, just mark the id as null. It will be deleted later.
-    it->first = 0;
+    hook->id_ = 0;
     listeners_removed_during_dispatch_ = true;
   } else {
     // Otherwise just delete the listener.
-    listener_list.erase(it);
-    if (listener_list.empty())
-      listener_map_.erase(event_it);
+    UnlinkHook(hook);
   }
 
   return true;
 }
 
-size_t GenericEventQueue::CountListeners(void* event) {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
+template <typename Lock>
+size_t BasicGenericEventQueue<Lock>::CountListeners(void* event) {
+  std::lock_guard<Lock> lock(lock_);
   auto it = listener_map_.find(event);
-  return it == listener_map_.end() ? 0 : it->second.size();
+  return it == listener_map_.end() ? 0 : it->second.size;
+}
+
+template <typename Lock>
+void BasicGenericEventQueue<Lock>::SetParallelDispatch(void* event,
+                                                       WorkerPool* pool,
+                                                       size_t chunk_size) {
+  if (!event)
+    return;
+
+  std::lock_guard<Lock> lock(lock_);
+  ListenerList& listener_list = listener_map_[event];
+  listener_list.event = event;
+  listener_list.pool = pool;
+  listener_list.chunk_size = chunk_size;
+  EraseListenerListIfUnused(listener_list);
+}
+
+template <typename Lock>
+void BasicGenericEventQueue<Lock>::LinkHook(void* event, ListenerHook* hook) {
+  ListenerList& listener_list = listener_map_[event];
+  listener_list.event = event;
+
+  // Check if existing listeners have the same type id as the listener function
+  // we're setting. This is to detect possible errors caused by some compiler
+  // optimizations that merge multiple functions of different types into the
+  // same function address when they do the same (for example, are empty).
+  if (listener_list.first) {
+    MAGIC_FUNC_CHECK(
+        hook->function_.type_id() == listener_list.first->function_.type_id(),
+        mf::Error::kIncompatibleType);
+  }
+
+  hook->prev_ = listener_list.last;
+  hook->next_ = nullptr;
+  hook->queue_ = this;
+  hook->list_ = &listener_list;
+  if (listener_list.last)
+    listener_list.last->next_ = hook;
+  else
+    listener_list.first = hook;
+  listener_list.last = hook;
+  ++listener_list.size;
+}
+
+template <typename Lock>
+void BasicGenericEventQueue<Lock>::UnlinkHook(ListenerHook* hook) {
+  // Hooks can be unlinked by listeners of the event being dispatched, so make
+  // sure the dispatch cursor skips them. The cursor is null outside dispatch.
+  DispatchCursor& cursor = dispatch_cursor_;
+  if (cursor.next == hook)
+    cursor.next = hook == cursor.last ? nullptr : hook->next_;
+  if (cursor.last == hook)
+    cursor.last = hook->prev_;
+
+  // Unordered map elements are never moved, and lists are only removed from
+  // the map when empty, so the hook can keep a pointer to its list.
+  ListenerList& listener_list = *hook->list_;
+  if (hook->prev_)
+    hook->prev_->next_ = hook->next_;
+  else
+    listener_list.first = hook->next_;
+  if (hook->next_)
+    hook->next_->prev_ = hook->prev_;
+  else
+    listener_list.last = hook->prev_;
+  --listener_list.size;
+
+  hook->prev_ = nullptr;
+  hook->next_ = nullptr;
+  hook->queue_ = nullptr;
+  hook->list_ = nullptr;
+  if (hook->owned_)
+    delete hook;
+
+  EraseListenerListIfUnused(listener_list);
 }
 
-bool GenericEventQueue::Dispatch() {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
+template <typename Lock>
+void BasicGenericEventQueue<Lock>::EraseListenerListIfUnused(
+    ListenerList& listener_list) {
+  // Dispatch holds a reference to the list of the event being dispatched.
+  if (listener_list.first || listener_list.pool ||
+      listener_list.event == current_dispatch_event_) {
+    return;
+  }
+
+  listener_map_.erase(listener_list.event);
+}
+
+template <typename Lock>
+bool BasicGenericEventQueue<Lock>::Dispatch() {
+  std::lock_guard<Lock> lock(lock_);
   // Abort dispatch calls if we already are within a dispatch.
   if (current_dispatch_event_ != nullptr)
     return false;
 
+  MAGIC_FUNC_PROBE1(dispatch_begin, event_queue_.size());
+
   // Process any enqueued events. Note that events added during a dispatch are
   // stored in a separate list and added back at the end.
-  for (auto event_it = event_queue_.begin(); event_it != event_queue_.end(); ) {
-    auto listener_list_it = listener_map_.find(event_it->first);
-    if (listener_list_it == listener_map_.end()) {
-      ++event_it;
+  for (auto event_it = event_queue_.begin(); event_it != event_queue_.end();
+       ++event_it) {
+    // Skip cancelled events. Either way, the slot is released before invoking
+    // any listeners so the event can no longer be cancelled.
+    bool cancelled = slots_[event_it->slot].cancelled;
+    ReleaseSlot(event_it->slot);
+    if (cancelled)
+      continue;
+
+    auto listener_list_it = listener_map_.find(event_it->function);
+    if (listener_list_it == listener_map_.end() ||
+        !listener_list_it->second.first) {
       continue;
     }
 
     // Reset the information for the current event dispatch.
     // Used to handle listeners removed during dispatched events.
-    current_dispatch_event_ = event_it->first;
+    current_dispatch_event_ = event_it->function;
     listeners_removed_during_dispatch_ = false;
 
-    // Process only to the last listener available when starting to dispatch
-    // the current event.
+    // Invoke all the listeners of the event with a single call to its payload,
+    // which loops over them without undoing the type erasure every time.
     auto& listener_list = listener_list_it->second;
-    auto last_listener = listener_list.end();
-    for (auto listener_it = listener_list.begin();
-         listener_it != last_listener; ++listener_it) {
-      event_it->second(listener_it->second);
+    if (listener_list.pool && listener_list.size > listener_list.chunk_size) {
+      // Take a snapshot of the listeners so they can be split in chunks.
+      // Listeners running in parallel cannot modify the list.
+      parallel_dispatch_.pool = listener_list.pool;
+      parallel_dispatch_.chunk_size = listener_list.chunk_size;
+      parallel_dispatch_.listeners.clear();
+      for (ListenerHook* hook = listener_list.first; hook; hook = hook->next_)
+        parallel_dispatch_.listeners.push_back(&hook->function_);
+      dispatch_cursor_ = DispatchCursor{event_it->function, nullptr, nullptr,
+                                        &parallel_dispatch_};
+    } else {
+      dispatch_cursor_ = DispatchCursor{
+          event_it->function, listener_list.first, listener_list.last, nullptr};
     }
 
+    event_it->payload(dispatch_cursor_);
+    dispatch_cursor_ = DispatchCursor{nullptr, nullptr, nullptr, nullptr};
+
     // Clean up any listeners with null ids.
     // These were removed during dispatch of events of the current type.
     if (listeners_removed_during_dispatch_) {
       listeners_removed_during_dispatch_ = false;
-      listener_list.remove_if([](const Listener& listener) {
-        return listener.first == 0;
-      });
+      for (ListenerHook* hook = listener_list.first; hook;) {
+        ListenerHook* next = hook->next_;
+        if (hook->owned_ && hook->id_ == 0)
+          UnlinkHook(hook);
+        hook = next;
+      }
     }
 
-    // Advance to the next event.
-    ++event_it;
-    event_queue_.pop_front();
-
-    // The end iterator of a deque might be invalidated after removing the last
-    // element on it. This is required to fix a debug error in MSVC.
-    if (event_queue_.empty())
-      break;
+    // Remove the list if the dispatch left it empty.
+    if (!listener_list.first && !listener_list.pool)
+      listener_map_.erase(event_it->function);
   }
 
+  // All events have been processed, including those without listeners.
+  MAGIC_FUNC_PROBE1(dispatch_end, event_queue_.size());
+  event_queue_.clear();
+
   // Move any events enqueued during dispatch to the event queue.
   for (auto& event : events_enqueued_during_dispatch_)
     event_queue_.emplace_back(std::move(event));
@@ -158,3 +314,113 @@ bool GenericEventQueue::Dispatch() {
   return true;
 }
 
+template <typename Lock>
+void BasicGenericEventQueue<Lock>::Reserve(size_t num_events) {
+  std::lock_guard<Lock> lock(lock_);
+  event_queue_.reserve(num_events);
+  slots_.reserve(num_events);
+  free_slots_.reserve(num_events);
+}
+
+template <typename Lock>
+typename BasicGenericEventQueue<Lock>::EventHandle
+BasicGenericEventQueue<Lock>::EnqueuePayload(void* event, Payload&& payload) {
+  std::lock_guard<Lock> lock(lock_);
+  EventHandle handle = AllocateSlot();
+
+  // Inserting the event into the queue during a dispatch invalidates
+  // all iterators. In that case we add them when dispatch finishes.
+  auto& queue = current_dispatch_event_ ?
+      events_enqueued_during_dispatch_ : event_queue_;
+  MAGIC_FUNC_PROBE2(enqueue, event, event_queue_.size() +
+                    events_enqueued_during_dispatch_.size());
+  queue.push_back(Event{event, handle.slot, std::move(payload)});
+  return handle;
+}
+
+template <typename Lock>
+void BasicGenericEventQueue<Lock>::EnqueueBatch(
+    EventBatch& batch,
+    std::vector<EventHandle>* handles) {
+  size_t num_events = batch.events_.size();
+  if (num_events == 0)
+    return;
+
+  if (handles)
+    handles->reserve(handles->size() + num_events);
+
+  {
+    std::lock_guard<Lock> lock(lock_);
+    auto& queue = current_dispatch_event_ ?
+        events_enqueued_during_dispatch_ : event_queue_;
+
+    // Reserve all the storage at once, but keep growing it geometrically so
+    // that many small batches don't reallocate every time.
+    size_t size = queue.size() + num_events;
+    if (size > queue.capacity())
+      queue.reserve(std::max(size, 2 * queue.capacity()));
+    size = slots_.size() +
+        (num_events > free_slots_.size() ? num_events - free_slots_.size() : 0);
+    if (size > slots_.capacity())
+      slots_.reserve(std::max(size, 2 * slots_.capacity()));
+
+    for (auto& event : batch.events_) {
+      EventHandle handle = AllocateSlot();
+      MAGIC_FUNC_PROBE2(enqueue, event.function, event_queue_.size() +
+                        events_enqueued_during_dispatch_.size());
+      queue.push_back(
+          Event{event.function, handle.slot, std::move(event.payload)});
+      if (handles)
+        handles->push_back(handle);
+    }
+  }
+
+  // Only empty payloads are left in the batch.
+  batch.events_.clear();
+}
+
+template <typename Lock>
+bool BasicGenericEventQueue<Lock>::Cancel(EventHandle handle) {
+  std::lock_guard<Lock> lock(lock_);
+  if (handle.generation == 0 || handle.slot >= slots_.size())
+    return false;
+
+  Slot& slot = slots_[handle.slot];
+  if (slot.generation != handle.generation || slot.cancelled)
+    return false;
+
+  slot.cancelled = true;
+  return true;
+}
+
+template <typename Lock>
+typename BasicGenericEventQueue<Lock>::EventHandle
+BasicGenericEventQueue<Lock>::AllocateSlot() {
+  EventHandle handle;
+  if (free_slots_.empty()) {
+    handle.slot = static_cast<uint32_t>(slots_.size());
+    slots_.push_back(Slot{1, false});
+  } else {
+    handle.slot = free_slots_.back();
+    free_slots_.pop_back();
+  }
+
+  handle.generation = slots_[handle.slot].generation;
+  return handle;
+}
+
+template <typename Lock>
+void BasicGenericEventQueue<Lock>::ReleaseSlot(uint32_t slot) {
+  // Generation 0 is reserved for invalid handles.
+  Slot& released = slots_[slot];
+  if (++released.generation == 0)
+    released.generation = 1;
+  released.cancelled = false;
+  free_slots_.push_back(slot);
+}
+
+// Explicit instantiations for the supported lock policies.
+template class BasicGenericEventQueue<NoLock>;
+template class BasicGenericEventQueue<SpinLock>;
+template class BasicGenericEventQueue<std::mutex>;
+template class BasicGenericEventQueue<std::recursive_mutex>;
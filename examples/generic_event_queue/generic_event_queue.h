@@ -30,20 +30,24 @@
 #ifndef MAGIC_FUNC_EXAMPLES_GENERIC_EVENT_QUEUE_GENERIC_EVENT_QUEUE_H_
 #define MAGIC_FUNC_EXAMPLES_GENERIC_EVENT_QUEUE_GENERIC_EVENT_QUEUE_H_
 
-#include <algorithm>
-#include <deque>
-#include <list>
+#include <cstdint>
+#include <iterator>
 #include <mutex>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include <magic_func/function.h>
 #include <magic_func/function_cast.h>
 #include <magic_func/function_traits.h>
+#include <magic_func/probes.h>
 
 #include "cpp14_helpers.h"
+#include "event_args.h"
 #include "event_tuple_extractor.h"
+#include "lock_policies.h"
 #include "selective_decay.h"
+#include "worker_pool.h"
 
 // A versatile, simple to use, thread-safe general purpose event queue with
 // support for broadcast and observer patterns.
@@ -89,22 +93,126 @@
 //   return 0;
 // }
 // @endcode
-class GenericEventQueue {
+//
+// The synchronization used by the queue is defined by its lock policy, which
+// can be any of the following:
+// - std::recursive_mutex: the default, used by GenericEventQueue. Thread-safe
+//   and allows listeners to use the queue during dispatch.
+// - std::mutex or SpinLock: thread-safe, but listeners must not call any
+//   methods of the queue as that would deadlock.
+// - NoLock: no synchronization at all. The queue must be used from a single
+//   thread, but listeners can use it during dispatch.
+//
+// For example, a queue only used from a single-threaded main loop would be:
+// BasicGenericEventQueue<NoLock> event_queue;
+//
+// When built with MAGIC_FUNC_ENABLE_PROBES, the queue defines the following
+// USDT probes under the magic_func provider (see <magic_func/probes.h>):
+// - enqueue(event, depth): an event is enqueued. Provides the address of the
+//   event function and the number of events in the queue before it. During a
+//   dispatch, this includes the events of the dispatch and those enqueued
+//   while it runs.
+// - dispatch_begin(depth): a dispatch starts with this many enqueued events.
+// - dispatch_end(num_events): a dispatch ends after this many events.
+// - listener_invoke(event, listener): a listener is about to be called.
+//   Provides the event function address and the listener function object.
+template <typename Lock>
+class BasicGenericEventQueue {
+  // Intrusive list of the listeners of an event function, defined below.
+  struct ListenerList;
+
  public:
   // Type used to identify registered event listener.
   using ListenerId = int;
 
+  // Lightweight handle to an enqueued event, used to cancel it.
+  //
+  // Refers to a slot in the queue storage and the generation of that slot when
+  // the event was enqueued. Slots are reused after their events are dispatched
+  // or cancelled, which invalidates any previous handles to them.
+  // Default-constructed handles are always invalid.
+  struct EventHandle {
+    uint32_t slot = 0;
+    uint32_t generation = 0;
+  };
+
   // Auxiliary alias to get the underlying function type corresponding to a
   // function pointer or member function pointer.
   template <typename FuncPtr>
   using FunctionType = typename mf::FunctionTraits<FuncPtr>::FunctionType;
 
-  GenericEventQueue();
-  GenericEventQueue(const GenericEventQueue&) = delete;
-  GenericEventQueue(GenericEventQueue&&) = delete;
+  // The lock policy type of the queue.
+  using LockType = Lock;
+
+  // Intrusive listener that subscribers can embed in their own objects.
+  //
+  // Holds the listener function together with the links of the listener list,
+  // so registering and unregistering it never allocates memory once the queue
+  // has seen its event function. This is meant for subscribers that come and
+  // go frequently, such as objects created and destroyed every frame.
+  //
+  // Hooks unlink themselves when destroyed, including from listeners during a
+  // dispatch. Unlike listeners removed by id, an unlinked hook is never called
+  // again, not even for the event being dispatched. Hooks can be linked again
+  // after being unlinked, but not moved or copied.
+  //
+  // Example:
+  // class Player {
+  //  public:
+  //   explicit Player(GenericEventQueue& event_queue) {
+  //     event_queue.AddEventListener(
+  //         &KeyboardEvent::OnKeyDown, key_down_hook_,
+  //         mf::Function<void(int)>::FromMemberFunction<&Player::OnKeyDown>(
+  //             this));
+  //   }
+  //
+  //  private:
+  //   void OnKeyDown(int code);
+  //
+  //   // Unlinked from the queue when the player is destroyed.
+  //   GenericEventQueue::ListenerHook key_down_hook_;
+  // };
+  class ListenerHook {
+   public:
+    ListenerHook() = default;
+    ListenerHook(const ListenerHook&) = delete;
+    ListenerHook& operator =(const ListenerHook&) = delete;
+
+    ~ListenerHook() { Unlink(); }
+
+    // Removes the listener from its queue, if any. Unlike other methods of the
+    // queue, this must not be called concurrently with the destruction of the
+    // queue or with other methods of the same hook.
+    void Unlink();
+
+    // Returns true if the hook is currently registered in a queue.
+    bool linked() const { return queue_ != nullptr; }
+
+   private:
+    friend class BasicGenericEventQueue;
+
+    ListenerHook* prev_ = nullptr;
+    ListenerHook* next_ = nullptr;
+    BasicGenericEventQueue* queue_ = nullptr;
+    ListenerList* list_ = nullptr;
+
+    // Non-zero for listeners added by id, which are owned by the queue.
+    // Set to zero when those are removed during the dispatch of their event.
+    ListenerId id_ = 0;
+    bool owned_ = false;
+
+    mf::TypeErasedFunction function_;
+  };
+
+  BasicGenericEventQueue();
+  BasicGenericEventQueue(const BasicGenericEventQueue&) = delete;
+  BasicGenericEventQueue(BasicGenericEventQueue&&) = delete;
+
+  // Unlinks any remaining listener hooks.
+  ~BasicGenericEventQueue();
 
-  GenericEventQueue& operator =(const GenericEventQueue&) = delete;
-  GenericEventQueue& operator =(GenericEventQueue&&) = delete;
+  BasicGenericEventQueue& operator =(const BasicGenericEventQueue&) = delete;
+  BasicGenericEventQueue& operator =(BasicGenericEventQueue&&) = delete;
 
   // Adds a listener for an event function.
   //
@@ -120,6 +228,26 @@ class GenericEventQueue {
                             std::move(listener));
   }
 
+  // Adds a listener for an event function using an intrusive hook.
+  //
+  // Does not allocate any memory, except the first time a listener is added
+  // for the event function. The listener is removed when the hook is unlinked
+  // or destroyed, whichever happens first.
+  //
+  // @param event The event function to listener to.
+  // @param hook The unlinked hook to store the listener in. Must outlive its
+  //             registration in the queue.
+  // @param listener The function to call when an event for the provided
+  //                 function is dispatched.
+  // @return true if added, false in case of invalid arguments or if the hook
+  //         is already linked.
+  template <typename FuncPtr>
+  bool AddEventListener(FuncPtr event, ListenerHook& hook,
+                        mf::Function<FunctionType<FuncPtr>> listener) {
+    return AddEventListener(reinterpret_cast<void*>(event), hook,
+                            std::move(listener));
+  }
+
   // Removes a previously added listener for an event function.
   //
   // @param event The event function to remove the listener from.
@@ -148,89 +276,172 @@ class GenericEventQueue {
   // Unless otherwise specified arguments will be copied by default. In order
   // to pass lvalue references (e.g. int&) std::ref() must be explicitly used.
   //
-  // In C++11 all provided arguments must either be copy constructible or
-  // reference wrappers (use of std::ref()). If C++14 support is enabled, it is
-  // also possible to move objects that are not copy-constructible and to pass
+  // Arguments are constructed in place in the queue storage, so it is also
+  // possible to move objects that are not copy-constructible and to pass
   // rvalue reference types (e.g., int&&). These will be moved instead of copied
   // when dispatching the event.
   //
-  // This method is thread-safe, but it can block if another thread is calling
-  // Dispatch(). It should be possible to implement lock-free event queues that
-  // allow this method to not block during Dispatch calls, but that is out of
-  // the scope of this example.
+  // This method is thread-safe unless the NoLock policy is used, but it can
+  // block if another thread is calling Dispatch(). It should be possible to
+  // implement lock-free event queues that allow this method to not block during
+  // Dispatch calls, but that is out of the scope of this example.
   //
   // @param event The event function to enqueue for.
   // @param args Any arguments to pass to the event function.
+  // @return A handle that can be used to cancel the event before dispatch.
+  //         Can be safely ignored.
   template <typename FuncPtr, typename... Args_>
-  void Enqueue(FuncPtr event, Args_&&... args) {
-    // Apply the selective decay operation described above depending on whether
-    // std::ref was used or not and store the result in a tuple. In particular,
-    // this does two things:
-    //
-    // 1. Enforces the conversion of any arguments into the types expected
-    //    by the function, applying decay to store them.
-    //
-    //    For example, passing a char* to a function expecting a const
-    //    std::string& will create and store a std::string object when enqueuing
-    //    rather than copying the pointer and creating the string when the
-    //    event is dispatched. This ensures the received string contents will
-    //    match the ones at enqueue time.
-    //
-    // 2. Any argument passed using std::ref() will be also converted but not
-    //    decayed. This is done to allow explicit references to behave as such,
-    //    where the caller is responsible to ensure their validity between
-    //    enqueuing and dispatching.
-    //
-    //    For example, in order to pass a Foo object named foo to a function
-    //    expecting a Foo& argument, std::ref(foo) must be used or foo will be
-    //    copied instead. If foo is destroyed before the event is dispatched
-    //    behavior is undefined.
-    //
+  EventHandle Enqueue(FuncPtr event, Args_&&... args) {
+    return EnqueuePayload(reinterpret_cast<void*>(event),
+                          MakePayload<FuncPtr>(std::forward<Args_>(args)...));
+  }
+
+  // Enqueues an event constructing its arguments in place.
+  //
+  // Behaves like Enqueue, but each argument of the event function is
+  // constructed in place from a tuple of constructor arguments, as with the
+  // piecewise constructor of std::pair. Arguments are stored decayed, so
+  // references are not supported. Use Enqueue with std::ref() for those.
+  //
+  // Example:
+  // struct Events {
+  //   static void OnMessage(int id, const std::string& text) {}
+  // };
+  //
+  // // Enqueues OnMessage(1, std::string(1024, 'x')) without creating any
+  // // temporary strings.
+  // event_queue.EmplaceEnqueue(&Events::OnMessage,
+  //                            std::forward_as_tuple(1),
+  //                            std::forward_as_tuple(1024, 'x'));
+  //
+  // @param event The event function to enqueue for.
+  // @param arg_tuples A tuple of constructor arguments for each argument of the
+  //                   event function, such as those from std::forward_as_tuple.
+  // @return A handle that can be used to cancel the event before dispatch.
+  //         Can be safely ignored.
+  template <typename FuncPtr, typename... ArgTuples>
+  EventHandle EmplaceEnqueue(FuncPtr event, ArgTuples&&... arg_tuples) {
     using ArgsTuple = typename mf::FunctionTraits<FuncPtr>::Args;
-    static_assert(sizeof...(Args_) == std::tuple_size<ArgsTuple>::value,
+    static_assert(sizeof...(ArgTuples) == std::tuple_size<ArgsTuple>::value,
                   "Invalid number of arguments for function");
 
-    using DecayedTuple = SelectiveDecay<std::tuple<Args_...>, ArgsTuple>;
-    DecayedTuple args_tuple(std::forward<Args_>(args)...);
-
-    // Enqueue a lambda that undoes type erasure and invokes the function.
-    // In C++11 the arguments tuple is copied. In C++14 is moved, so it is
-    // also possible to store move-only arguments and rvalue references.
-    std::lock_guard<std::recursive_mutex> lock(mutex_);
-    auto event_pair = std::make_pair(
+    using DecayedTuple =
+        typename mf::FunctionTraits<FuncPtr>::template FilteredArgs<
+            std::decay_t>;
+    return EnqueuePayload(
         reinterpret_cast<void*>(event),
-#if __cplusplus < 201402L && (!defined(_MSC_VER) || _MSC_VER < 1900)
-        // In C++11 we copy the argument tuple after conversion.
-        [args_tuple]
-#else
-        // In C++14 we use generalize lambda captures to move the tuple.
-        // This allows passing non-copyable objects and rvalue references.
-        [args_tuple = std::move(args_tuple)]
-#endif
-        (mf::TypeErasedFunction& type_erased) mutable {
-          // Undo the type erasure and invoke the function with our tuple.
-          // This will raise a MagicFunc fatal runtime error if the function
-          // type does not match, which should never be the case.
-          auto& f = mf::function_cast<FunctionType<FuncPtr>>(type_erased);
-          Invoke(f, args_tuple, std::index_sequence_for<Args_...>());
-        });
-
-    // Inserting the event into the queue during a dispatch invalidates
-    // all iterators. In that case we add them when dispatch finishes.
-    if (current_dispatch_event_)
-      events_enqueued_during_dispatch_.emplace_back(std::move(event_pair));
-    else
-      event_queue_.emplace_back(std::move(event_pair));
+        Payload(mf::InPlaceType<EventPayload<FuncPtr, DecayedTuple>>(),
+                PiecewiseArgs<ArgTuples>{&arg_tuples}...));
+  }
+
+  // Builder of batches of events, possibly of different event functions.
+  class EventBatch;
+
+  // Enqueues all the events of a batch at once.
+  //
+  // Takes the lock of the queue and reserves its storage only once. All the
+  // events of the batch become visible to Dispatch at the same time, in the
+  // same order they were added to the batch. The batch is left empty and can
+  // be reused to build further batches without reallocating its storage.
+  //
+  // @param batch The batch of events to enqueue.
+  // @param handles Optional vector where to append a handle for each event,
+  //                in the same order. Can be used to cancel them.
+  void EnqueueBatch(EventBatch& batch,
+                    std::vector<EventHandle>* handles = nullptr);
+
+  // Enqueues a batch of events of the same event function.
+  //
+  // Behaves like enqueuing each element of a range with Enqueue, but takes the
+  // lock of the queue only once as with EventBatch.
+  //
+  // Example:
+  // std::vector<std::tuple<int, std::string>> messages = ...;
+  // event_queue.EnqueueBatch(&Events::OnMessage, messages);
+  //
+  // @param event The event function to enqueue for.
+  // @param arg_tuples A range of tuples or pairs with the arguments of each
+  //                   event. These are copied as when passed to Enqueue.
+  template <typename FuncPtr, typename Range>
+  void EnqueueBatch(FuncPtr event, const Range& arg_tuples) {
+    EventBatch batch;
+    batch.Reserve(static_cast<size_t>(
+        std::distance(std::begin(arg_tuples), std::end(arg_tuples))));
+    for (const auto& args : arg_tuples) {
+      batch.AddTuple(event, args,
+                     std::make_index_sequence<std::tuple_size<
+                         std::decay_t<decltype(args)>>::value>());
+    }
+    EnqueueBatch(batch);
+  }
+
+  // Sets whether the listeners of an event function are dispatched in parallel.
+  //
+  // Events with more than chunk_size listeners have them split in chunks that
+  // are run by the worker pool and the dispatching thread, which waits for all
+  // of them before dispatching the next event. Listeners of other events are
+  // still called one by one in registration order.
+  //
+  // Listeners called in parallel share the same read-only event arguments and
+  // run in no particular order. Arguments taken by value are copied for every
+  // listener. Events with arguments that would be moved, such as rvalue
+  // references or non-copyable values, cannot be dispatched in parallel.
+  //
+  // The queue stays locked while listeners run in parallel, so they must not
+  // call any methods of the queue or unlink any of its listener hooks.
+  //
+  // @param event The event function to set the dispatch policy for.
+  // @param pool The worker pool to use, or null to dispatch serially. Must
+  //             outlive its use by the queue.
+  // @param chunk_size The number of listeners called by each parallel task.
+  template <typename FuncPtr>
+  void SetParallelDispatch(FuncPtr event, WorkerPool* pool,
+                           size_t chunk_size) {
+    static_assert(
+        AreShareableEventArgs<
+            typename mf::FunctionTraits<FuncPtr>::Args>::value,
+        "Parallel dispatch requires arguments that are not moved");
+    SetParallelDispatch(reinterpret_cast<void*>(event), pool, chunk_size);
   }
 
+  // Reserves space for a number of events in the queue.
+  //
+  // Enqueuing events never reallocates the queue storage unless more events
+  // than the reserved number are pending. Storage is kept between dispatches.
+  //
+  // @param num_events The number of pending events to reserve space for.
+  void Reserve(size_t num_events);
+
+  // Cancels an enqueued event so that it is never dispatched.
+  //
+  // Takes constant time. The event is only marked as cancelled and skipped
+  // when dispatching, where its arguments are released. Events cannot be
+  // cancelled once their dispatch has started.
+  //
+  // @param handle The handle returned when enqueuing the event.
+  // @return true if cancelled, false if the event was already dispatched or
+  //         cancelled, or the handle is invalid.
+  bool Cancel(EventHandle handle);
+
   // Dispatches any enqueued events to their corresponding listeners.
   //
   // Events are dispatched synchronously from the thread performing the call,
   // and in the same relative order they were enqueued. For each event,
   // listeners are called in the same order they were registered.
   //
-  // By default arguments will be copied when invoking listeners unless one
-  // of the following happens:
+  // By default arguments are passed to listeners as const references to the
+  // objects stored during enqueue. Listeners of events taking const references
+  // (e.g. const std::string&) therefore never copy them, while those of events
+  // taking values (e.g. std::string) get their own copy, except the last one
+  // which gets the stored object moved instead.
+  //
+  // Events taking a const T& can also opt into shared immutable payloads by
+  // enqueuing a std::shared_ptr<const T> for that argument. Only the pointer
+  // is stored, and all listeners receive a reference to the same object, so
+  // it is never copied. Useful for large payloads broadcast to many listeners
+  // or enqueued in several queues.
+  //
+  // The following cases are the exception:
   // - The argument is a lvalue reference (e.g. int&) and std::ref() was used
   //   when enqueing. In this case the lvalue reference is passed.
   //
@@ -247,43 +458,325 @@ class GenericEventQueue {
   //   that the number of listeners for these events is not greater than 1.
   //
   // Dispatching is also reentrant-safe. Any events enqueued during a dispatch
-  // will run the next time Dispatch() is called. Adding and removing listeners 
+  // will run the next time Dispatch() is called. Adding and removing listeners
   // during an event dispatch becomes effective after all listeners have been
-  // called for that event (not the entire dispatch).
+  // called for that event (not the entire dispatch). The exception are listener
+  // hooks, which are never called again once unlinked.
+  //
+  // Reentrant calls from listeners are only possible with the
+  // std::recursive_mutex and NoLock lock policies.
   //
   // @return false if a dispatch is already going on on the calling thread,
   //         in which case the call will be ignored. Returns true otherwise.
   bool Dispatch();
 
  private:
-  using Event = std::pair<void*, mf::Function<void(mf::TypeErasedFunction&)>>;
-  using Listener = std::pair<ListenerId, mf::TypeErasedFunction>;
-  using ListenerList = std::list<Listener>;
+  // Intrusive list of the listeners of an event function.
+  struct ListenerList {
+    // The event function of the listeners, which is the key of the list.
+    void* event = nullptr;
+
+    ListenerHook* first = nullptr;
+    ListenerHook* last = nullptr;
+    size_t size = 0;
+
+    // Parallel dispatch policy, if any. See SetParallelDispatch.
+    WorkerPool* pool = nullptr;
+    size_t chunk_size = 0;
+  };
+
+  // Snapshot of the listeners of an event dispatched in parallel.
+  struct ParallelDispatch {
+    WorkerPool* pool;
+    size_t chunk_size;
+    std::vector<mf::TypeErasedFunction*> listeners;
+  };
+
+  // Iterates the listeners of the event being dispatched.
+  //
+  // Only visits the listeners present when the dispatch of the event started.
+  // Fixed up by the queue when a hook is unlinked during the dispatch, so it
+  // never refers to unlinked hooks.
+  struct DispatchCursor {
+    // The event function being dispatched.
+    void* event;
+
+    ListenerHook* next;
+    ListenerHook* last;
+
+    // Listeners to dispatch in parallel instead, if not null.
+    ParallelDispatch* parallel;
+
+    // Returns the function of the next listener, or null if there are none.
+    mf::TypeErasedFunction* Next() {
+      ListenerHook* hook = next;
+      if (!hook)
+        return nullptr;
+      next = hook == last ? nullptr : hook->next_;
+      return &hook->function_;
+    }
+
+    // Returns true if there are no more listeners to visit.
+    bool done() const { return next == nullptr; }
+  };
+
+  // Invokes the listeners of an event with its arguments.
+  using Payload = mf::Function<void(DispatchCursor&)>;
+
+  struct Event {
+    // The event function identifying the type of the event.
+    void* function;
+
+    // The storage slot of the event, used to support cancellation.
+    uint32_t slot;
+
+    // The arguments of the event and the code to dispatch it.
+    Payload payload;
+  };
+
+  // Callable object storing the arguments of an event, constructed in place
+  // as the payload of the event. Undoes type erasure and invokes the listeners
+  // of the event with its arguments.
+  template <typename FuncPtr, typename DecayedTuple>
+  class EventPayload;
+
+  template <typename FuncPtr, typename... Types>
+  class EventPayload<FuncPtr, std::tuple<Types...>> {
+   public:
+    template <typename... Args>
+    explicit EventPayload(Args&&... args)
+        : args_(std::forward<Args>(args)...) {}
+
+    void operator ()(DispatchCursor& cursor) {
+      if (cursor.parallel) {
+        InvokeParallel(cursor.event, *cursor.parallel);
+        return;
+      }
+
+      mf::TypeErasedFunction* function = cursor.Next();
+      if (!function)
+        return;
+
+      // Undo the type erasure once for all the listeners.
+      // This will raise a MagicFunc fatal runtime error if the function
+      // type does not match, which should never be the case. All the
+      // listeners of an event are checked to have the same type when added.
+      using TypedFunction =
+          std::remove_reference_t<decltype(mf::function_cast<FuncPtr>(
+              *function))>;
+      mf::function_cast<FuncPtr>(*function);
+
+      // Listeners added during the dispatch are not invoked. The last one
+      // can take ownership of any arguments instead of copying them.
+      for (;;) {
+        auto& f = static_cast<TypedFunction&>(*function);
+        MAGIC_FUNC_PROBE2(listener_invoke, cursor.event, function);
+        if (cursor.done()) {
+          InvokeLast(f, args_, std::index_sequence_for<Types...>());
+          return;
+        }
+
+        Invoke(f, args_, std::index_sequence_for<Types...>());
+        function = cursor.Next();
+        if (!function)
+          return;
+      }
+    }
+
+   private:
+    // Invokes chunks of listeners in parallel. No arguments are moved, as
+    // checked by SetParallelDispatch.
+    void InvokeParallel(void* event, ParallelDispatch& parallel) {
+      auto& listeners = parallel.listeners;
+      using TypedFunction =
+          std::remove_reference_t<decltype(mf::function_cast<FuncPtr>(
+              *listeners.front()))>;
+      mf::function_cast<FuncPtr>(*listeners.front());
+
+      parallel.pool->ParallelFor(
+          listeners.size(), parallel.chunk_size,
+          [this, event, &listeners](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+              auto& f = static_cast<TypedFunction&>(*listeners[i]);
+              MAGIC_FUNC_PROBE2(listener_invoke, event, listeners[i]);
+              Invoke(f, args_, std::index_sequence_for<Types...>());
+            }
+          });
+    }
+
+    std::tuple<EventArg<Types>...> args_;
+  };
+
+  // Tracks if the event of a storage slot is still pending.
+  struct Slot {
+    uint32_t generation;
+    bool cancelled;
+  };
 
   // Invokes a functor with the arguments contained in a provided tuple.
   // For details on how the arguments are passed to the functor, see Dispatch.
   template <typename F, typename... Args, size_t... Indices>
-  static std::result_of_t<F(Args...)>
-  Invoke(F& f, std::tuple<Args...>& args, std::index_sequence<Indices...>) {
+  static auto Invoke(F& f, std::tuple<EventArg<Args>...>& args,
+                     std::index_sequence<Indices...>)
+      -> decltype(f(ExpandEventArgs<Indices>(args)...)) {
     return f(ExpandEventArgs<Indices>(args)...);
   }
 
+  // Same as Invoke, but moves any arguments that are not lvalue references.
+  // Used with the last listener of an event.
+  template <typename F, typename... Args, size_t... Indices>
+  static auto InvokeLast(F& f, std::tuple<EventArg<Args>...>& args,
+                         std::index_sequence<Indices...>)
+      -> decltype(f(ExpandLastEventArgs<Indices>(args)...)) {
+    return f(ExpandLastEventArgs<Indices>(args)...);
+  }
+
+  // Creates the payload of an event with the arguments passed to Enqueue.
+  template <typename FuncPtr, typename... Args_>
+  static Payload MakePayload(Args_&&... args) {
+    // Apply a selective decay operation depending on whether std::ref was used
+    // or not and store the result in a tuple. In particular, this does two
+    // things:
+    //
+    // 1. Enforces the conversion of any arguments into the types expected
+    //    by the function, applying decay to store them.
+    //
+    //    For example, passing a char* to a function expecting a const
+    //    std::string& will create and store a std::string object when enqueuing
+    //    rather than copying the pointer and creating the string when the
+    //    event is dispatched. This ensures the received string contents will
+    //    match the ones at enqueue time.
+    //
+    // 2. Any argument passed using std::ref() will be also converted but not
+    //    decayed. This is done to allow explicit references to behave as such,
+    //    where the caller is responsible to ensure their validity between
+    //    enqueuing and dispatching.
+    //
+    //    For example, in order to pass a Foo object named foo to a function
+    //    expecting a Foo& argument, std::ref(foo) must be used or foo will be
+    //    copied instead. If foo is destroyed before the event is dispatched
+    //    behavior is undefined.
+    //
+    using ArgsTuple = typename mf::FunctionTraits<FuncPtr>::Args;
+    static_assert(sizeof...(Args_) == std::tuple_size<ArgsTuple>::value,
+                  "Invalid number of arguments for function");
+
+    // The decayed arguments are constructed directly in the heap storage of
+    // the event payload, which is then moved into the queue. Only the pointer
+    // to the payload is moved, never the arguments themselves.
+    using DecayedTuple = SelectiveDecay<std::tuple<Args_...>, ArgsTuple>;
+    return Payload(mf::InPlaceType<EventPayload<FuncPtr, DecayedTuple>>(),
+                   std::forward<Args_>(args)...);
+  }
+
+  // Adds the payload of an event to the queue.
+  EventHandle EnqueuePayload(void* event, Payload&& payload);
+
+  // Takes a free storage slot for a new event.
+  EventHandle AllocateSlot();
+
+  // Invalidates any handles to a slot and makes it available again.
+  void ReleaseSlot(uint32_t slot);
+
   // Non-template functions for listener management.
   ListenerId AddEventListener(void* event, mf::TypeErasedFunction&& listener);
+  bool AddEventListener(void* event, ListenerHook& hook,
+                        mf::TypeErasedFunction&& listener);
   bool RemoveEventListener(void* event, ListenerId id);
   size_t CountListeners(void* event);
+  void SetParallelDispatch(void* event, WorkerPool* pool, size_t chunk_size);
+
+  // Links a hook at the end of the listener list of an event function.
+  void LinkHook(void* event, ListenerHook* hook);
+
+  // Unlinks a hook from its listener list, fixing up the dispatch cursor if
+  // needed. Deletes the hook if owned by the queue. Must hold the lock.
+  void UnlinkHook(ListenerHook* hook);
+
+  // Removes a listener list from the map if it has no listeners nor a parallel
+  // dispatch policy, so the map does not grow with every event function ever
+  // listened to. Lists of the event being dispatched are kept until its
+  // dispatch ends. Must hold the lock.
+  void EraseListenerListIfUnused(ListenerList& listener_list);
 
   // This intentionally avoids using an unordered multimap because we want
   // an order relation between the multiple entries of a same key.
   std::unordered_map<void*, ListenerList> listener_map_;
-  std::deque<Event> event_queue_;
-  std::recursive_mutex mutex_;
+  std::vector<Event> event_queue_;
+  std::vector<Slot> slots_;
+  std::vector<uint32_t> free_slots_;
+  Lock lock_;
   ListenerId last_id_;
 
   // Used to avoid reentrant code issues during dispatch.
   void* current_dispatch_event_;
+  DispatchCursor dispatch_cursor_;
+  ParallelDispatch parallel_dispatch_;
   bool listeners_removed_during_dispatch_;
-  std::list<Event> events_enqueued_during_dispatch_;
+  std::vector<Event> events_enqueued_during_dispatch_;
+};
+
+// Builder of batches of events enqueued at once with EnqueueBatch.
+//
+// Example:
+// GenericEventQueue::EventBatch batch;
+// batch.Add(&KeyboardEvent::OnKeyDown, 0x20)
+//      .Add(&KeyboardEvent::OnKeyUp, 0x20);
+// event_queue.EnqueueBatch(batch);
+template <typename Lock>
+class BasicGenericEventQueue<Lock>::EventBatch {
+ public:
+  // Adds an event to the batch. Arguments are handled as in Enqueue, and
+  // constructed in the batch when added.
+  //
+  // @param event The event function to enqueue for.
+  // @param args Any arguments to pass to the event function.
+  // @return The batch, so that calls can be chained.
+  template <typename FuncPtr, typename... Args_>
+  EventBatch& Add(FuncPtr event, Args_&&... args) {
+    events_.push_back(BatchedEvent{
+        reinterpret_cast<void*>(event),
+        MakePayload<FuncPtr>(std::forward<Args_>(args)...)});
+    return *this;
+  }
+
+  // Reserves space for a number of events in the batch.
+  void Reserve(size_t num_events) { events_.reserve(num_events); }
+
+  // Removes all the events of the batch without enqueuing them.
+  void Clear() { events_.clear(); }
+
+  // Returns the number of events in the batch.
+  size_t size() const { return events_.size(); }
+
+  // Returns true if the batch has no events.
+  bool empty() const { return events_.empty(); }
+
+ private:
+  friend class BasicGenericEventQueue;
+
+  struct BatchedEvent {
+    void* function;
+    Payload payload;
+  };
+
+  // Adds an event with the arguments contained in a tuple.
+  template <typename FuncPtr, typename Tuple, size_t... Indices>
+  void AddTuple(FuncPtr event, const Tuple& args,
+                std::index_sequence<Indices...>) {
+    Add(event, std::get<Indices>(args)...);
+  }
+
+  std::vector<BatchedEvent> events_;
 };
 
+// The non-template methods of the queue are built for the lock policies below.
+extern template class BasicGenericEventQueue<NoLock>;
+extern template class BasicGenericEventQueue<SpinLock>;
+extern template class BasicGenericEventQueue<std::mutex>;
+extern template class BasicGenericEventQueue<std::recursive_mutex>;
+
+// Thread-safe event queue that allows reentrant use from listeners.
+using GenericEventQueue = BasicGenericEventQueue<std::recursive_mutex>;
+
 #endif  // MAGIC_FUNC_EXAMPLES_GENERIC_EVENT_QUEUE_GENERIC_EVENT_QUEUE_H_
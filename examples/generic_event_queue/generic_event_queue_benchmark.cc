@@ -0,0 +1,547 @@
+// Copyright (c) 2020, Leandro Graciá Gil
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "generic_event_queue.h"
+
+static constexpr size_t kNumExperiments = 20;
+static constexpr size_t kNumEvents = 100000;
+static constexpr size_t kNumFanOutEvents = 100;
+static constexpr size_t kFanOutChunkSize = 32;
+static constexpr size_t kFanOutListenerWork = 256;
+static constexpr size_t kNumDispatchEvents = 10000;
+static constexpr size_t kNumLatencyEvents = 100000;
+static constexpr size_t kLatencyBurstSize = 16;
+static constexpr size_t kBatchSize = 64;
+
+using Clock = std::chrono::high_resolution_clock;
+
+// Number of heap allocations made by the program. Used to measure the number
+// of allocations made per event.
+static std::atomic<size_t> allocation_count(0);
+
+void* operator new(size_t size) {
+  ++allocation_count;
+  if (void* memory = malloc(size))
+    return memory;
+  abort();
+}
+
+void* operator new[](size_t size) {
+  return operator new(size);
+}
+
+void operator delete(void* memory) noexcept {
+  free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+  free(memory);
+}
+
+void operator delete(void* memory, size_t /* size */) noexcept {
+  free(memory);
+}
+
+void operator delete[](void* memory, size_t /* size */) noexcept {
+  free(memory);
+}
+
+// Event arguments of different sizes.
+template <size_t N>
+struct Payload {
+  char data[N];
+};
+
+struct Events {
+  static void OnValue(size_t /* value */) {}
+  static void OnTimestamp(Clock::time_point /* timestamp */) {}
+
+  template <size_t N>
+  static void OnPayload(const Payload<N>& /* payload */) {}
+};
+
+namespace {
+
+// Naive event queue used as a baseline. Stores events as std::function
+// closures in a deque protected by a mutex, and only supports a single event
+// function whose arguments are provided by the template.
+template <typename... Args>
+class NaiveEventQueue {
+ public:
+  explicit NaiveEventQueue(void (* /* event */)(Args...)) {}
+
+  void AddEventListener(std::function<void(Args...)> listener) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    listeners_.push_back(std::move(listener));
+  }
+
+  template <typename... Args_>
+  void Enqueue(Args_&&... args) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    events_.emplace_back([this, args...]() {
+      for (auto& listener : listeners_)
+        listener(args...);
+    });
+  }
+
+  void Dispatch() {
+    std::deque<std::function<void()>> events;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      events.swap(events_);
+    }
+
+    for (auto& event : events)
+      event();
+  }
+
+ private:
+  std::mutex mutex_;
+  std::vector<std::function<void(Args...)>> listeners_;
+  std::deque<std::function<void()>> events_;
+};
+
+// Provides the same interface as NaiveEventQueue for a GenericEventQueue,
+// so that the same experiments can run with both queues.
+template <typename... Args>
+class GenericEventQueueAdapter {
+ public:
+  explicit GenericEventQueueAdapter(void (*event)(Args...)) : event_(event) {}
+
+  void AddEventListener(mf::Function<void(Args...)> listener) {
+    event_queue_.AddEventListener(event_, std::move(listener));
+  }
+
+  template <typename... Args_>
+  void Enqueue(Args_&&... args) {
+    event_queue_.Enqueue(event_, std::forward<Args_>(args)...);
+  }
+
+  void Dispatch() { event_queue_.Dispatch(); }
+
+ private:
+  GenericEventQueue event_queue_;
+  void (*event_)(Args...);
+};
+
+// Measures the mean time and standard deviation in nanoseconds per event of
+// running a provided experiment that processes a number of events and returns
+// the duration of the part to measure.
+template <typename Experiment>
+void TestMeasuredEvents(double& mean, double& stdev, size_t num_events,
+                        Experiment&& experiment) {
+  std::unique_ptr<double[]> experiment_mean(new double[kNumExperiments]);
+  mean = 0.0;
+
+  for (size_t i = 0; i < kNumExperiments; ++i) {
+    Clock::duration duration =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(experiment());
+    experiment_mean[i] = (long double) duration.count() / num_events;
+    mean += experiment_mean[i];
+  }
+
+  mean /= (double) kNumExperiments;
+  stdev = 0.0;
+  for (size_t i = 0; i < kNumExperiments; ++i) {
+    double diff = experiment_mean[i] - mean;
+    stdev += diff * diff;
+  }
+
+  stdev = sqrt(stdev / (double)(kNumExperiments - 1));
+}
+
+// Measures the mean time and standard deviation in nanoseconds per event of
+// running a provided experiment that processes a number of events.
+template <typename Experiment>
+void TestEvents(double& mean, double& stdev, size_t num_events,
+                Experiment&& experiment) {
+  TestMeasuredEvents(mean, stdev, num_events, [&experiment]() {
+    auto start = Clock::now();
+    experiment();
+    return Clock::now() - start;
+  });
+}
+
+// Enqueues and dispatches events to a single listener in one thread.
+template <typename Lock>
+void BenchmarkLockPolicy(const char* name) {
+  BasicGenericEventQueue<Lock> event_queue;
+  size_t sum = 0;
+  event_queue.AddEventListener(&Events::OnValue,
+                               [&sum](size_t value) { sum += value; });
+
+  double mean = 0.0, stdev = 0.0;
+  TestEvents(mean, stdev, kNumEvents, [&event_queue]() {
+    for (size_t i = 0; i < kNumEvents; ++i)
+      event_queue.Enqueue(&Events::OnValue, i);
+    event_queue.Dispatch();
+  });
+
+  std::cout << name << " " << mean << " " << stdev << std::endl;
+}
+
+// Dispatches events to a number of listeners doing some independent work,
+// either serially or in parallel.
+void TestFanOut(double& mean, double& stdev, size_t num_listeners,
+                WorkerPool* pool) {
+  GenericEventQueue event_queue;
+  event_queue.SetParallelDispatch(&Events::OnValue, pool, kFanOutChunkSize);
+
+  std::vector<size_t> results(num_listeners);
+  for (size_t i = 0; i < num_listeners; ++i) {
+    event_queue.AddEventListener(
+        &Events::OnValue,
+        [&results, i](size_t value) {
+          for (size_t k = 0; k < kFanOutListenerWork; ++k)
+            value = value * 31 + k;
+          results[i] = value;
+        });
+  }
+
+  TestEvents(mean, stdev, kNumFanOutEvents, [&event_queue]() {
+    for (size_t i = 0; i < kNumFanOutEvents; ++i)
+      event_queue.Enqueue(&Events::OnValue, i);
+    event_queue.Dispatch();
+  });
+}
+
+// Measures enqueuing events from multiple producer threads at the same time.
+template <template <typename...> class Queue>
+void TestProducers(double& mean, double& stdev, size_t num_producers) {
+  Queue<size_t> event_queue(&Events::OnValue);
+  size_t sum = 0;
+  event_queue.AddEventListener([&sum](size_t value) { sum += value; });
+
+  TestMeasuredEvents(mean, stdev, kNumEvents, [&event_queue, num_producers]() {
+    std::vector<std::thread> producers;
+    auto start = Clock::now();
+    for (size_t i = 0; i < num_producers; ++i) {
+      producers.emplace_back([&event_queue, num_producers]() {
+        for (size_t j = 0; j < kNumEvents / num_producers; ++j)
+          event_queue.Enqueue(j);
+      });
+    }
+
+    for (auto& producer : producers)
+      producer.join();
+    auto end = Clock::now();
+
+    event_queue.Dispatch();
+    return end - start;
+  });
+}
+
+// Measures enqueuing events in batches from multiple producer threads.
+void TestBatchProducers(double& mean, double& stdev, size_t num_producers) {
+  GenericEventQueue event_queue;
+  size_t sum = 0;
+  event_queue.AddEventListener(&Events::OnValue,
+                               [&sum](size_t value) { sum += value; });
+
+  TestMeasuredEvents(mean, stdev, kNumEvents, [&event_queue, num_producers]() {
+    std::vector<std::thread> producers;
+    auto start = Clock::now();
+    for (size_t i = 0; i < num_producers; ++i) {
+      producers.emplace_back([&event_queue, num_producers]() {
+        GenericEventQueue::EventBatch batch;
+        for (size_t j = 0; j < kNumEvents / num_producers; ++j) {
+          batch.Add(&Events::OnValue, j);
+          if (batch.size() == kBatchSize)
+            event_queue.EnqueueBatch(batch);
+        }
+        event_queue.EnqueueBatch(batch);
+      });
+    }
+
+    for (auto& producer : producers)
+      producer.join();
+    auto end = Clock::now();
+
+    event_queue.Dispatch();
+    return end - start;
+  });
+}
+
+// Measures dispatching events with a payload of N bytes to some listeners.
+template <template <typename...> class Queue, size_t N>
+void TestDispatch(double& mean, double& stdev, size_t num_listeners) {
+  Queue<const Payload<N>&> event_queue(&Events::OnPayload<N>);
+  size_t sum = 0;
+  for (size_t i = 0; i < num_listeners; ++i) {
+    event_queue.AddEventListener([&sum](const Payload<N>& payload) {
+      sum += payload.data[0];
+    });
+  }
+
+  Payload<N> payload = {};
+  TestMeasuredEvents(mean, stdev, kNumDispatchEvents,
+                     [&event_queue, &payload]() {
+    for (size_t i = 0; i < kNumDispatchEvents; ++i)
+      event_queue.Enqueue(payload);
+
+    auto start = Clock::now();
+    event_queue.Dispatch();
+    return Clock::now() - start;
+  });
+}
+
+// Measures the time from enqueuing events in a producer thread until they are
+// received by a listener in a thread dispatching continuously, and prints its
+// percentiles in nanoseconds.
+template <template <typename...> class Queue>
+void TestLatency(const char* name) {
+  Queue<Clock::time_point> event_queue(&Events::OnTimestamp);
+  std::vector<int64_t> latencies;
+  latencies.reserve(kNumLatencyEvents);
+  event_queue.AddEventListener([&latencies](Clock::time_point timestamp) {
+    latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        Clock::now() - timestamp).count());
+  });
+
+  std::atomic<bool> done(false);
+  std::thread consumer([&event_queue, &done]() {
+    while (!done.load(std::memory_order_acquire)) {
+      event_queue.Dispatch();
+      std::this_thread::yield();
+    }
+    event_queue.Dispatch();
+  });
+
+  for (size_t i = 0; i < kNumLatencyEvents; ++i) {
+    event_queue.Enqueue(Clock::now());
+    if (i % kLatencyBurstSize == kLatencyBurstSize - 1)
+      std::this_thread::yield();
+  }
+
+  done.store(true, std::memory_order_release);
+  consumer.join();
+
+  std::sort(latencies.begin(), latencies.end());
+  std::cout << name;
+  for (double percentile : {0.5, 0.9, 0.99, 0.999})
+    std::cout << " " << latencies[(size_t)(percentile * latencies.size())];
+  std::cout << std::endl;
+}
+
+// Counts the heap allocations made per enqueued and dispatched event, once any
+// storage kept between dispatches has been allocated.
+template <template <typename...> class Queue, size_t N>
+double CountAllocations() {
+  Queue<const Payload<N>&> event_queue(&Events::OnPayload<N>);
+  size_t sum = 0;
+  event_queue.AddEventListener([&sum](const Payload<N>& payload) {
+    sum += payload.data[0];
+  });
+
+  Payload<N> payload = {};
+  for (size_t i = 0; i < kNumDispatchEvents; ++i)
+    event_queue.Enqueue(payload);
+  event_queue.Dispatch();
+
+  size_t start_count = allocation_count.load();
+  for (size_t i = 0; i < kNumDispatchEvents; ++i)
+    event_queue.Enqueue(payload);
+  event_queue.Dispatch();
+  return (double)(allocation_count.load() - start_count) / kNumDispatchEvents;
+}
+
+}  // anonymous namespace
+
+void BenchmarkLockPolicies() {
+  std::cout << "# Enqueue and dispatch an event by lock policy (mean, stdev)."
+            << std::endl;
+  BenchmarkLockPolicy<NoLock>("NoLock");
+  BenchmarkLockPolicy<SpinLock>("SpinLock");
+  BenchmarkLockPolicy<std::mutex>("std::mutex");
+  BenchmarkLockPolicy<std::recursive_mutex>("std::recursive_mutex");
+  std::cout << std::endl;
+}
+
+void BenchmarkListenerChurn() {
+  std::cout << "# Add and remove a listener (mean, stdev)." << std::endl;
+  GenericEventQueue event_queue;
+  size_t sum = 0;
+  auto listener = [&sum](size_t value) { sum += value; };
+
+  // Keep a listener registered so that the event is always known.
+  event_queue.AddEventListener(&Events::OnValue, listener);
+
+  double id_mean = 0.0, id_stdev = 0.0;
+  TestEvents(id_mean, id_stdev, kNumEvents, [&event_queue, &listener]() {
+    for (size_t i = 0; i < kNumEvents; ++i) {
+      auto id = event_queue.AddEventListener(&Events::OnValue, listener);
+      event_queue.RemoveEventListener(&Events::OnValue, id);
+    }
+  });
+  std::cout << "ListenerId " << id_mean << " " << id_stdev << std::endl;
+
+  double hook_mean = 0.0, hook_stdev = 0.0;
+  GenericEventQueue::ListenerHook hook;
+  TestEvents(hook_mean, hook_stdev, kNumEvents,
+             [&event_queue, &listener, &hook]() {
+    for (size_t i = 0; i < kNumEvents; ++i) {
+      event_queue.AddEventListener(&Events::OnValue, hook, listener);
+      hook.Unlink();
+    }
+  });
+  std::cout << "ListenerHook " << hook_mean << " " << hook_stdev << std::endl;
+  std::cout << "Speed-up " << id_mean / hook_mean << "x (ListenerId)\n"
+            << std::endl;
+}
+
+void BenchmarkParallelDispatch() {
+  size_t num_workers =
+      std::max<size_t>(std::thread::hardware_concurrency(), 2) - 1;
+  WorkerPool pool(num_workers);
+
+  std::cout << "# Dispatch an event to N listeners, " << num_workers
+            << " workers (mean, stdev)." << std::endl;
+  for (size_t num_listeners : {16, 64, 256, 1024}) {
+    double serial_mean = 0.0, serial_stdev = 0.0;
+    TestFanOut(serial_mean, serial_stdev, num_listeners, nullptr);
+    std::cout << "Serial" << num_listeners << " " << serial_mean << " "
+              << serial_stdev << std::endl;
+
+    double parallel_mean = 0.0, parallel_stdev = 0.0;
+    TestFanOut(parallel_mean, parallel_stdev, num_listeners, &pool);
+    std::cout << "Parallel" << num_listeners << " " << parallel_mean << " "
+              << parallel_stdev << std::endl;
+    std::cout << "Speed-up " << serial_mean / parallel_mean << "x (Serial"
+              << num_listeners << ")" << std::endl;
+  }
+  std::cout << std::endl;
+}
+
+void BenchmarkProducers() {
+  std::cout << "# Enqueue an event from N producer threads (mean, stdev)."
+            << std::endl;
+  for (size_t num_producers : {1, 2, 4, 8}) {
+    double mean = 0.0, stdev = 0.0;
+    TestProducers<GenericEventQueueAdapter>(mean, stdev, num_producers);
+    std::cout << "GenericEventQueue" << num_producers << " " << mean << " "
+              << stdev << std::endl;
+
+    double naive_mean = 0.0, naive_stdev = 0.0;
+    TestProducers<NaiveEventQueue>(naive_mean, naive_stdev, num_producers);
+    std::cout << "NaiveEventQueue" << num_producers << " " << naive_mean << " "
+              << naive_stdev << std::endl;
+    std::cout << "Speed-up " << naive_mean / mean << "x (NaiveEventQueue"
+              << num_producers << ")" << std::endl;
+  }
+  std::cout << std::endl;
+}
+
+void BenchmarkBatches() {
+  std::cout << "# Enqueue an event from N producer threads in batches of "
+            << kBatchSize << " (mean, stdev)." << std::endl;
+  for (size_t num_producers : {1, 4}) {
+    double mean = 0.0, stdev = 0.0;
+    TestProducers<GenericEventQueueAdapter>(mean, stdev, num_producers);
+    std::cout << "Enqueue" << num_producers << " " << mean << " " << stdev
+              << std::endl;
+
+    double batch_mean = 0.0, batch_stdev = 0.0;
+    TestBatchProducers(batch_mean, batch_stdev, num_producers);
+    std::cout << "EnqueueBatch" << num_producers << " " << batch_mean << " "
+              << batch_stdev << std::endl;
+    std::cout << "Speed-up " << mean / batch_mean << "x (Enqueue"
+              << num_producers << ")" << std::endl;
+  }
+  std::cout << std::endl;
+}
+
+template <size_t N>
+void BenchmarkDispatchPayload() {
+  std::cout << "# Dispatch an event with " << N
+            << " bytes to N listeners (mean, stdev)." << std::endl;
+  for (size_t num_listeners : {1, 8, 64}) {
+    double mean = 0.0, stdev = 0.0;
+    TestDispatch<GenericEventQueueAdapter, N>(mean, stdev, num_listeners);
+    std::cout << "GenericEventQueue" << num_listeners << " " << mean << " "
+              << stdev << std::endl;
+
+    double naive_mean = 0.0, naive_stdev = 0.0;
+    TestDispatch<NaiveEventQueue, N>(naive_mean, naive_stdev, num_listeners);
+    std::cout << "NaiveEventQueue" << num_listeners << " " << naive_mean << " "
+              << naive_stdev << std::endl;
+    std::cout << "Speed-up " << naive_mean / mean << "x (NaiveEventQueue"
+              << num_listeners << ")" << std::endl;
+  }
+  std::cout << std::endl;
+}
+
+void BenchmarkDispatch() {
+  BenchmarkDispatchPayload<8>();
+  BenchmarkDispatchPayload<64>();
+  BenchmarkDispatchPayload<1024>();
+}
+
+void BenchmarkLatency() {
+  std::cout << "# Enqueue to dispatch latency in ns (p50, p90, p99, p99.9)."
+            << std::endl;
+  TestLatency<GenericEventQueueAdapter>("GenericEventQueue");
+  TestLatency<NaiveEventQueue>("NaiveEventQueue");
+  std::cout << std::endl;
+}
+
+void BenchmarkAllocations() {
+  std::cout << "# Heap allocations per event with 8 and 1024 bytes."
+            << std::endl;
+  std::cout << "GenericEventQueue "
+            << CountAllocations<GenericEventQueueAdapter, 8>() << " "
+            << CountAllocations<GenericEventQueueAdapter, 1024>() << std::endl;
+  std::cout << "NaiveEventQueue "
+            << CountAllocations<NaiveEventQueue, 8>() << " "
+            << CountAllocations<NaiveEventQueue, 1024>() << "\n" << std::endl;
+}
+
+int main() {
+  BenchmarkLockPolicies();
+  BenchmarkListenerChurn();
+  BenchmarkParallelDispatch();
+  BenchmarkProducers();
+  BenchmarkBatches();
+  BenchmarkDispatch();
+  BenchmarkLatency();
+  BenchmarkAllocations();
+  return 0;
+}
@@ -29,18 +29,39 @@
 
 #include <atomic>
 #include <chrono>
+#include <memory>
+#include <mutex>
 #include <thread>
 
 #include <gtest/gtest.h>
 
 #include "generic_event_queue.h"
 
+// Counts the number of copies and moves made of an object.
+struct CopyCounter {
+  CopyCounter(size_t* copies, size_t* moves) : copies(copies), moves(moves) {}
+  CopyCounter(const CopyCounter& other)
+      : copies(other.copies), moves(other.moves) {
+    ++*copies;
+  }
+  CopyCounter(CopyCounter&& other) : copies(other.copies), moves(other.moves) {
+    ++*moves;
+  }
+
+  size_t* copies;
+  size_t* moves;
+};
+
 struct Events {
   static void NoArgs() {}
+  static void ByValue(CopyCounter counter) {}
+  static void ByConstRef(const CopyCounter& counter) {}
+  static void Emplaced(const CopyCounter& counter, const std::string& str) {}
+  static void SharedPayload(std::shared_ptr<const std::string> str) {}
   static void WithArgs(int x, const std::string& str) {}
   static void LvalueRef(int& x) {}
 
-  // C++14 support is required for non-copyable and rvalue reference arguments.
+  // Non-copyable and rvalue reference arguments are moved.
   static void NonCopyable(std::unique_ptr<int> x) {}
   static void RvalueRef(std::unique_ptr<int>&& x) {}
 };
@@ -360,6 +381,58 @@ TEST(GenericEventQueue, RemoveListenersDuringDispatch) {
   EXPECT_EQ(0, called[2]);
 }
 
+TEST(GenericEventQueue, RemoveAllListeners) {
+  GenericEventQueue event_queue;
+  std::vector<int> called;
+  int ids[2];
+  GenericEventQueue::ListenerHook hook;
+
+  // Listeners of NoArgs remove themselves, leaving its list empty during its
+  // own dispatch. They also remove the only listener of WithArgs, whose list
+  // is removed while NoArgs is being dispatched.
+  ids[0] = event_queue.AddEventListener(
+      &Events::NoArgs,
+      [&called, &event_queue, &ids]() {
+        called.push_back(0);
+        event_queue.RemoveEventListener(&Events::NoArgs, ids[0]);
+        event_queue.RemoveEventListener(&Events::WithArgs, ids[1]);
+      });
+  event_queue.AddEventListener(
+      &Events::NoArgs, hook,
+      [&called, &hook]() {
+        called.push_back(1);
+        hook.Unlink();
+      });
+  ids[1] = event_queue.AddEventListener(
+      &Events::WithArgs,
+      [&called](int x, const std::string& str) {
+        called.push_back(2);
+      });
+
+  event_queue.Enqueue(&Events::NoArgs);
+  event_queue.Enqueue(&Events::WithArgs, 1, "foo");
+  event_queue.Enqueue(&Events::NoArgs);
+  EXPECT_TRUE(event_queue.Dispatch());
+
+  ASSERT_EQ(2U, called.size());
+  EXPECT_EQ(0, called[0]);
+  EXPECT_EQ(1, called[1]);
+  EXPECT_EQ(0U, event_queue.CountListeners(&Events::NoArgs));
+  EXPECT_EQ(0U, event_queue.CountListeners(&Events::WithArgs));
+
+  // Listeners can be added again once their lists have been removed.
+  called.clear();
+  event_queue.AddEventListener(
+      &Events::NoArgs,
+      [&called]() {
+        called.push_back(3);
+      });
+  event_queue.Enqueue(&Events::NoArgs);
+  EXPECT_TRUE(event_queue.Dispatch());
+  ASSERT_EQ(1U, called.size());
+  EXPECT_EQ(3, called[0]);
+}
+
 TEST(GenericEventQueue, DispatchWithinDispatch) {
   GenericEventQueue event_queue;
   std::vector<int> called;
@@ -387,6 +460,568 @@ TEST(GenericEventQueue, DispatchWithinDispatch) {
     EXPECT_EQ(i, called[i]);
 }
 
+TEST(GenericEventQueue, CancelEvent) {
+  GenericEventQueue event_queue;
+  std::vector<int> called;
+
+  event_queue.AddEventListener(
+      &Events::WithArgs,
+      [&called](int x, const std::string& str) {
+        called.push_back(x);
+      });
+
+  // Default-constructed handles are never valid.
+  EXPECT_FALSE(event_queue.Cancel(GenericEventQueue::EventHandle()));
+
+  event_queue.Enqueue(&Events::WithArgs, 1, "foo");
+  auto handle = event_queue.Enqueue(&Events::WithArgs, 2, "foo");
+  event_queue.Enqueue(&Events::WithArgs, 3, "foo");
+
+  // Events can only be cancelled once.
+  EXPECT_TRUE(event_queue.Cancel(handle));
+  EXPECT_FALSE(event_queue.Cancel(handle));
+
+  EXPECT_TRUE(event_queue.Dispatch());
+  ASSERT_EQ(2U, called.size());
+  EXPECT_EQ(1, called[0]);
+  EXPECT_EQ(3, called[1]);
+
+  // Cancelled events are not dispatched later either.
+  EXPECT_TRUE(event_queue.Dispatch());
+  EXPECT_EQ(2U, called.size());
+}
+
+TEST(GenericEventQueue, CancelStaleHandle) {
+  GenericEventQueue event_queue;
+  std::vector<int> called;
+
+  event_queue.AddEventListener(
+      &Events::WithArgs,
+      [&called](int x, const std::string& str) {
+        called.push_back(x);
+      });
+
+  // Handles become invalid once their events are dispatched.
+  auto handle = event_queue.Enqueue(&Events::WithArgs, 1, "foo");
+  EXPECT_TRUE(event_queue.Dispatch());
+  EXPECT_FALSE(event_queue.Cancel(handle));
+
+  // Reusing the storage of the event must not make old handles valid again.
+  auto new_handle = event_queue.Enqueue(&Events::WithArgs, 2, "foo");
+  EXPECT_EQ(handle.slot, new_handle.slot);
+  EXPECT_NE(handle.generation, new_handle.generation);
+  EXPECT_FALSE(event_queue.Cancel(handle));
+
+  EXPECT_TRUE(event_queue.Dispatch());
+  ASSERT_EQ(2U, called.size());
+  EXPECT_EQ(1, called[0]);
+  EXPECT_EQ(2, called[1]);
+}
+
+TEST(GenericEventQueue, CancelEventsDuringDispatch) {
+  GenericEventQueue event_queue;
+  GenericEventQueue::EventHandle current, pending, enqueued;
+  std::vector<int> called;
+
+  event_queue.AddEventListener(
+      &Events::NoArgs,
+      [&]() {
+        called.push_back(0);
+
+        // Events being dispatched can't be cancelled anymore.
+        EXPECT_FALSE(event_queue.Cancel(current));
+
+        // Both pending events and events enqueued during dispatch can.
+        enqueued = event_queue.Enqueue(&Events::WithArgs, 2, "foo");
+        EXPECT_TRUE(event_queue.Cancel(pending));
+        EXPECT_TRUE(event_queue.Cancel(enqueued));
+      });
+
+  event_queue.AddEventListener(
+      &Events::WithArgs,
+      [&called](int x, const std::string& str) {
+        called.push_back(x);
+      });
+
+  current = event_queue.Enqueue(&Events::NoArgs);
+  pending = event_queue.Enqueue(&Events::WithArgs, 1, "foo");
+
+  EXPECT_TRUE(event_queue.Dispatch());
+  EXPECT_TRUE(event_queue.Dispatch());
+  ASSERT_EQ(1U, called.size());
+  EXPECT_EQ(0, called[0]);
+}
+
+TEST(GenericEventQueue, DispatchEventsWithoutListeners) {
+  GenericEventQueue event_queue;
+  std::vector<int> called;
+
+  // Events without listeners are discarded when dispatched.
+  event_queue.Enqueue(&Events::NoArgs);
+  EXPECT_TRUE(event_queue.Dispatch());
+
+  event_queue.AddEventListener(
+      &Events::NoArgs,
+      [&called]() {
+        called.push_back(0);
+      });
+
+  EXPECT_TRUE(event_queue.Dispatch());
+  EXPECT_EQ(0U, called.size());
+}
+
+TEST(GenericEventQueue, BroadcastConstRefArgs) {
+  GenericEventQueue event_queue;
+  size_t copies = 0, moves = 0, called = 0;
+
+  static constexpr size_t kNumListeners = 50;
+  for (size_t i = 0; i < kNumListeners; ++i) {
+    event_queue.AddEventListener(
+        &Events::ByConstRef,
+        [&called](const CopyCounter& counter) {
+          ++called;
+        });
+  }
+
+  event_queue.Enqueue(&Events::ByConstRef, CopyCounter(&copies, &moves));
+  size_t enqueue_copies = copies;
+
+  // Listeners taking const references never copy the stored argument.
+  EXPECT_TRUE(event_queue.Dispatch());
+  EXPECT_EQ(kNumListeners, called);
+  EXPECT_EQ(enqueue_copies, copies);
+}
+
+TEST(GenericEventQueue, BroadcastByValueArgs) {
+  GenericEventQueue event_queue;
+  size_t copies = 0, moves = 0, called = 0;
+
+  static constexpr size_t kNumListeners = 50;
+  for (size_t i = 0; i < kNumListeners; ++i) {
+    event_queue.AddEventListener(
+        &Events::ByValue,
+        [&called](CopyCounter counter) {
+          ++called;
+        });
+  }
+
+  event_queue.Enqueue(&Events::ByValue, CopyCounter(&copies, &moves));
+  size_t enqueue_copies = copies;
+
+  // Each listener gets its own copy except the last one, which gets the
+  // stored argument moved instead.
+  EXPECT_TRUE(event_queue.Dispatch());
+  EXPECT_EQ(kNumListeners, called);
+  EXPECT_EQ(enqueue_copies + kNumListeners - 1, copies);
+}
+
+TEST(GenericEventQueue, BroadcastSharedPayload) {
+  GenericEventQueue event_queue;
+  std::vector<const std::string*> received;
+
+  for (size_t i = 0; i < 3; ++i) {
+    event_queue.AddEventListener(
+        &Events::SharedPayload,
+        [&received](std::shared_ptr<const std::string> str) {
+          received.push_back(str.get());
+        });
+  }
+
+  // All listeners share the same immutable object.
+  auto payload = std::make_shared<const std::string>(1024, 'x');
+  event_queue.Enqueue(&Events::SharedPayload, payload);
+  EXPECT_TRUE(event_queue.Dispatch());
+
+  ASSERT_EQ(3U, received.size());
+  for (const std::string* str : received)
+    EXPECT_EQ(payload.get(), str);
+}
+
+TEST(GenericEventQueue, BroadcastSharedConstRefArgs) {
+  GenericEventQueue event_queue;
+  size_t copies = 0, moves = 0;
+  std::vector<const CopyCounter*> received;
+
+  static constexpr size_t kNumListeners = 50;
+  for (size_t i = 0; i < kNumListeners; ++i) {
+    event_queue.AddEventListener(
+        &Events::ByConstRef,
+        [&received](const CopyCounter& counter) {
+          received.push_back(&counter);
+        });
+  }
+
+  // Events taking const references can share a payload enqueued as a
+  // std::shared_ptr<const T>, which is never copied nor moved.
+  auto payload = std::make_shared<const CopyCounter>(&copies, &moves);
+  event_queue.Enqueue(&Events::ByConstRef, payload);
+  event_queue.Enqueue(&Events::ByConstRef, payload);
+  EXPECT_EQ(3, payload.use_count());
+
+  EXPECT_TRUE(event_queue.Dispatch());
+  ASSERT_EQ(2 * kNumListeners, received.size());
+  for (const CopyCounter* counter : received)
+    EXPECT_EQ(payload.get(), counter);
+  EXPECT_EQ(0U, copies);
+  EXPECT_EQ(0U, moves);
+  EXPECT_EQ(1, payload.use_count());
+}
+
+TEST(GenericEventQueue, AddListenersDuringDispatch) {
+  GenericEventQueue event_queue;
+  std::vector<int> called;
+
+  event_queue.AddEventListener(
+      &Events::NoArgs,
+      [&called, &event_queue]() {
+        called.push_back(0);
+        event_queue.AddEventListener(
+            &Events::NoArgs,
+            [&called]() {
+              called.push_back(1);
+            });
+      });
+
+  // Listeners added during dispatch are called for the next events only.
+  event_queue.Enqueue(&Events::NoArgs);
+  EXPECT_TRUE(event_queue.Dispatch());
+  ASSERT_EQ(1U, called.size());
+  EXPECT_EQ(0, called[0]);
+  EXPECT_EQ(2U, event_queue.CountListeners(&Events::NoArgs));
+}
+
+TEST(GenericEventQueue, EmplaceEnqueue) {
+  GenericEventQueue event_queue;
+  size_t copies = 0, moves = 0;
+  std::vector<std::string> received;
+
+  event_queue.AddEventListener(
+      &Events::Emplaced,
+      [&received](const CopyCounter& counter, const std::string& str) {
+        received.push_back(str);
+      });
+
+  // Arguments are constructed in place from their constructor arguments.
+  // They are not copied nor moved, neither when enqueuing nor dispatching.
+  event_queue.Reserve(16);
+  for (size_t i = 0; i < 16; ++i) {
+    event_queue.EmplaceEnqueue(&Events::Emplaced,
+                               std::forward_as_tuple(&copies, &moves),
+                               std::make_tuple(i + 1, 'x'));
+  }
+
+  EXPECT_TRUE(event_queue.Dispatch());
+  EXPECT_EQ(0U, copies);
+  EXPECT_EQ(0U, moves);
+
+  ASSERT_EQ(16U, received.size());
+  for (size_t i = 0; i < received.size(); ++i)
+    EXPECT_EQ(std::string(i + 1, 'x'), received[i]);
+}
+
+TEST(GenericEventQueue, EmplaceEnqueueCancel) {
+  GenericEventQueue event_queue;
+  std::vector<int> called;
+
+  event_queue.AddEventListener(
+      &Events::WithArgs,
+      [&called](int x, const std::string& str) {
+        called.push_back(x);
+      });
+
+  event_queue.EmplaceEnqueue(&Events::WithArgs, std::make_tuple(1),
+                             std::make_tuple(3, 'a'));
+  auto handle = event_queue.EmplaceEnqueue(
+      &Events::WithArgs, std::make_tuple(2), std::make_tuple());
+  EXPECT_TRUE(event_queue.Cancel(handle));
+
+  EXPECT_TRUE(event_queue.Dispatch());
+  ASSERT_EQ(1U, called.size());
+  EXPECT_EQ(1, called[0]);
+}
+
+TEST(GenericEventQueue, ListenerHooks) {
+  GenericEventQueue event_queue;
+  std::vector<int> called;
+
+  // Hooks and listeners added by id are called in registration order.
+  GenericEventQueue::ListenerHook hook;
+  event_queue.AddEventListener(&Events::NoArgs,
+                               [&called]() { called.push_back(0); });
+  EXPECT_FALSE(hook.linked());
+  EXPECT_TRUE(event_queue.AddEventListener(
+      &Events::NoArgs, hook, [&called]() { called.push_back(1); }));
+  EXPECT_TRUE(hook.linked());
+  event_queue.AddEventListener(&Events::NoArgs,
+                               [&called]() { called.push_back(2); });
+
+  // Linked hooks cannot be added again.
+  EXPECT_FALSE(event_queue.AddEventListener(&Events::NoArgs, hook, []() {}));
+  EXPECT_EQ(3U, event_queue.CountListeners(&Events::NoArgs));
+
+  event_queue.Enqueue(&Events::NoArgs);
+  EXPECT_TRUE(event_queue.Dispatch());
+  ASSERT_EQ(3U, called.size());
+  for (size_t i = 0; i < called.size(); ++i)
+    EXPECT_EQ(i, called[i]);
+
+  // Unlinked hooks can be added again.
+  hook.Unlink();
+  EXPECT_FALSE(hook.linked());
+  EXPECT_EQ(2U, event_queue.CountListeners(&Events::NoArgs));
+  EXPECT_TRUE(event_queue.AddEventListener(
+      &Events::NoArgs, hook, [&called]() { called.push_back(3); }));
+
+  called.clear();
+  event_queue.Enqueue(&Events::NoArgs);
+  EXPECT_TRUE(event_queue.Dispatch());
+  ASSERT_EQ(3U, called.size());
+  EXPECT_EQ(0, called[0]);
+  EXPECT_EQ(2, called[1]);
+  EXPECT_EQ(3, called[2]);
+}
+
+TEST(GenericEventQueue, ListenerHookDestruction) {
+  GenericEventQueue event_queue;
+  std::vector<int> called;
+
+  {
+    GenericEventQueue::ListenerHook hook;
+    event_queue.AddEventListener(&Events::NoArgs, hook,
+                                 [&called]() { called.push_back(0); });
+    EXPECT_EQ(1U, event_queue.CountListeners(&Events::NoArgs));
+  }
+
+  // Destroyed hooks unlink themselves.
+  EXPECT_EQ(0U, event_queue.CountListeners(&Events::NoArgs));
+  event_queue.Enqueue(&Events::NoArgs);
+  EXPECT_TRUE(event_queue.Dispatch());
+  EXPECT_EQ(0U, called.size());
+
+  // Hooks outliving their queue are unlinked when it is destroyed.
+  GenericEventQueue::ListenerHook hook;
+  {
+    GenericEventQueue other_queue;
+    other_queue.AddEventListener(&Events::NoArgs, hook, []() {});
+    EXPECT_TRUE(hook.linked());
+  }
+  EXPECT_FALSE(hook.linked());
+}
+
+TEST(GenericEventQueue, UnlinkListenerHooksDuringDispatch) {
+  GenericEventQueue event_queue;
+  std::vector<int> called;
+  std::unique_ptr<GenericEventQueue::ListenerHook> hooks[4];
+  for (auto& hook : hooks)
+    hook.reset(new GenericEventQueue::ListenerHook);
+
+  // The first listener destroys the next hook, which is about to be visited,
+  // and the last one, which ends the dispatch early.
+  event_queue.AddEventListener(
+      &Events::NoArgs, *hooks[0],
+      [&called, &hooks]() {
+        called.push_back(0);
+        hooks[1].reset();
+        hooks[3].reset();
+      });
+
+  for (int i = 1; i < 4; ++i) {
+    event_queue.AddEventListener(
+        &Events::NoArgs, *hooks[i],
+        [&called, &hooks, i]() {
+          called.push_back(i);
+          hooks[i]->Unlink();
+        });
+  }
+
+  event_queue.Enqueue(&Events::NoArgs);
+  event_queue.Enqueue(&Events::NoArgs);
+  EXPECT_TRUE(event_queue.Dispatch());
+
+  // Unlike listeners removed by id, unlinked hooks are never called again.
+  // The third hook unlinks itself, so only the first one remains.
+  ASSERT_EQ(3U, called.size());
+  EXPECT_EQ(0, called[0]);
+  EXPECT_EQ(2, called[1]);
+  EXPECT_EQ(0, called[2]);
+  EXPECT_EQ(1U, event_queue.CountListeners(&Events::NoArgs));
+}
+
+TEST(GenericEventQueue, WorkerPoolParallelFor) {
+  WorkerPool pool(3);
+  EXPECT_EQ(3U, pool.num_workers());
+
+  // Every iteration must be visited exactly once, including uneven chunks.
+  static constexpr size_t N = 1000;
+  std::unique_ptr<std::atomic<int>[]> visited(new std::atomic<int>[N]);
+  for (size_t i = 0; i < N; ++i)
+    visited[i] = 0;
+
+  const size_t chunk_sizes[] = {1, 7, 64, N, 2 * N};
+  for (size_t chunk_size : chunk_sizes) {
+    pool.ParallelFor(N, chunk_size, [&visited, chunk_size](size_t begin,
+                                                           size_t end) {
+      EXPECT_LT(begin, end);
+      EXPECT_LE(end - begin, chunk_size);
+      for (size_t i = begin; i < end; ++i)
+        ++visited[i];
+    });
+  }
+
+  for (size_t i = 0; i < N; ++i)
+    EXPECT_EQ(5, visited[i]);
+}
+
+TEST(GenericEventQueue, ParallelDispatch) {
+  GenericEventQueue event_queue;
+  WorkerPool pool(3);
+  event_queue.SetParallelDispatch(&Events::WithArgs, &pool, 8);
+
+  static constexpr size_t N = 100;
+  std::atomic<size_t> sum(0);
+  std::vector<int> called;
+  std::mutex thread_ids_mutex;
+  std::vector<std::thread::id> thread_ids;
+  for (size_t i = 0; i < N; ++i) {
+    event_queue.AddEventListener(
+        &Events::WithArgs,
+        [&sum, &thread_ids_mutex, &thread_ids](int x, const std::string& str) {
+          EXPECT_EQ("foo", str);
+          sum += x;
+          std::lock_guard<std::mutex> lock(thread_ids_mutex);
+          thread_ids.push_back(std::this_thread::get_id());
+        });
+  }
+
+  // Events without the policy are still dispatched serially in order.
+  event_queue.AddEventListener(&Events::NoArgs,
+                               [&called]() { called.push_back(0); });
+  event_queue.AddEventListener(&Events::NoArgs,
+                               [&called]() { called.push_back(1); });
+
+  event_queue.Enqueue(&Events::WithArgs, 1, "foo");
+  event_queue.Enqueue(&Events::NoArgs);
+  event_queue.Enqueue(&Events::WithArgs, 2, "foo");
+  EXPECT_TRUE(event_queue.Dispatch());
+
+  // Each event is joined before the next one is dispatched.
+  EXPECT_EQ(3 * N, sum);
+  EXPECT_EQ(2 * N, thread_ids.size());
+  ASSERT_EQ(2U, called.size());
+  EXPECT_EQ(0, called[0]);
+  EXPECT_EQ(1, called[1]);
+
+  // Events with up to chunk_size listeners are dispatched serially, and the
+  // policy can be disabled at any time.
+  event_queue.SetParallelDispatch(&Events::WithArgs, &pool, N);
+  thread_ids.clear();
+  event_queue.Enqueue(&Events::WithArgs, 1, "foo");
+  EXPECT_TRUE(event_queue.Dispatch());
+  event_queue.SetParallelDispatch(&Events::WithArgs, nullptr, 0);
+  event_queue.Enqueue(&Events::WithArgs, 1, "foo");
+  EXPECT_TRUE(event_queue.Dispatch());
+
+  EXPECT_EQ(5 * N, sum);
+  for (std::thread::id thread_id : thread_ids)
+    EXPECT_EQ(std::this_thread::get_id(), thread_id);
+}
+
+TEST(GenericEventQueue, EnqueueBatch) {
+  GenericEventQueue event_queue;
+  std::vector<int> called;
+
+  event_queue.AddEventListener(
+      &Events::WithArgs,
+      [&called](int x, const std::string& str) {
+        EXPECT_EQ("foo", str);
+        called.push_back(x);
+      });
+
+  std::vector<std::tuple<int, const char*>> tuples = {
+      std::make_tuple(1, "foo"), std::make_tuple(2, "foo")};
+  std::vector<std::pair<int, std::string>> pairs = {{3, "foo"}};
+  event_queue.EnqueueBatch(&Events::WithArgs, tuples);
+  event_queue.EnqueueBatch(&Events::WithArgs, pairs);
+
+  EXPECT_TRUE(event_queue.Dispatch());
+  ASSERT_EQ(3U, called.size());
+  for (size_t i = 0; i < called.size(); ++i)
+    EXPECT_EQ(i + 1, called[i]);
+}
+
+TEST(GenericEventQueue, EventBatch) {
+  GenericEventQueue event_queue;
+  std::vector<int> called;
+
+  event_queue.AddEventListener(
+      &Events::WithArgs,
+      [&called](int x, const std::string& str) {
+        called.push_back(x);
+      });
+
+  event_queue.AddEventListener(
+      &Events::NoArgs,
+      [&called]() {
+        called.push_back(0);
+      });
+
+  // Events of different functions keep their relative order.
+  GenericEventQueue::EventBatch batch;
+  batch.Add(&Events::WithArgs, 1, "foo")
+       .Add(&Events::NoArgs)
+       .Add(&Events::WithArgs, 2, "bar");
+  EXPECT_EQ(3U, batch.size());
+
+  std::vector<GenericEventQueue::EventHandle> handles;
+  event_queue.Enqueue(&Events::WithArgs, -1, "baz");
+  event_queue.EnqueueBatch(batch, &handles);
+  EXPECT_TRUE(batch.empty());
+  ASSERT_EQ(3U, handles.size());
+
+  // Batched events can be cancelled individually.
+  EXPECT_TRUE(event_queue.Cancel(handles[2]));
+
+  // The batch can be reused.
+  batch.Add(&Events::WithArgs, 3, "foo");
+  event_queue.EnqueueBatch(batch);
+
+  EXPECT_TRUE(event_queue.Dispatch());
+  ASSERT_EQ(4U, called.size());
+  EXPECT_EQ(-1, called[0]);
+  EXPECT_EQ(1, called[1]);
+  EXPECT_EQ(0, called[2]);
+  EXPECT_EQ(3, called[3]);
+}
+
+TEST(GenericEventQueue, EventBatchDuringDispatch) {
+  GenericEventQueue event_queue;
+  std::vector<int> called;
+
+  event_queue.AddEventListener(
+      &Events::NoArgs,
+      [&called, &event_queue]() {
+        called.push_back(0);
+        GenericEventQueue::EventBatch batch;
+        batch.Add(&Events::WithArgs, 1, "foo").Add(&Events::WithArgs, 2, "");
+        event_queue.EnqueueBatch(batch);
+      });
+
+  event_queue.AddEventListener(
+      &Events::WithArgs,
+      [&called](int x, const std::string& str) {
+        called.push_back(x);
+      });
+
+  // Batches enqueued during dispatch run in the next one.
+  event_queue.Enqueue(&Events::NoArgs);
+  EXPECT_TRUE(event_queue.Dispatch());
+  ASSERT_EQ(1U, called.size());
+  EXPECT_TRUE(event_queue.Dispatch());
+  ASSERT_EQ(3U, called.size());
+  EXPECT_EQ(1, called[1]);
+  EXPECT_EQ(2, called[2]);
+}
+
 TEST(GenericEventQueue, MultithreadedUse) {
   GenericEventQueue event_queue;
 
@@ -451,3 +1086,101 @@ TEST(GenericEventQueue, MultithreadedUse) {
   // times, leading to N * (N * E)^2.
   EXPECT_EQ(N * (N * E) * (N * E), sum);
 }
+
+template <typename Lock>
+class GenericEventQueueLockPolicy : public testing::Test {};
+
+using LockPolicies = testing::Types<NoLock, SpinLock, std::mutex,
+                                    std::recursive_mutex>;
+TYPED_TEST_SUITE(GenericEventQueueLockPolicy, LockPolicies);
+
+TYPED_TEST(GenericEventQueueLockPolicy, DispatchEvent) {
+  BasicGenericEventQueue<TypeParam> event_queue;
+  std::vector<int> called;
+
+  event_queue.AddEventListener(
+      &Events::WithArgs,
+      [&called](int x, const std::string& str) {
+        EXPECT_EQ("foo", str);
+        called.push_back(x);
+      });
+
+  int id = event_queue.AddEventListener(
+      &Events::NoArgs,
+      [&called]() {
+        called.push_back(-1);
+      });
+
+  event_queue.Enqueue(&Events::WithArgs, 1, "foo");
+  event_queue.Enqueue(&Events::NoArgs);
+  event_queue.Enqueue(&Events::WithArgs, 2, "foo");
+
+  EXPECT_EQ(1U, event_queue.CountListeners(&Events::NoArgs));
+  EXPECT_TRUE(event_queue.RemoveEventListener(&Events::NoArgs, id));
+  EXPECT_EQ(0U, event_queue.CountListeners(&Events::NoArgs));
+
+  EXPECT_TRUE(event_queue.Dispatch());
+  ASSERT_EQ(2U, called.size());
+  EXPECT_EQ(1, called[0]);
+  EXPECT_EQ(2, called[1]);
+}
+
+TEST(GenericEventQueue, NoLockReentrantUse) {
+  // Without locking, listeners can still use the queue during dispatch.
+  BasicGenericEventQueue<NoLock> event_queue;
+  std::vector<int> called;
+
+  event_queue.AddEventListener(
+      &Events::NoArgs,
+      [&called, &event_queue]() {
+        called.push_back(0);
+        EXPECT_FALSE(event_queue.Dispatch());
+        event_queue.Enqueue(&Events::WithArgs, 1, "foo");
+      });
+
+  event_queue.AddEventListener(
+      &Events::WithArgs,
+      [&called](int x, const std::string& str) {
+        called.push_back(x);
+      });
+
+  event_queue.Enqueue(&Events::NoArgs);
+  EXPECT_TRUE(event_queue.Dispatch());
+  EXPECT_TRUE(event_queue.Dispatch());
+
+  ASSERT_EQ(2U, called.size());
+  EXPECT_EQ(0, called[0]);
+  EXPECT_EQ(1, called[1]);
+}
+
+TEST(GenericEventQueue, SpinLockMultithreadedUse) {
+  BasicGenericEventQueue<SpinLock> event_queue;
+
+  static constexpr size_t N = 4;    // Number of threads to spawn.
+  static constexpr size_t E = 100;  // Number of events per thread.
+  std::atomic<size_t> sum(0);
+
+  event_queue.AddEventListener(
+      &Events::WithArgs,
+      [&sum](size_t value, const std::string& str) {
+        sum += value;
+      });
+
+  std::thread t[N];
+  for (size_t num_thread = 0; num_thread < N; ++num_thread) {
+    t[num_thread] = std::thread([&event_queue]() {
+      for (size_t i = 0; i < E; ++i) {
+        event_queue.Enqueue(&Events::WithArgs, 1, "");
+        if (i % 10 == 0) {
+          EXPECT_TRUE(event_queue.Dispatch());
+        }
+      }
+    });
+  }
+
+  for (size_t num_thread = 0; num_thread < N; ++num_thread)
+    t[num_thread].join();
+
+  EXPECT_TRUE(event_queue.Dispatch());
+  EXPECT_EQ(N * E, sum);
+}
@@ -0,0 +1,78 @@
+// Copyright (c) 2020, Leandro Graciá Gil
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MAGIC_FUNC_EXAMPLES_GENERIC_EVENT_QUEUE_LOCK_POLICIES_H_
+#define MAGIC_FUNC_EXAMPLES_GENERIC_EVENT_QUEUE_LOCK_POLICIES_H_
+
+#include <atomic>
+#include <thread>
+
+// Lock policies for BasicGenericEventQueue.
+//
+// A lock policy is any type providing lock() and unlock() methods. Besides the
+// ones defined here, std::mutex and std::recursive_mutex can also be used.
+
+// Lock policy that performs no synchronization at all.
+//
+// Intended for queues only used from a single thread, where any locking would
+// be pure overhead. Locking and unlocking compile to nothing.
+struct NoLock {
+  void lock() {}
+  void unlock() {}
+};
+
+// Simple non-recursive spin lock.
+//
+// Suitable for short critical sections with little contention. Yields the
+// thread after spinning for a while to avoid starving the lock owner when
+// there are more threads than cores.
+class SpinLock {
+ public:
+  SpinLock() { flag_.clear(); }
+
+  SpinLock(const SpinLock&) = delete;
+  SpinLock& operator =(const SpinLock&) = delete;
+
+  void lock() {
+    for (int spins = 0; flag_.test_and_set(std::memory_order_acquire);) {
+      if (++spins >= kMaxSpins) {
+        spins = 0;
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  void unlock() { flag_.clear(std::memory_order_release); }
+
+ private:
+  enum : int { kMaxSpins = 64 };
+  std::atomic_flag flag_;
+};
+
+#endif  // MAGIC_FUNC_EXAMPLES_GENERIC_EVENT_QUEUE_LOCK_POLICIES_H_
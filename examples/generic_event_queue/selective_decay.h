@@ -30,6 +30,8 @@
 #ifndef MAGIC_FUNC_EXAMPLES_GENERIC_EVENT_QUEUE_SELECTIVE_DECAY_H_
 #define MAGIC_FUNC_EXAMPLES_GENERIC_EVENT_QUEUE_SELECTIVE_DECAY_H_
 
+#include "event_args.h"
+
 namespace impl {
 
 // Tells if the provided type is a std::reference_wrapper.
@@ -53,10 +55,14 @@ struct SelectiveDecay;
 
 template <typename Arg1, typename... Args1, typename Arg2, typename... Args2>
 struct SelectiveDecay<std::tuple<Arg1, Args1...>, std::tuple<Arg2, Args2...>> {
-  // If the type is a reference wrapper keep it as it is. Otherwise decay it.
+  // If the type is a reference wrapper keep it as it is. If it is a shared
+  // pointer to the object of a const reference, share it. Otherwise decay it.
   using Element = std::conditional_t<
       IsReferenceWrapper<Arg1>::value,
-      Arg2, std::decay_t<Arg2>>;
+      Arg2,
+      std::conditional_t<
+          IsSharedPayload<std::decay_t<Arg1>, Arg2>::value,
+          SharedEventArg<std::decay_t<Arg2>>, std::decay_t<Arg2>>>;
 
   // Recursively concatenate the result into a tuple.
   using type = decltype(std::tuple_cat(
@@ -77,6 +83,7 @@ struct SelectiveDecay<std::tuple<>, std::tuple<>> {
 //
 // The result is a selective decay of T2 depending on the types in T1.
 // This ensures explicit references using std::ref can be kept as such.
+// Shared pointers provided for const references are stored as SharedEventArg.
 template <typename T1, typename T2>
 using SelectiveDecay = typename impl::SelectiveDecay<T1, T2>::type;
 
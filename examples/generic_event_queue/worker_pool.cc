@@ -0,0 +1,115 @@
+// Copyright (c) 2020, Leandro Graciá Gil
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+
+#include "worker_pool.h"
+
+WorkerPool::WorkerPool(size_t num_workers) {
+  workers_.reserve(num_workers);
+  for (size_t i = 0; i < num_workers; ++i)
+    workers_.emplace_back(&WorkerPool::WorkerLoop, this);
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+
+  wake_cv_.notify_all();
+  for (auto& worker : workers_)
+    worker.join();
+}
+
+void WorkerPool::ParallelFor(size_t count, size_t chunk_size,
+                             const ChunkTask& task) {
+  if (count == 0)
+    return;
+
+  // Run loops that fit in a single chunk directly.
+  chunk_size = std::max<size_t>(chunk_size, 1);
+  size_t num_chunks = (count + chunk_size - 1) / chunk_size;
+  if (num_chunks == 1 || workers_.empty()) {
+    task(0, count);
+    return;
+  }
+
+  std::lock_guard<std::mutex> run_lock(run_mutex_);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    task_ = &task;
+    count_ = count;
+    chunk_size_ = chunk_size;
+    num_chunks_ = num_chunks;
+    next_chunk_.store(0, std::memory_order_relaxed);
+    busy_workers_ = workers_.size();
+    ++generation_;
+  }
+
+  wake_cv_.notify_all();
+  RunChunks();
+
+  // Every worker must be done with the loop state before it can be reused,
+  // even those that found no chunks left to run.
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_cv_.wait(lock, [this]() { return busy_workers_ == 0; });
+  task_ = nullptr;
+}
+
+void WorkerPool::RunChunks() {
+  for (;;) {
+    size_t chunk = next_chunk_.fetch_add(1, std::memory_order_relaxed);
+    if (chunk >= num_chunks_)
+      return;
+
+    size_t begin = chunk * chunk_size_;
+    (*task_)(begin, std::min(begin + chunk_size_, count_));
+  }
+}
+
+void WorkerPool::WorkerLoop() {
+  uint64_t generation = 0;
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (;;) {
+    wake_cv_.wait(lock, [this, generation]() {
+      return stop_ || generation_ != generation;
+    });
+    if (stop_)
+      return;
+
+    generation = generation_;
+    lock.unlock();
+    RunChunks();
+    lock.lock();
+
+    if (--busy_workers_ == 0)
+      done_cv_.notify_one();
+  }
+}
@@ -0,0 +1,104 @@
+// Copyright (c) 2020, Leandro Graciá Gil
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MAGIC_FUNC_EXAMPLES_GENERIC_EVENT_QUEUE_WORKER_POOL_H_
+#define MAGIC_FUNC_EXAMPLES_GENERIC_EVENT_QUEUE_WORKER_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <magic_func/function.h>
+
+// Fixed set of worker threads used to split loops into parallel chunks.
+//
+// Used by BasicGenericEventQueue to fan out the listeners of an event across
+// multiple threads. The calling thread also runs chunks, so a pool with N
+// workers runs loops with up to N + 1 threads.
+class WorkerPool {
+ public:
+  // Runs a chunk of loop iterations in the range [begin, end).
+  using ChunkTask = mf::Function<void(size_t begin, size_t end)>;
+
+  // Creates a pool with the provided number of worker threads.
+  // A pool without workers runs all loops in the calling thread.
+  explicit WorkerPool(size_t num_workers);
+  ~WorkerPool();
+
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator =(const WorkerPool&) = delete;
+
+  // Runs a task for consecutive chunks of at most chunk_size iterations in the
+  // range [0, count), and waits until all of them have finished.
+  //
+  // Chunks are taken dynamically by the workers and the calling thread, so
+  // uneven chunks are balanced. Larger chunks amortize the cost of waking up
+  // the workers. Loops from multiple threads are run one at a time.
+  //
+  // @param count The number of loop iterations.
+  // @param chunk_size The maximum number of iterations of each chunk.
+  // @param task The task to run for each chunk. Can be called concurrently.
+  void ParallelFor(size_t count, size_t chunk_size, const ChunkTask& task);
+
+  // Returns the number of worker threads of the pool.
+  size_t num_workers() const { return workers_.size(); }
+
+ private:
+  // Runs chunks of the current loop until there are no more left.
+  void RunChunks();
+
+  // Waits for loops to run and runs their chunks.
+  void WorkerLoop();
+
+  std::vector<std::thread> workers_;
+
+  // Serializes loops from multiple threads.
+  std::mutex run_mutex_;
+
+  // Protects the loop state below, which is written before waking the workers
+  // and is constant while they run.
+  std::mutex mutex_;
+  std::condition_variable wake_cv_;
+  std::condition_variable done_cv_;
+  uint64_t generation_ = 0;
+  size_t busy_workers_ = 0;
+  bool stop_ = false;
+
+  const ChunkTask* task_ = nullptr;
+  size_t count_ = 0;
+  size_t chunk_size_ = 0;
+  size_t num_chunks_ = 0;
+  std::atomic<size_t> next_chunk_{0};
+};
+
+#endif  // MAGIC_FUNC_EXAMPLES_GENERIC_EVENT_QUEUE_WORKER_POOL_H_
@@ -0,0 +1,138 @@
+// Copyright (c) 2020, Leandro Graciá Gil
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "local_rpc_client.h"
+
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cstring>
+
+namespace local_rpc {
+
+LocalRpcClient::LocalRpcClient()
+    : fd_(-1),
+      output_(new uint8_t[kBufferSize]),
+      output_size_(0) {}
+
+LocalRpcClient::~LocalRpcClient() {
+  Close();
+}
+
+bool LocalRpcClient::Connect(const std::string& path) {
+  sockaddr_un address;
+  if (fd_ != -1 || path.size() >= sizeof(address.sun_path))
+    return false;
+
+  std::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  std::memcpy(address.sun_path, path.c_str(), path.size());
+
+  fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd_ == -1)
+    return false;
+
+  if (connect(fd_, reinterpret_cast<sockaddr*>(&address),
+              sizeof(address)) == -1) {
+    Close();
+    return false;
+  }
+
+  return true;
+}
+
+void LocalRpcClient::Close() {
+  if (fd_ != -1) {
+    close(fd_);
+    fd_ = -1;
+  }
+  output_size_ = 0;
+}
+
+bool LocalRpcClient::Flush() {
+  size_t offset = 0;
+  while (offset < output_size_) {
+    ssize_t bytes = send(fd_, output_.get() + offset, output_size_ - offset,
+                         MSG_NOSIGNAL);
+    if (bytes < 0) {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    offset += bytes;
+  }
+
+  output_size_ = 0;
+  return true;
+}
+
+Status LocalRpcClient::Receive(void* result, size_t result_size) {
+  ResponseHeader response;
+  if (!ReadAll(&response, sizeof(response)))
+    return Status::kInvalidArguments;
+
+  if (response.status != Status::kOk)
+    return response.status;
+
+  // The response must match the expected return type.
+  if (response.payload_size != result_size) {
+    uint8_t discard[256];
+    for (size_t left = response.payload_size; left > 0; ) {
+      size_t size = left < sizeof(discard) ? left : sizeof(discard);
+      if (!ReadAll(discard, size))
+        break;
+      left -= size;
+    }
+    return Status::kInvalidArguments;
+  }
+
+  if (!ReadAll(result, result_size))
+    return Status::kInvalidArguments;
+
+  return Status::kOk;
+}
+
+bool LocalRpcClient::ReadAll(void* buffer, size_t size) {
+  uint8_t* data = static_cast<uint8_t*>(buffer);
+  while (size > 0) {
+    ssize_t bytes = recv(fd_, data, size, 0);
+    if (bytes < 0 && errno == EINTR)
+      continue;
+    if (bytes <= 0)
+      return false;
+    data += bytes;
+    size -= bytes;
+  }
+
+  return true;
+}
+
+}  // namespace local_rpc
@@ -0,0 +1,158 @@
+// Copyright (c) 2020, Leandro Graciá Gil
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MAGIC_FUNC_EXAMPLES_LOCAL_RPC_LOCAL_RPC_CLIENT_H_
+#define MAGIC_FUNC_EXAMPLES_LOCAL_RPC_LOCAL_RPC_CLIENT_H_
+
+#include <memory>
+#include <string>
+#include <type_traits>
+
+#include <magic_func/function_traits.h>
+
+#include "local_rpc_protocol.h"
+
+namespace local_rpc {
+
+// Blocking client for LocalRpcServer.
+//
+// Calls are typed by the function signature registered in the server, which is
+// used to convert the arguments before sending them. Calls can be sent one by
+// one with Call, or batched by sending several of them before a Flush and then
+// receiving their results in the same order.
+//
+// @code
+// local_rpc::LocalRpcClient client;
+// client.Connect("/tmp/sum.sock");
+//
+// int result;
+// if (client.Call<int(int, int)>(1, &result, 2, 3) == Status::kOk)
+//   assert(result == 5);
+//
+// // Batched calls.
+// client.Send<int(int, int)>(1, 1, 2);
+// client.Send<int(int, int)>(1, 3, 4);
+// client.Flush();
+// client.Receive(&result);  // 3.
+// client.Receive(&result);  // 7.
+// @endcode
+class LocalRpcClient {
+ public:
+  // Type of the values returned by calls to a function signature.
+  template <typename Signature>
+  using ReturnType =
+      std::decay_t<typename mf::FunctionTraits<Signature>::Return>;
+
+  LocalRpcClient();
+  ~LocalRpcClient();
+
+  LocalRpcClient(const LocalRpcClient&) = delete;
+  LocalRpcClient& operator =(const LocalRpcClient&) = delete;
+
+  // Connects to a server listening at the provided socket path.
+  bool Connect(const std::string& path);
+
+  // Closes the connection, if any.
+  void Close();
+
+  // Appends a call to the send buffer. Nothing is sent until Flush is called.
+  //
+  // @tparam Signature The signature of the function registered in the server.
+  // @return false if the call does not fit in the send buffer.
+  template <typename Signature, typename... CallArgs>
+  bool Send(FunctionId id, CallArgs&&... args) {
+    using DecayedArgs = typename mf::FunctionTraits<Signature>::DecayedArgs;
+    const size_t payload_size = TuplePackedSize<DecayedArgs>::value;
+    const RequestHeader request = {
+        id, static_cast<uint32_t>(payload_size) };
+
+    if (output_size_ + sizeof(request) + payload_size > kBufferSize)
+      return false;
+
+    DecayedArgs values(std::forward<CallArgs>(args)...);
+    uint8_t* output = PackValues(output_.get() + output_size_, request);
+    PackTuple(output, values,
+              std::make_index_sequence<std::tuple_size<DecayedArgs>::value>());
+    output_size_ += sizeof(request) + payload_size;
+    return true;
+  }
+
+  // Sends any buffered calls.
+  bool Flush();
+
+  // Receives the result of the next call with a return value.
+  // If the call failed the result is not modified.
+  template <typename Return>
+  Status Receive(Return* result) {
+    static_assert(IsSerializable<Return>::value,
+                  "Return type must be trivially copyable.");
+    return Receive(result, sizeof(Return));
+  }
+
+  // Receives the result of the next call without return value.
+  Status Receive() { return Receive(nullptr, 0); }
+
+  // Sends a call and waits for its result.
+  template <typename Signature, typename... CallArgs>
+  std::enable_if_t<!std::is_void<ReturnType<Signature>>::value, Status>
+  Call(FunctionId id, ReturnType<Signature>* result, CallArgs&&... args) {
+    if (!Send<Signature>(id, std::forward<CallArgs>(args)...) || !Flush())
+      return Status::kInvalidArguments;
+    return Receive(result);
+  }
+
+  // Version of the above for functions without return value.
+  template <typename Signature, typename... CallArgs>
+  std::enable_if_t<std::is_void<ReturnType<Signature>>::value, Status>
+  Call(FunctionId id, CallArgs&&... args) {
+    if (!Send<Signature>(id, std::forward<CallArgs>(args)...) || !Flush())
+      return Status::kInvalidArguments;
+    return Receive();
+  }
+
+ private:
+  enum : size_t { kBufferSize = 64 * 1024 };
+
+  template <typename Tuple, size_t... Indices>
+  static uint8_t* PackTuple(uint8_t* output, const Tuple& values,
+                            std::index_sequence<Indices...>) {
+    return PackValues(output, std::get<Indices>(values)...);
+  }
+
+  Status Receive(void* result, size_t result_size);
+  bool ReadAll(void* buffer, size_t size);
+
+  int fd_;
+  std::unique_ptr<uint8_t[]> output_;
+  size_t output_size_;
+};
+
+}  // namespace local_rpc
+
+#endif  // MAGIC_FUNC_EXAMPLES_LOCAL_RPC_LOCAL_RPC_CLIENT_H_
@@ -0,0 +1,137 @@
+// Copyright (c) 2020, Leandro Graciá Gil
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MAGIC_FUNC_EXAMPLES_LOCAL_RPC_LOCAL_RPC_PROTOCOL_H_
+#define MAGIC_FUNC_EXAMPLES_LOCAL_RPC_LOCAL_RPC_PROTOCOL_H_
+
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// Wire format shared by LocalRpcServer and LocalRpcClient.
+//
+// Every request is a RequestHeader followed by the arguments of the call,
+// packed one after the other without padding. Every response is a
+// ResponseHeader followed by the return value of the call, if any.
+//
+// Both ends live in the same machine, so values are sent in native byte order
+// and layout. Only trivially copyable types can be used as arguments and
+// return values.
+namespace local_rpc {
+
+// Identifies a function registered in a LocalRpcServer.
+using FunctionId = uint32_t;
+
+// Result of a remote call.
+enum class Status : uint32_t {
+  // The call was made and its result, if any, follows the header.
+  kOk = 0,
+
+  // No function is registered with the requested id.
+  kUnknownFunction,
+
+  // The argument payload size does not match the registered function.
+  kInvalidArguments,
+};
+
+struct RequestHeader {
+  FunctionId function_id;
+  uint32_t payload_size;
+};
+
+struct ResponseHeader {
+  Status status;
+  uint32_t payload_size;
+};
+
+// Tells if all the provided types can be sent through the wire.
+template <typename... Types>
+struct IsSerializable;
+
+template <>
+struct IsSerializable<> : public std::true_type {};
+
+template <typename T, typename... Types>
+struct IsSerializable<T, Types...> : public std::integral_constant<bool,
+    std::is_trivially_copyable<T>::value &&
+    IsSerializable<Types...>::value> {};
+
+// Number of bytes used in the wire by a set of packed values.
+template <typename... Types>
+struct PackedSize;
+
+template <>
+struct PackedSize<> : public std::integral_constant<size_t, 0> {};
+
+template <typename T, typename... Types>
+struct PackedSize<T, Types...> : public std::integral_constant<size_t,
+    sizeof(T) + PackedSize<Types...>::value> {};
+
+// Serialized size of a tuple of arguments.
+template <typename Tuple>
+struct TuplePackedSize;
+
+template <typename... Types>
+struct TuplePackedSize<std::tuple<Types...>> : public PackedSize<Types...> {};
+
+// Writes a set of values one after the other into a buffer.
+// Returns the address right after the last written byte.
+template <typename... Types>
+uint8_t* PackValues(uint8_t* buffer, const Types&... values) {
+  static_assert(IsSerializable<Types...>::value,
+                "Values must be trivially copyable.");
+  (void) std::initializer_list<int>{
+      (std::memcpy(buffer, &values, sizeof(values)),
+       buffer += sizeof(values), 0)...};
+  return buffer;
+}
+
+// Reads a tuple of values previously written by PackValues.
+template <typename... Types, size_t... Indices>
+void UnpackTuple(const uint8_t* buffer, std::tuple<Types...>& values,
+                 std::index_sequence<Indices...>) {
+  static_assert(IsSerializable<Types...>::value,
+                "Values must be trivially copyable.");
+  (void) std::initializer_list<int>{
+      (std::memcpy(&std::get<Indices>(values), buffer,
+                   sizeof(std::get<Indices>(values))),
+       buffer += sizeof(std::get<Indices>(values)), 0)...};
+}
+
+template <typename... Types>
+void UnpackTuple(const uint8_t* buffer, std::tuple<Types...>& values) {
+  UnpackTuple(buffer, values, std::index_sequence_for<Types...>());
+}
+
+}  // namespace local_rpc
+
+#endif  // MAGIC_FUNC_EXAMPLES_LOCAL_RPC_LOCAL_RPC_PROTOCOL_H_
@@ -0,0 +1,324 @@
+// Copyright (c) 2020, Leandro Graciá Gil
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "local_rpc_server.h"
+
+#include <errno.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cstring>
+
+namespace local_rpc {
+
+namespace {
+
+// Maximum number of socket events handled per Poll call.
+constexpr int kMaxEvents = 64;
+
+}  // anonymous namespace
+
+// State of a client connection.
+//
+// Requests are read into the input buffer and responses written into the
+// output buffer. Partial requests remain in the input buffer until completed
+// by later reads. If the socket cannot take all the output, reading stops
+// until it does, which provides backpressure to clients.
+struct LocalRpcServer::Connection {
+  explicit Connection(int fd)
+      : fd(fd),
+        input(new uint8_t[kBufferSize]),
+        input_size(0),
+        output(new uint8_t[kBufferSize]),
+        output_size(0),
+        output_offset(0),
+        events(EPOLLIN) {}
+
+  ~Connection() { close(fd); }
+
+  bool HasPendingOutput() const { return output_offset < output_size; }
+
+  int fd;
+  std::unique_ptr<uint8_t[]> input;
+  size_t input_size;
+  std::unique_ptr<uint8_t[]> output;
+  size_t output_size;
+  size_t output_offset;
+  uint32_t events;
+};
+
+LocalRpcServer::LocalRpcServer()
+    : listen_fd_(-1),
+      epoll_fd_(-1) {}
+
+LocalRpcServer::~LocalRpcServer() {
+  Close();
+}
+
+bool LocalRpcServer::Register(FunctionId id, mf::TypeErasedFunction&& function,
+                              size_t args_size, size_t result_size,
+                              Invoker invoker) {
+  if (!function)
+    return false;
+
+  // Requests and responses must fit in the connection buffers.
+  if (sizeof(RequestHeader) + args_size > kBufferSize ||
+      sizeof(ResponseHeader) + result_size > kBufferSize) {
+    return false;
+  }
+
+  Entry entry = { std::move(function), args_size, result_size, invoker };
+  return functions_.emplace(id, std::move(entry)).second;
+}
+
+bool LocalRpcServer::Listen(const std::string& path) {
+  sockaddr_un address;
+  if (listen_fd_ != -1 || path.size() >= sizeof(address.sun_path))
+    return false;
+
+  std::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  std::memcpy(address.sun_path, path.c_str(), path.size());
+
+  listen_fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+  if (listen_fd_ == -1 || epoll_fd_ == -1) {
+    Close();
+    return false;
+  }
+
+  unlink(path.c_str());
+  if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&address),
+           sizeof(address)) == -1 ||
+      listen(listen_fd_, SOMAXCONN) == -1) {
+    Close();
+    return false;
+  }
+  path_ = path;
+
+  // The listening socket is identified by a null data pointer.
+  epoll_event event;
+  event.events = EPOLLIN;
+  event.data.ptr = nullptr;
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, listen_fd_, &event) == -1) {
+    Close();
+    return false;
+  }
+
+  return true;
+}
+
+int LocalRpcServer::Poll(int timeout_ms) {
+  if (epoll_fd_ == -1)
+    return -1;
+
+  epoll_event events[kMaxEvents];
+  int num_events = epoll_wait(epoll_fd_, events, kMaxEvents, timeout_ms);
+  if (num_events == -1)
+    return errno == EINTR ? 0 : -1;
+
+  int num_calls = 0;
+  for (int i = 0; i < num_events; ++i) {
+    auto connection = static_cast<Connection*>(events[i].data.ptr);
+    if (!connection) {
+      while (Accept()) {}
+      continue;
+    }
+
+    int result = Serve(connection);
+    if (result < 0)
+      Disconnect(connection);
+    else
+      num_calls += result;
+  }
+
+  return num_calls;
+}
+
+void LocalRpcServer::Close() {
+  connections_.clear();
+
+  if (listen_fd_ != -1) {
+    close(listen_fd_);
+    listen_fd_ = -1;
+  }
+
+  if (epoll_fd_ != -1) {
+    close(epoll_fd_);
+    epoll_fd_ = -1;
+  }
+
+  if (!path_.empty()) {
+    unlink(path_.c_str());
+    path_.clear();
+  }
+}
+
+bool LocalRpcServer::Accept() {
+  int fd = accept4(listen_fd_, nullptr, nullptr,
+                   SOCK_NONBLOCK | SOCK_CLOEXEC);
+  if (fd == -1)
+    return false;
+
+  std::unique_ptr<Connection> connection(new Connection(fd));
+  epoll_event event;
+  event.events = EPOLLIN;
+  event.data.ptr = connection.get();
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) == -1)
+    return true;
+
+  connections_.emplace(fd, std::move(connection));
+  return true;
+}
+
+void LocalRpcServer::Disconnect(Connection* connection) {
+  epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, connection->fd, nullptr);
+  connections_.erase(connection->fd);
+}
+
+int LocalRpcServer::Serve(Connection* connection) {
+  // Finish sending any previous responses before taking more requests.
+  if (connection->HasPendingOutput()) {
+    if (!Flush(connection))
+      return -1;
+    if (connection->HasPendingOutput())
+      return 0;
+  } else {
+    // Read as much as possible. Multiple requests might arrive together.
+    ssize_t bytes = recv(connection->fd,
+                         connection->input.get() + connection->input_size,
+                         kBufferSize - connection->input_size, 0);
+    if (bytes == 0)
+      return -1;
+
+    if (bytes < 0)
+      return errno == EAGAIN || errno == EINTR ? 0 : -1;
+
+    connection->input_size += bytes;
+  }
+
+  int num_calls = ProcessRequests(connection);
+  if (num_calls < 0 || !Flush(connection) || !UpdateEvents(connection))
+    return -1;
+
+  return num_calls;
+}
+
+int LocalRpcServer::ProcessRequests(Connection* connection) {
+  const uint8_t* input = connection->input.get();
+  size_t offset = 0;
+  int num_calls = 0;
+
+  while (connection->input_size - offset >= sizeof(RequestHeader)) {
+    RequestHeader request;
+    std::memcpy(&request, input + offset, sizeof(request));
+
+    // Requests that can never fit in the buffer are protocol errors.
+    size_t request_size = sizeof(request) + request.payload_size;
+    if (request_size > kBufferSize)
+      return -1;
+
+    if (connection->input_size - offset < request_size)
+      break;
+
+    auto it = functions_.find(request.function_id);
+    ResponseHeader response = { Status::kOk, 0 };
+    if (it == functions_.end())
+      response.status = Status::kUnknownFunction;
+    else if (it->second.args_size != request.payload_size)
+      response.status = Status::kInvalidArguments;
+    else
+      response.payload_size = static_cast<uint32_t>(it->second.result_size);
+
+    // Wait until there is space for the response. Requests stay in the input
+    // buffer until then.
+    size_t response_size = sizeof(response) + response.payload_size;
+    if (kBufferSize - connection->output_size < response_size) {
+      if (!Flush(connection))
+        return -1;
+      if (kBufferSize - connection->output_size < response_size)
+        break;
+    }
+
+    uint8_t* output = connection->output.get() + connection->output_size;
+    output = PackValues(output, response);
+    if (response.status == Status::kOk) {
+      const Entry& entry = it->second;
+      (*entry.invoker)(entry.function, input + offset + sizeof(request),
+                       output);
+      ++num_calls;
+    }
+
+    connection->output_size += response_size;
+    offset += request_size;
+  }
+
+  // Keep any partial or pending requests for later.
+  connection->input_size -= offset;
+  std::memmove(connection->input.get(), input + offset,
+               connection->input_size);
+  return num_calls;
+}
+
+bool LocalRpcServer::Flush(Connection* connection) {
+  while (connection->HasPendingOutput()) {
+    ssize_t bytes = send(connection->fd,
+                         connection->output.get() + connection->output_offset,
+                         connection->output_size - connection->output_offset,
+                         MSG_NOSIGNAL);
+    if (bytes < 0) {
+      if (errno == EINTR)
+        continue;
+      return errno == EAGAIN;
+    }
+    connection->output_offset += bytes;
+  }
+
+  connection->output_size = 0;
+  connection->output_offset = 0;
+  return true;
+}
+
+bool LocalRpcServer::UpdateEvents(Connection* connection) {
+  // Wait for the socket to be writable while there is pending output.
+  // Otherwise wait for more requests.
+  uint32_t events = connection->HasPendingOutput() ? EPOLLOUT : EPOLLIN;
+  if (events == connection->events)
+    return true;
+
+  epoll_event event;
+  event.events = events;
+  event.data.ptr = connection;
+  connection->events = events;
+  return epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, connection->fd, &event) == 0;
+}
+
+}  // namespace local_rpc
@@ -0,0 +1,205 @@
+// Copyright (c) 2020, Leandro Graciá Gil
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MAGIC_FUNC_EXAMPLES_LOCAL_RPC_LOCAL_RPC_SERVER_H_
+#define MAGIC_FUNC_EXAMPLES_LOCAL_RPC_LOCAL_RPC_SERVER_H_
+
+#include <memory>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+#include <magic_func/function.h>
+#include <magic_func/function_cast.h>
+#include <magic_func/function_traits.h>
+#include <magic_func/type_erased_function.h>
+
+#include "local_rpc_protocol.h"
+
+namespace local_rpc {
+
+// A minimal RPC server exposing mf::Functions to other local processes through
+// a Unix domain socket.
+//
+// Functions are registered with a numeric id and can be called remotely by
+// sending their id and arguments. Arguments are decoded directly from the
+// receive buffer of the connection into the decayed argument tuple of the
+// function, the function is invoked and its return value is written into the
+// send buffer of the connection. No heap memory is used per call: buffers are
+// allocated once per connection and functions are stored type-erased at
+// registration time.
+//
+// Multiple calls sent together by a client are processed in a single read and
+// their responses written back in a single write, in the same order.
+//
+// The server is single-threaded and uses epoll, so it is Linux-only. All the
+// work happens synchronously inside Poll().
+//
+// @code
+// int Sum(int x, int y) { return x + y; }
+//
+// local_rpc::LocalRpcServer server;
+// server.Register(1, MF_MakeFunction(&Sum));
+// server.Listen("/tmp/sum.sock");
+// while (running)
+//   server.Poll(100);
+// @endcode
+class LocalRpcServer {
+ public:
+  // Size of the receive and send buffers of each connection.
+  // Requests and responses must fit within them.
+  enum : size_t { kBufferSize = 64 * 1024 };
+
+  LocalRpcServer();
+  ~LocalRpcServer();
+
+  LocalRpcServer(const LocalRpcServer&) = delete;
+  LocalRpcServer& operator =(const LocalRpcServer&) = delete;
+
+  // Registers a function to be called remotely.
+  //
+  // Decayed argument types and the return type must be trivially copyable.
+  // Arguments are received by value, so reference arguments refer to objects
+  // that only live during the call.
+  //
+  // @param id The id clients will use to call the function.
+  // @param function The function to call.
+  // @return false if the id is already in use or the function is empty.
+  template <typename Return, typename... Args>
+  bool Register(FunctionId id, mf::Function<Return(Args...)> function) {
+    using Traits = mf::FunctionTraits<Return(Args...)>;
+    using DecayedArgs = typename Traits::DecayedArgs;
+    static_assert(IsSerializable<std::decay_t<Args>...>::value,
+                  "Argument types must be trivially copyable.");
+    static_assert(std::is_void<Return>::value ||
+                  IsSerializable<std::decay_t<Return>>::value,
+                  "Return type must be void or trivially copyable.");
+    return Register(id, std::move(function),
+                    TuplePackedSize<DecayedArgs>::value,
+                    ResultSize<Return>::value,
+                    &Invoke<Return, Args...>);
+  }
+
+  // Starts listening for connections in the provided socket path.
+  // Any existing file at that path is replaced.
+  //
+  // @return false on error or if the server is already listening.
+  bool Listen(const std::string& path);
+
+  // Waits for socket activity and serves it.
+  //
+  // Accepts new connections, reads any pending requests, runs them and sends
+  // back their responses. Returns after a single round of activity or when
+  // timing out.
+  //
+  // @param timeout_ms Maximum time to wait in milliseconds, or -1 to block.
+  // @return Number of calls processed, or -1 on error.
+  int Poll(int timeout_ms);
+
+  // Closes all connections and stops listening.
+  void Close();
+
+  // Returns the number of connected clients.
+  size_t CountConnections() const { return connections_.size(); }
+
+ private:
+  struct Connection;
+
+  // Decodes arguments, invokes a registered function and encodes its result.
+  using Invoker = void (*)(const mf::TypeErasedFunction& function,
+                           const uint8_t* args, uint8_t* result);
+
+  struct Entry {
+    mf::TypeErasedFunction function;
+    size_t args_size;
+    size_t result_size;
+    Invoker invoker;
+  };
+
+  template <typename Return>
+  struct ResultSize
+      : public std::integral_constant<size_t, sizeof(Return)> {};
+
+  // Invokes a function with its arguments decoded from a buffer.
+  template <typename Return, typename... Args>
+  static void Invoke(const mf::TypeErasedFunction& type_erased,
+                     const uint8_t* args, uint8_t* result) {
+    typename mf::FunctionTraits<Return(Args...)>::DecayedArgs values;
+    UnpackTuple(args, values);
+    auto& function = mf::function_cast<Return(Args...)>(type_erased);
+    Call(function, values, result, std::is_void<Return>(),
+         std::index_sequence_for<Args...>());
+  }
+
+  // Calls a function returning a value and writes it into the result buffer.
+  template <typename Return, typename... Args, typename Tuple,
+            size_t... Indices>
+  static void Call(const mf::Function<Return(Args...)>& function,
+                   Tuple& values, uint8_t* result, std::false_type,
+                   std::index_sequence<Indices...>) {
+    const std::decay_t<Return> value =
+        function(std::forward<Args>(std::get<Indices>(values))...);
+    PackValues(result, value);
+  }
+
+  // Calls a function with no return value.
+  template <typename Return, typename... Args, typename Tuple,
+            size_t... Indices>
+  static void Call(const mf::Function<Return(Args...)>& function,
+                   Tuple& values, uint8_t*, std::true_type,
+                   std::index_sequence<Indices...>) {
+    function(std::forward<Args>(std::get<Indices>(values))...);
+  }
+
+  // Non-template functions for the server implementation.
+  bool Register(FunctionId id, mf::TypeErasedFunction&& function,
+                size_t args_size, size_t result_size, Invoker invoker);
+  bool Accept();
+  void Disconnect(Connection* connection);
+  int Serve(Connection* connection);
+  int ProcessRequests(Connection* connection);
+  bool Flush(Connection* connection);
+  bool UpdateEvents(Connection* connection);
+
+  std::unordered_map<FunctionId, Entry> functions_;
+  std::unordered_map<int, std::unique_ptr<Connection>> connections_;
+  std::string path_;
+  int listen_fd_;
+  int epoll_fd_;
+};
+
+template <>
+struct LocalRpcServer::ResultSize<void>
+    : public std::integral_constant<size_t, 0> {};
+
+}  // namespace local_rpc
+
+#endif  // MAGIC_FUNC_EXAMPLES_LOCAL_RPC_LOCAL_RPC_SERVER_H_
@@ -0,0 +1,168 @@
+// Copyright (c) 2020, Leandro Graciá Gil
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <unistd.h>
+
+#include <string>
+
+#include <magic_func/make_function.h>
+#include <gtest/gtest.h>
+
+#include "local_rpc_client.h"
+#include "local_rpc_server.h"
+
+using namespace local_rpc;
+
+namespace {
+
+enum : FunctionId {
+  kSum = 1,
+  kScale,
+  kStore,
+  kUnregistered,
+};
+
+struct Point {
+  int x;
+  int y;
+};
+
+int Sum(int x, int y) {
+  return x + y;
+}
+
+Point Scale(const Point& point, float factor) {
+  return Point{ static_cast<int>(point.x * factor),
+                static_cast<int>(point.y * factor) };
+}
+
+// Returns a socket path unique to the current process.
+std::string SocketPath() {
+  return "/tmp/magic_func_local_rpc_" + std::to_string(getpid()) + ".sock";
+}
+
+class LocalRpcTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_TRUE(server_.Register(kSum, MF_MakeFunction(&Sum)));
+    ASSERT_TRUE(server_.Register(kScale, MF_MakeFunction(&Scale)));
+    ASSERT_TRUE(server_.Register(
+        kStore,
+        mf::Function<void(int64_t)>([this](int64_t value) {
+          stored_ = value;
+        })));
+
+    ASSERT_TRUE(server_.Listen(SocketPath()));
+    ASSERT_TRUE(client_.Connect(SocketPath()));
+
+    // Accept the connection.
+    EXPECT_EQ(0, server_.Poll(1000));
+    EXPECT_EQ(1U, server_.CountConnections());
+  }
+
+  LocalRpcServer server_;
+  LocalRpcClient client_;
+  int64_t stored_ = 0;
+};
+
+}  // anonymous namespace
+
+TEST_F(LocalRpcTest, Call) {
+  ASSERT_TRUE(client_.Send<int(int, int)>(kSum, 2, 3));
+  ASSERT_TRUE(client_.Flush());
+  EXPECT_EQ(1, server_.Poll(1000));
+
+  int result = 0;
+  EXPECT_EQ(Status::kOk, client_.Receive(&result));
+  EXPECT_EQ(5, result);
+}
+
+TEST_F(LocalRpcTest, StructArguments) {
+  ASSERT_TRUE(client_.Send<Point(const Point&, float)>(
+      kScale, Point{ 2, 3 }, 1.5f));
+  ASSERT_TRUE(client_.Flush());
+  EXPECT_EQ(1, server_.Poll(1000));
+
+  Point result = { 0, 0 };
+  EXPECT_EQ(Status::kOk, client_.Receive(&result));
+  EXPECT_EQ(3, result.x);
+  EXPECT_EQ(4, result.y);
+}
+
+TEST_F(LocalRpcTest, VoidFunction) {
+  ASSERT_TRUE(client_.Send<void(int64_t)>(kStore, 42));
+  ASSERT_TRUE(client_.Flush());
+  EXPECT_EQ(1, server_.Poll(1000));
+
+  EXPECT_EQ(Status::kOk, client_.Receive());
+  EXPECT_EQ(42, stored_);
+}
+
+TEST_F(LocalRpcTest, BatchedCalls) {
+  // All calls are sent together and served in a single poll.
+  static constexpr int kNumCalls = 100;
+  for (int i = 0; i < kNumCalls; ++i)
+    ASSERT_TRUE(client_.Send<int(int, int)>(kSum, i, 1000));
+  ASSERT_TRUE(client_.Flush());
+  EXPECT_EQ(kNumCalls, server_.Poll(1000));
+
+  for (int i = 0; i < kNumCalls; ++i) {
+    int result = 0;
+    EXPECT_EQ(Status::kOk, client_.Receive(&result));
+    EXPECT_EQ(i + 1000, result);
+  }
+}
+
+TEST_F(LocalRpcTest, Errors) {
+  ASSERT_TRUE(client_.Send<int(int, int)>(kUnregistered, 1, 2));
+  ASSERT_TRUE(client_.Send<int(int)>(kSum, 1));
+  ASSERT_TRUE(client_.Send<int(int, int)>(kSum, 1, 2));
+  ASSERT_TRUE(client_.Flush());
+  EXPECT_EQ(1, server_.Poll(1000));
+
+  int result = 0;
+  EXPECT_EQ(Status::kUnknownFunction, client_.Receive(&result));
+  EXPECT_EQ(Status::kInvalidArguments, client_.Receive(&result));
+  EXPECT_EQ(0, result);
+
+  // Errors do not affect later calls.
+  EXPECT_EQ(Status::kOk, client_.Receive(&result));
+  EXPECT_EQ(3, result);
+}
+
+TEST_F(LocalRpcTest, DuplicateRegistration) {
+  EXPECT_FALSE(server_.Register(kSum, MF_MakeFunction(&Sum)));
+  EXPECT_FALSE(server_.Register(kUnregistered, mf::Function<int(int, int)>()));
+}
+
+TEST_F(LocalRpcTest, Disconnect) {
+  client_.Close();
+  EXPECT_EQ(0, server_.Poll(1000));
+  EXPECT_EQ(0U, server_.CountConnections());
+}
@@ -0,0 +1,130 @@
+// Copyright (c) 2020, Leandro Graciá Gil
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <unistd.h>
+
+#include <atomic>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include <magic_func/make_function.h>
+
+#include "local_rpc_client.h"
+#include "local_rpc_server.h"
+
+namespace {
+
+// Ids of the functions exposed by the server.
+enum : local_rpc::FunctionId {
+  kAdd = 1,
+  kNegate,
+  kLog,
+};
+
+int Add(int x, int y) {
+  return x + y;
+}
+
+struct Vector {
+  double x;
+  double y;
+};
+
+class Logger {
+ public:
+  void Log(int code) {
+    std::cout << "Server received log code " << code << std::endl;
+  }
+};
+
+}  // anonymous namespace
+
+int main() {
+  const std::string path =
+      "/tmp/magic_func_local_rpc_example_" + std::to_string(getpid());
+
+  // Any mf::Function with trivially copyable arguments and return values can
+  // be exposed: free functions, lambdas and member functions bound to objects.
+  Logger logger;
+  local_rpc::LocalRpcServer server;
+  server.Register(kAdd, MF_MakeFunction(&Add));
+  server.Register(kNegate, mf::Function<Vector(Vector)>([](Vector v) {
+    return Vector{ -v.x, -v.y };
+  }));
+  server.Register(kLog, MF_MakeFunction(&Logger::Log, &logger));
+
+  if (!server.Listen(path)) {
+    std::cerr << "Failed to listen at " << path << std::endl;
+    return 1;
+  }
+
+  // Serve requests from a separate thread. In a real program this would be
+  // the event loop of a different process.
+  std::atomic<bool> running(true);
+  std::thread server_thread([&server, &running]() {
+    while (running)
+      server.Poll(10);
+  });
+
+  local_rpc::LocalRpcClient client;
+  if (!client.Connect(path)) {
+    std::cerr << "Failed to connect to " << path << std::endl;
+    running = false;
+    server_thread.join();
+    return 1;
+  }
+
+  int sum = 0;
+  client.Call<int(int, int)>(kAdd, &sum, 20, 22);
+  std::cout << "Add(20, 22) = " << sum << std::endl;
+
+  Vector v = { 0.0, 0.0 };
+  client.Call<Vector(Vector)>(kNegate, &v, Vector{ 1.5, -2.5 });
+  std::cout << "Negate(1.5, -2.5) = " << v.x << ", " << v.y << std::endl;
+
+  client.Call<void(int)>(kLog, 404);
+
+  // Several calls can be sent together. The server processes all of them in
+  // a single read and sends back the results in order.
+  for (int i = 0; i < 5; ++i)
+    client.Send<int(int, int)>(kAdd, i, i);
+  client.Flush();
+
+  for (int i = 0; i < 5; ++i) {
+    client.Receive(&sum);
+    std::cout << "Batched Add(" << i << ", " << i << ") = " << sum
+              << std::endl;
+  }
+
+  client.Close();
+  running = false;
+  server_thread.join();
+  return 0;
+}
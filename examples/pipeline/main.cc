@@ -0,0 +1,108 @@
+// Copyright (c) 2020, Leandro Graciá Gil
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <iostream>
+#include <string>
+
+#include <magic_func/make_function.h>
+
+#include "pipeline.h"
+
+namespace {
+
+struct Record {
+  std::string line;
+  size_t words = 0;
+};
+
+void CountWords(Record& record) {
+  bool in_word = false;
+  for (char c : record.line) {
+    bool is_space = c == ' ';
+    if (!is_space && !in_word)
+      ++record.words;
+    in_word = !is_space;
+  }
+}
+
+class Totals {
+ public:
+  void Add(Record& record) { words_ += record.words; ++lines_; }
+
+  size_t words() const { return words_; }
+  size_t lines() const { return lines_; }
+
+ private:
+  size_t words_ = 0;
+  size_t lines_ = 0;
+};
+
+}  // anonymous namespace
+
+int main() {
+  Totals totals;
+
+  // Each stage runs in its own thread.
+  Pipeline<Record> pipeline(256, 32);
+  pipeline.AddStage([](Record& record) {
+    for (char& c : record.line) {
+      if (c == ',' || c == '.')
+        c = ' ';
+    }
+  });
+  pipeline.AddStage(MF_MakeFunction(&CountWords));
+  pipeline.AddStage(MF_MakeFunction(&Totals::Add, &totals));
+  pipeline.Start();
+
+  const char* text[] = {
+    "The quick brown fox jumps over the lazy dog.",
+    "Pack my box with five dozen liquor jugs.",
+    "How vexingly quick daft zebras jump.",
+  };
+
+  for (int i = 0; i < 10000; ++i) {
+    Record record;
+    record.line = text[i % 3];
+    pipeline.Push(std::move(record));
+  }
+
+  // Waits for all records to go through all stages.
+  pipeline.Close();
+
+  std::cout << totals.lines() << " lines, " << totals.words() << " words."
+            << std::endl;
+  for (size_t i = 0; i < pipeline.num_stages(); ++i) {
+    StageStats stats = pipeline.GetStats(i);
+    std::cout << "Stage " << i << ": " << stats.items << " items in "
+              << stats.batches << " batches, " << stats.stalls << " stalls."
+              << std::endl;
+  }
+
+  return 0;
+}
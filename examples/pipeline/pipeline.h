@@ -0,0 +1,350 @@
+// Copyright (c) 2020, Leandro Graciá Gil
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MAGIC_FUNC_EXAMPLES_PIPELINE_PIPELINE_H_
+#define MAGIC_FUNC_EXAMPLES_PIPELINE_PIPELINE_H_
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <magic_func/cache_line_isolated.h>
+#include <magic_func/function.h>
+
+#include "spsc_ring.h"
+#include "waiter.h"
+
+// Counters of the work done by a pipeline stage.
+struct StageStats {
+  // Items processed by the stage.
+  uint64_t items = 0;
+
+  // Batches of items processed. Items per batch grow when the stage falls
+  // behind, amortizing the synchronization costs.
+  uint64_t batches = 0;
+
+  // Times the stage had to wait because the next one was full.
+  uint64_t stalls = 0;
+};
+
+// Chain of stages processing items in order, each one in a thread of its own.
+//
+// Stages are connected by bounded lock-free single-producer single-consumer
+// rings. Each stage takes all the items available in its input ring up to a
+// maximum batch size, processes them, and pushes them all at once to the next
+// stage. When a stage falls behind, the rings before it fill up and the
+// previous stages wait for it, all the way back to Push. This way memory use
+// stays bounded regardless of the speed of each stage.
+//
+// Threads waiting for items or free space retry a bounded number of times,
+// yielding in between, and then block until another stage wakes them up. This
+// keeps latency low while the pipeline is busy without using any CPU time
+// while it is idle. Stage threads can optionally be pinned to a CPU.
+//
+// Example:
+// Pipeline<Request> pipeline;
+// pipeline.AddStage(MF_MakeFunction(&Parse));
+// pipeline.AddStage([&cache](Request& request) { cache.Lookup(request); });
+// pipeline.AddStage(MF_MakeFunction(&Server::Reply, &server));
+// pipeline.Start();
+//
+// for (auto& request : requests)
+//   pipeline.Push(std::move(request));
+// pipeline.Close();
+template <typename T>
+class Pipeline {
+ public:
+  using Stage = mf::Function<void(T&)>;
+
+  // Creates an empty pipeline. Ring capacity is rounded up to a power of two.
+  explicit Pipeline(size_t ring_capacity = 1024, size_t max_batch_size = 64);
+
+  // Closes the pipeline if it was started, waiting for all pushed items.
+  ~Pipeline();
+
+  Pipeline(const Pipeline&) = delete;
+  Pipeline& operator =(const Pipeline&) = delete;
+
+  // Value of AddStage cpu argument to let the stage run on any CPU.
+  enum : int { kAnyCpu = -1 };
+
+  // Appends a stage to the pipeline. Must be called before Start.
+  //
+  // The thread of the stage is pinned to the provided CPU if supported by the
+  // platform, which is currently only Linux. Otherwise it is ignored. The CPU
+  // must be one the process is allowed to run on.
+  void AddStage(Stage stage, int cpu = kAnyCpu);
+
+  // Starts one thread per stage.
+  void Start();
+
+  // Pushes an item into the first stage, waiting while it is full.
+  void Push(T item);
+
+  // Pushes an item into the first stage if it is not full. Items are moved
+  // only when successfully pushed.
+  bool TryPush(T& item);
+
+  // Waits until all pushed items go through all stages and stops the threads.
+  // No more items can be pushed afterwards.
+  void Close();
+
+  // Returns the counters of a stage. Can be called while the pipeline runs.
+  StageStats GetStats(size_t stage) const;
+
+  size_t num_stages() const { return stages_.size(); }
+
+  // Times Push had to wait because the first stage was full.
+  uint64_t push_stalls() const { return push_stalls_; }
+
+ private:
+  // Times a thread retries before blocking while waiting for items or space.
+  enum : size_t { kMaxSpins = 64 };
+
+  // Each stage has its own counters, isolated in their own cache lines so
+  // that stage threads do not slow each other down when updating them.
+  struct StageState {
+    explicit StageState(Stage stage, size_t ring_capacity, int cpu)
+        : stage(std::move(stage)), input(ring_capacity), cpu(cpu), done(false),
+          items(0), batches(0), stalls(0) {}
+
+    Stage stage;
+    SpscRing<T> input;
+    std::thread thread;
+    int cpu;
+
+    // Wake up the stage when its input has items, and the previous stage or
+    // Push when its input has free space.
+    Waiter items_waiter;
+    Waiter space_waiter;
+
+    // Set when the stage processed all its items and pushed them forward.
+    std::atomic<bool> done;
+
+    char padding0_[mf::kCacheLineSize];
+    std::atomic<uint64_t> items;
+    std::atomic<uint64_t> batches;
+    std::atomic<uint64_t> stalls;
+    char padding1_[mf::kCacheLineSize];
+  };
+
+  // Body of the thread running a stage.
+  void RunStage(size_t index);
+
+  // Pushes items into the input of a stage, waiting while it is full.
+  // Returns the number of times it had to wait.
+  static uint64_t PushToStage(StageState& stage, T* items, size_t count);
+
+  std::vector<std::unique_ptr<StageState>> stages_;
+  size_t ring_capacity_;
+  size_t max_batch_size_;
+  std::atomic<bool> closed_;
+  bool started_;
+  uint64_t push_stalls_;
+};
+
+template <typename T>
+Pipeline<T>::Pipeline(size_t ring_capacity, size_t max_batch_size)
+    : ring_capacity_(ring_capacity),
+      max_batch_size_(max_batch_size > 0 ? max_batch_size : 1),
+      closed_(false),
+      started_(false),
+      push_stalls_(0) {}
+
+template <typename T>
+Pipeline<T>::~Pipeline() {
+  if (started_)
+    Close();
+}
+
+template <typename T>
+void Pipeline<T>::AddStage(Stage stage, int cpu) {
+  assert(!started_);
+  assert(stage);
+  stages_.emplace_back(new StageState(std::move(stage), ring_capacity_, cpu));
+}
+
+template <typename T>
+void Pipeline<T>::Start() {
+  assert(!started_);
+  assert(!stages_.empty());
+  started_ = true;
+  for (size_t i = 0; i < stages_.size(); ++i) {
+    StageState& state = *stages_[i];
+    state.thread = std::thread(&Pipeline::RunStage, this, i);
+  }
+}
+
+template <typename T>
+void Pipeline<T>::Push(T item) {
+  assert(!closed_.load(std::memory_order_relaxed));
+  push_stalls_ += PushToStage(*stages_.front(), &item, 1);
+}
+
+template <typename T>
+bool Pipeline<T>::TryPush(T& item) {
+  assert(!closed_.load(std::memory_order_relaxed));
+  StageState& first = *stages_.front();
+  if (first.input.TryPush(&item, 1) == 0)
+    return false;
+
+  first.items_waiter.Notify();
+  return true;
+}
+
+template <typename T>
+void Pipeline<T>::Close() {
+  if (closed_.exchange(true, std::memory_order_release))
+    return;
+
+  // The first stage might be blocked waiting for items.
+  stages_.front()->items_waiter.Notify();
+
+  for (auto& stage : stages_) {
+    if (stage->thread.joinable())
+      stage->thread.join();
+  }
+}
+
+template <typename T>
+StageStats Pipeline<T>::GetStats(size_t stage) const {
+  const StageState& state = *stages_[stage];
+  StageStats stats;
+  stats.items = state.items.load(std::memory_order_relaxed);
+  stats.batches = state.batches.load(std::memory_order_relaxed);
+  stats.stalls = state.stalls.load(std::memory_order_relaxed);
+  return stats;
+}
+
+template <typename T>
+uint64_t Pipeline<T>::PushToStage(StageState& stage, T* items, size_t count) {
+  uint64_t stalls = 0;
+  size_t pushed = stage.input.TryPush(items, count);
+  while (pushed < count) {
+    // Wake up the stage before waiting for it to free some space.
+    if (pushed > 0)
+      stage.items_waiter.Notify();
+
+    if (++stalls <= kMaxSpins) {
+      std::this_thread::yield();
+    } else {
+      stage.space_waiter.Wait([&stage] {
+        return stage.input.size() < stage.input.capacity();
+      });
+    }
+
+    pushed += stage.input.TryPush(items + pushed, count - pushed);
+  }
+
+  stage.items_waiter.Notify();
+  return stalls;
+}
+
+template <typename T>
+void Pipeline<T>::RunStage(size_t index) {
+  StageState& state = *stages_[index];
+
+#if defined(__linux__)
+  // Pin the thread before running the stage, so that it does not allocate or
+  // touch any data from another CPU.
+  if (state.cpu != kAnyCpu) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(state.cpu, &cpus);
+    int result = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    assert(result == 0);
+    (void) result;
+  }
+#endif
+
+  StageState* next =
+      index + 1 < stages_.size() ? stages_[index + 1].get() : nullptr;
+  const std::atomic<bool>& upstream_done =
+      index > 0 ? stages_[index - 1]->done : closed_;
+
+  std::unique_ptr<T[]> batch(new T[max_batch_size_]);
+  size_t spins = 0;
+  while (true) {
+    size_t count = state.input.TryPop(batch.get(), max_batch_size_);
+    if (count == 0) {
+      // Check the input again after knowing that no more items will come.
+      if (upstream_done.load(std::memory_order_acquire)) {
+        count = state.input.TryPop(batch.get(), max_batch_size_);
+        if (count == 0)
+          break;
+      } else {
+        if (++spins <= kMaxSpins) {
+          std::this_thread::yield();
+        } else {
+          state.items_waiter.Wait([&state, &upstream_done] {
+            return state.input.size() > 0 ||
+                   upstream_done.load(std::memory_order_acquire);
+          });
+        }
+        continue;
+      }
+    }
+
+    // The previous stage or Push might be waiting for free space.
+    spins = 0;
+    state.space_waiter.Notify();
+
+    for (size_t i = 0; i < count; ++i)
+      state.stage(batch[i]);
+
+    state.items.store(state.items.load(std::memory_order_relaxed) + count,
+                      std::memory_order_relaxed);
+    state.batches.store(state.batches.load(std::memory_order_relaxed) + 1,
+                        std::memory_order_relaxed);
+
+    if (!next)
+      continue;
+
+    uint64_t stalls = PushToStage(*next, batch.get(), count);
+    if (stalls > 0) {
+      state.stalls.store(state.stalls.load(std::memory_order_relaxed) + stalls,
+                         std::memory_order_relaxed);
+    }
+  }
+
+  state.done.store(true, std::memory_order_release);
+  if (next)
+    next->items_waiter.Notify();
+}
+
+#endif  // MAGIC_FUNC_EXAMPLES_PIPELINE_PIPELINE_H_
@@ -0,0 +1,181 @@
+// Copyright (c) 2020, Leandro Graciá Gil
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "pipeline.h"
+
+static constexpr size_t kNumExperiments = 10;
+static constexpr uint64_t kNumItems = 200000;
+
+using Clock = std::chrono::high_resolution_clock;
+
+namespace {
+
+// Minimal pipeline of std::functions connected by queues protected by a
+// mutex, like the ones commonly found in existing code.
+class MutexPipeline {
+ public:
+  using Stage = std::function<void(uint64_t&)>;
+
+  explicit MutexPipeline(const std::vector<Stage>& stages)
+      : queues_(stages.size()) {
+    for (size_t i = 0; i < stages.size(); ++i)
+      threads_.emplace_back(&MutexPipeline::Run, this, i, stages[i]);
+  }
+
+  ~MutexPipeline() {
+    for (auto& thread : threads_)
+      thread.join();
+  }
+
+  // Pushes an item. A zero item tells the stages to finish.
+  void Push(uint64_t item) { queues_[0].Push(item); }
+
+ private:
+  struct Queue {
+    void Push(uint64_t item) {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        items.push_back(item);
+      }
+      condition.notify_one();
+    }
+
+    uint64_t Pop() {
+      std::unique_lock<std::mutex> lock(mutex);
+      condition.wait(lock, [this]() { return !items.empty(); });
+      uint64_t item = items.front();
+      items.pop_front();
+      return item;
+    }
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::deque<uint64_t> items;
+  };
+
+  void Run(size_t index, Stage stage) {
+    while (true) {
+      uint64_t item = queues_[index].Pop();
+      if (item != 0)
+        stage(item);
+      if (index + 1 < queues_.size())
+        queues_[index + 1].Push(item);
+      if (item == 0)
+        break;
+    }
+  }
+
+  std::vector<Queue> queues_;
+  std::vector<std::thread> threads_;
+};
+
+// Measures the mean time and standard deviation in nanoseconds per item of
+// running a provided experiment that processes kNumItems items.
+template <typename Experiment>
+void TestItems(double& mean, double& stdev, Experiment&& experiment) {
+  std::unique_ptr<double[]> experiment_mean(new double[kNumExperiments]);
+  mean = 0.0;
+
+  for (size_t i = 0; i < kNumExperiments; ++i) {
+    auto start = Clock::now();
+    experiment();
+    auto end = Clock::now();
+
+    Clock::duration duration =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+    experiment_mean[i] = (long double) duration.count() / kNumItems;
+    mean += experiment_mean[i];
+  }
+
+  mean /= (double) kNumExperiments;
+  stdev = 0.0;
+  for (size_t i = 0; i < kNumExperiments; ++i) {
+    double diff = experiment_mean[i] - mean;
+    stdev += diff * diff;
+  }
+
+  stdev = sqrt(stdev / (double)(kNumExperiments - 1));
+}
+
+}  // anonymous namespace
+
+void BenchmarkPipeline() {
+  std::cout << "# Processing items through a 3-stage pipeline (mean, stdev)."
+            << std::endl;
+
+  double mean_mutex = 0.0, stdev_mutex = 0.0;
+  TestItems(mean_mutex, stdev_mutex, []() {
+    uint64_t sum = 0;
+    {
+      MutexPipeline pipeline({
+          [](uint64_t& x) { x *= 3; },
+          [](uint64_t& x) { x ^= x >> 7; },
+          [&sum](uint64_t& x) { sum += x; },
+      });
+      for (uint64_t i = 1; i <= kNumItems; ++i)
+        pipeline.Push(i);
+      pipeline.Push(0);
+    }
+  });
+  std::cout << "mutex + std::function " << mean_mutex << " " << stdev_mutex
+            << std::endl;
+
+  double mean_spsc = 0.0, stdev_spsc = 0.0;
+  TestItems(mean_spsc, stdev_spsc, []() {
+    uint64_t sum = 0;
+    Pipeline<uint64_t> pipeline;
+    pipeline.AddStage([](uint64_t& x) { x *= 3; });
+    pipeline.AddStage([](uint64_t& x) { x ^= x >> 7; });
+    pipeline.AddStage([&sum](uint64_t& x) { sum += x; });
+    pipeline.Start();
+    for (uint64_t i = 1; i <= kNumItems; ++i)
+      pipeline.Push(i);
+    pipeline.Close();
+  });
+  std::cout << "Pipeline " << mean_spsc << " " << stdev_spsc << std::endl;
+  std::cout << "Speed-up " << (mean_mutex / mean_spsc) << "x (mutex)\n"
+            << std::endl;
+}
+
+int main() {
+  BenchmarkPipeline();
+  return 0;
+}
@@ -0,0 +1,227 @@
+// Copyright (c) 2020, Leandro Graciá Gil
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "pipeline.h"
+#include "spsc_ring.h"
+
+TEST(SpscRing, PushAndPop) {
+  SpscRing<int> ring(3);
+  EXPECT_EQ(ring.capacity(), 4u);
+
+  int items[] = {1, 2, 3, 4, 5};
+  EXPECT_EQ(ring.TryPush(items, 5), 4u);
+  EXPECT_EQ(ring.TryPush(items + 4, 1), 0u);
+
+  int popped[5] = {};
+  EXPECT_EQ(ring.TryPop(popped, 3), 3u);
+  EXPECT_EQ(popped[0], 1);
+  EXPECT_EQ(popped[2], 3);
+
+  // Wraps around the end of the buffer.
+  EXPECT_EQ(ring.TryPush(items + 4, 1), 1u);
+  EXPECT_EQ(ring.TryPop(popped, 5), 2u);
+  EXPECT_EQ(popped[0], 4);
+  EXPECT_EQ(popped[1], 5);
+  EXPECT_EQ(ring.TryPop(popped, 5), 0u);
+}
+
+TEST(SpscRing, MoveOnlyItems) {
+  SpscRing<std::unique_ptr<int>> ring(2);
+  std::unique_ptr<int> item(new int(5));
+  ASSERT_EQ(ring.TryPush(&item, 1), 1u);
+  EXPECT_FALSE(item);
+
+  std::unique_ptr<int> popped;
+  ASSERT_EQ(ring.TryPop(&popped, 1), 1u);
+  ASSERT_TRUE(popped);
+  EXPECT_EQ(*popped, 5);
+}
+
+TEST(SpscRing, Threads) {
+  constexpr uint64_t kNumItems = 100000;
+  SpscRing<uint64_t> ring(64);
+
+  std::thread producer([&ring]() {
+    for (uint64_t i = 0; i < kNumItems; ++i) {
+      while (ring.TryPush(&i, 1) == 0)
+        std::this_thread::yield();
+    }
+  });
+
+  uint64_t expected = 0;
+  uint64_t batch[16];
+  while (expected < kNumItems) {
+    size_t count = ring.TryPop(batch, 16);
+    if (count == 0)
+      std::this_thread::yield();
+    for (size_t i = 0; i < count; ++i)
+      ASSERT_EQ(batch[i], expected++);
+  }
+  producer.join();
+}
+
+TEST(Pipeline, ProcessInOrder) {
+  constexpr int kNumItems = 10000;
+  std::vector<int> results;
+
+  Pipeline<int> pipeline(16, 4);
+  pipeline.AddStage([](int& x) { x *= 2; });
+  pipeline.AddStage([](int& x) { x += 1; });
+  pipeline.AddStage([&results](int& x) { results.push_back(x); });
+  pipeline.Start();
+
+  for (int i = 0; i < kNumItems; ++i)
+    pipeline.Push(i);
+  pipeline.Close();
+
+  ASSERT_EQ(results.size(), static_cast<size_t>(kNumItems));
+  for (int i = 0; i < kNumItems; ++i)
+    ASSERT_EQ(results[i], 2 * i + 1);
+
+  for (size_t i = 0; i < pipeline.num_stages(); ++i) {
+    StageStats stats = pipeline.GetStats(i);
+    EXPECT_EQ(stats.items, static_cast<uint64_t>(kNumItems));
+    EXPECT_GT(stats.batches, 0u);
+    EXPECT_LE(stats.batches, stats.items);
+    EXPECT_GE(stats.batches * 4, stats.items);
+  }
+}
+
+TEST(Pipeline, Backpressure) {
+  constexpr int kNumItems = 200;
+  std::atomic<int> sum(0);
+
+  // A slow final stage makes the previous ones wait for it.
+  Pipeline<int> pipeline(4, 2);
+  pipeline.AddStage([](int& x) { x += 1; });
+  pipeline.AddStage([&sum](int& x) {
+    std::this_thread::sleep_for(std::chrono::microseconds(50));
+    sum += x;
+  });
+  pipeline.Start();
+
+  for (int i = 0; i < kNumItems; ++i)
+    pipeline.Push(i);
+  pipeline.Close();
+
+  EXPECT_EQ(sum, kNumItems * (kNumItems + 1) / 2);
+  EXPECT_GT(pipeline.GetStats(0).stalls + pipeline.push_stalls(), 0u);
+}
+
+TEST(Pipeline, TryPushWhenFull) {
+  Pipeline<std::unique_ptr<int>> pipeline(2);
+  std::vector<int> results;
+  pipeline.AddStage([&results](std::unique_ptr<int>& x) {
+    results.push_back(*x);
+  });
+
+  // Not started, so nothing consumes the items.
+  std::unique_ptr<int> item(new int(1));
+  EXPECT_TRUE(pipeline.TryPush(item));
+  item.reset(new int(2));
+  EXPECT_TRUE(pipeline.TryPush(item));
+  item.reset(new int(3));
+  EXPECT_FALSE(pipeline.TryPush(item));
+  ASSERT_TRUE(item);
+
+  pipeline.Start();
+  pipeline.Close();
+  EXPECT_EQ(results, std::vector<int>({1, 2}));
+}
+
+TEST(Pipeline, CloseEmpty) {
+  Pipeline<int> pipeline;
+  pipeline.AddStage([](int&) {});
+  pipeline.AddStage([](int&) {});
+  pipeline.Start();
+  pipeline.Close();
+  EXPECT_EQ(pipeline.GetStats(1).items, 0u);
+}
+
+TEST(Pipeline, IdleStagesBlock) {
+  std::atomic<int> sum(0);
+  Pipeline<int> pipeline(4, 2);
+  pipeline.AddStage([](int& x) { x += 1; });
+  pipeline.AddStage([](int& x) { x *= 2; });
+  pipeline.AddStage([&sum](int& x) { sum += x; });
+  pipeline.Start();
+
+  // Idle stages must block instead of spinning. Busy stages would use about
+  // as much CPU time as the sleep for each stage.
+  std::clock_t start = std::clock();
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  double cpu_seconds = static_cast<double>(std::clock() - start) /
+                       CLOCKS_PER_SEC;
+  EXPECT_LT(cpu_seconds, 0.05);
+
+  // Blocked stages wake up when items arrive.
+  for (int i = 0; i < 100; ++i)
+    pipeline.Push(i);
+  pipeline.Close();
+  EXPECT_EQ(sum, 100 * 101);
+}
+
+#if defined(__linux__)
+TEST(Pipeline, PinnedStages) {
+  // Pin the stage to any CPU this process is allowed to run on.
+  cpu_set_t cpus;
+  ASSERT_EQ(sched_getaffinity(0, sizeof(cpus), &cpus), 0);
+  int cpu = 0;
+  while (!CPU_ISSET(cpu, &cpus))
+    ++cpu;
+
+  std::atomic<int> wrong_cpu(0);
+  Pipeline<int> pipeline;
+  pipeline.AddStage([cpu, &wrong_cpu](int&) {
+    if (sched_getcpu() != cpu)
+      ++wrong_cpu;
+  }, cpu);
+  pipeline.Start();
+
+  for (int i = 0; i < 100; ++i)
+    pipeline.Push(i);
+  pipeline.Close();
+  EXPECT_EQ(pipeline.GetStats(0).items, 100u);
+  EXPECT_EQ(wrong_cpu, 0);
+}
+#endif
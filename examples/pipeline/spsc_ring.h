@@ -0,0 +1,140 @@
+// Copyright (c) 2020, Leandro Graciá Gil
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MAGIC_FUNC_EXAMPLES_PIPELINE_SPSC_RING_H_
+#define MAGIC_FUNC_EXAMPLES_PIPELINE_SPSC_RING_H_
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+#include <magic_func/cache_line_isolated.h>
+
+// Bounded lock-free ring buffer for a single producer and a single consumer.
+//
+// Items are pushed and popped in batches, which only need one atomic update
+// of the shared indices each. Each side also keeps a cached copy of the index
+// of the other side, so that the cache line holding it is only read when the
+// cached value says that the ring looks full or empty.
+//
+// Items must be default-constructible and move-assignable.
+template <typename T>
+class SpscRing {
+ public:
+  // Creates a ring able to hold at least the given number of items.
+  // Capacity is rounded up to a power of two.
+  explicit SpscRing(size_t capacity);
+
+  SpscRing(const SpscRing&) = delete;
+  SpscRing& operator =(const SpscRing&) = delete;
+
+  // Moves up to count items into the ring. Returns how many were pushed,
+  // which can be less than requested if the ring is full.
+  // Must only be called by the producer.
+  size_t TryPush(T* items, size_t count);
+
+  // Moves up to max_count items out of the ring. Returns how many were
+  // popped, which is zero if the ring is empty.
+  // Must only be called by the consumer.
+  size_t TryPop(T* items, size_t max_count);
+
+  // Returns the number of items in the ring. Can be called from any thread,
+  // but might be outdated by the time it returns if the ring is in use.
+  size_t size() const {
+    size_t head = head_.load(std::memory_order_acquire);
+    return tail_.load(std::memory_order_acquire) - head;
+  }
+
+  size_t capacity() const { return mask_ + 1; }
+
+ private:
+  std::unique_ptr<T[]> buffer_;
+  size_t mask_;
+
+  // Written by the consumer. Padded to avoid false sharing with the producer.
+  char padding0_[mf::kCacheLineSize];
+  std::atomic<size_t> head_;
+  size_t cached_tail_;
+
+  // Written by the producer.
+  char padding1_[mf::kCacheLineSize];
+  std::atomic<size_t> tail_;
+  size_t cached_head_;
+  char padding2_[mf::kCacheLineSize];
+};
+
+template <typename T>
+SpscRing<T>::SpscRing(size_t capacity)
+    : head_(0), cached_tail_(0), tail_(0), cached_head_(0) {
+  size_t size = 1;
+  while (size < capacity)
+    size <<= 1;
+  buffer_.reset(new T[size]);
+  mask_ = size - 1;
+}
+
+template <typename T>
+size_t SpscRing<T>::TryPush(T* items, size_t count) {
+  size_t tail = tail_.load(std::memory_order_relaxed);
+  size_t free_slots = capacity() - (tail - cached_head_);
+  if (free_slots < count) {
+    cached_head_ = head_.load(std::memory_order_acquire);
+    free_slots = capacity() - (tail - cached_head_);
+  }
+
+  if (count > free_slots)
+    count = free_slots;
+  for (size_t i = 0; i < count; ++i)
+    buffer_[(tail + i) & mask_] = std::move(items[i]);
+
+  if (count > 0)
+    tail_.store(tail + count, std::memory_order_release);
+  return count;
+}
+
+template <typename T>
+size_t SpscRing<T>::TryPop(T* items, size_t max_count) {
+  size_t head = head_.load(std::memory_order_relaxed);
+  size_t available = cached_tail_ - head;
+  if (available < max_count) {
+    cached_tail_ = tail_.load(std::memory_order_acquire);
+    available = cached_tail_ - head;
+  }
+
+  size_t count = available < max_count ? available : max_count;
+  for (size_t i = 0; i < count; ++i)
+    items[i] = std::move(buffer_[(head + i) & mask_]);
+
+  if (count > 0)
+    head_.store(head + count, std::memory_order_release);
+  return count;
+}
+
+#endif  // MAGIC_FUNC_EXAMPLES_PIPELINE_SPSC_RING_H_
@@ -0,0 +1,89 @@
+// Copyright (c) 2016, Leandro Graciá Gil
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MAGIC_FUNC_EXAMPLES_PIPELINE_WAITER_H_
+#define MAGIC_FUNC_EXAMPLES_PIPELINE_WAITER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+// Lets threads block until a condition changed by another thread holds.
+//
+// Designed for lock-free structures like SpscRing: the thread changing the
+// condition calls Notify after doing so, which only takes a lock if some
+// thread is actually waiting. Both sides use a sequentially consistent fence
+// so that either the notifying thread sees the waiter or the waiter sees the
+// new state, and no wakeups are lost.
+class Waiter {
+ public:
+  Waiter() : num_waiters_(0) {}
+
+  Waiter(const Waiter&) = delete;
+  Waiter& operator =(const Waiter&) = delete;
+
+  // Blocks until the predicate returns true.
+  template <typename Predicate>
+  void Wait(Predicate predicate);
+
+  // Wakes up any threads waiting. Must be called after changing the state
+  // checked by their predicates.
+  void Notify();
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  std::atomic<int> num_waiters_;
+};
+
+template <typename Predicate>
+void Waiter::Wait(Predicate predicate) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  num_waiters_.fetch_add(1, std::memory_order_relaxed);
+
+  // Pairs with the fence in Notify. Either the predicate sees the new state,
+  // or Notify sees this waiter and takes the lock to wake it up.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  condition_.wait(lock, predicate);
+  num_waiters_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+inline void Waiter::Notify() {
+  // Orders the changes to the state before reading the number of waiters.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (num_waiters_.load(std::memory_order_relaxed) == 0)
+    return;
+
+  // Waiters hold the lock from before checking the predicate until they
+  // block, so taking it here ensures that they do not miss the notification.
+  std::lock_guard<std::mutex> lock(mutex_);
+  condition_.notify_all();
+}
+
+#endif  // MAGIC_FUNC_EXAMPLES_PIPELINE_WAITER_H_
@@ -0,0 +1,106 @@
+// Copyright (c) 2020, Leandro Graciá Gil
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <iostream>
+
+#include "state_machine.h"
+
+namespace {
+
+enum class State { kDisconnected, kConnected, kHandshaking, kReady, kCount };
+enum class Event { kConnect, kAuthenticate, kMessage, kDisconnect, kCount };
+
+// Protocol handler the state machine operates on.
+class Connection {
+ public:
+  void OnConnected() { std::cout << "Connected." << std::endl; }
+  void OnDisconnected() { std::cout << "Disconnected." << std::endl; }
+  void SendHello() { std::cout << "Sending hello." << std::endl; }
+  void Authenticate() { std::cout << "Authenticating." << std::endl; }
+  void Reject() { std::cout << "Rejecting, no credentials." << std::endl; }
+  void Process() { std::cout << "Processing message." << std::endl; }
+  bool HasCredentials() const { return has_credentials_; }
+
+  void set_has_credentials(bool value) { has_credentials_ = value; }
+
+ private:
+  bool has_credentials_ = false;
+};
+
+void Drop(Connection&) { std::cout << "Dropping early message." << std::endl; }
+
+using Traits = StateMachineTraits<Connection, State, Event>;
+using Action = Traits::Action;
+using Guard = Traits::Guard;
+
+// Built at compile time into dense arrays.
+constexpr auto kProtocol = MakeStateMachineTable<Connection, State, Event>({
+    {State::kDisconnected},
+    {State::kConnected, Traits::kNoState, State::kHandshaking,
+     Action::FromMemberFunction<&Connection::OnConnected>(),
+     Action::FromMemberFunction<&Connection::OnDisconnected>()},
+    {State::kHandshaking, State::kConnected, Traits::kNoState,
+     Action::FromMemberFunction<&Connection::SendHello>()},
+    {State::kReady, State::kConnected},
+}, {
+    // Handled by Connected, so it applies to all of its substates.
+    {State::kConnected, Event::kDisconnect, State::kDisconnected},
+    {State::kDisconnected, Event::kConnect, State::kConnected},
+    {State::kHandshaking, Event::kAuthenticate, State::kReady,
+     Guard::FromMemberFunction<&Connection::HasCredentials>(),
+     Action::FromMemberFunction<&Connection::Authenticate>()},
+    {State::kHandshaking, Event::kAuthenticate, Traits::kNoState, nullptr,
+     Action::FromMemberFunction<&Connection::Reject>()},
+    {State::kHandshaking, Event::kMessage, Traits::kNoState, nullptr,
+     Action::FromFunction<&Drop>()},
+    {State::kReady, Event::kMessage, Traits::kNoState, nullptr,
+     Action::FromMemberFunction<&Connection::Process>()},
+});
+
+}  // anonymous namespace
+
+int main() {
+  Connection connection;
+  StateMachine<decltype(kProtocol)> machine(kProtocol, &connection);
+  machine.Start(State::kDisconnected);
+
+  machine.Fire(Event::kConnect);
+  machine.Fire(Event::kMessage);
+  machine.Fire(Event::kAuthenticate);
+
+  connection.set_has_credentials(true);
+  machine.Fire(Event::kAuthenticate);
+  machine.Fire(Event::kMessage);
+
+  if (!machine.Fire(Event::kConnect))
+    std::cout << "Already connected." << std::endl;
+
+  machine.Fire(Event::kDisconnect);
+  return 0;
+}
@@ -0,0 +1,486 @@
+// Copyright (c) 2020, Leandro Graciá Gil
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MAGIC_FUNC_EXAMPLES_STATE_MACHINE_STATE_MACHINE_H_
+#define MAGIC_FUNC_EXAMPLES_STATE_MACHINE_STATE_MACHINE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include <magic_func/error.h>
+#include <magic_func/function_traits.h>
+#include <magic_func/make_function.h>
+
+namespace state_machine_internal {
+
+// Guard or action of a state machine, called with the context object.
+//
+// Like with mf::Function, targets are provided as template arguments. The
+// object stores the address of a small thunk calling the target through the
+// Function or MemberFunction that MF_MakeFunction builds for it, which the
+// compiler reduces to a direct call that can be inlined.
+//
+// Whether a target is set is tracked explicitly rather than by comparing the
+// thunk address against null, which some compilers do not accept in constant
+// expressions (e.g. GCC with sanitizers enabled).
+template <typename Signature>
+class Target;
+
+template <typename Return, typename Context>
+class Target<Return(Context&)> {
+ public:
+  // Member functions with the qualifications of the context.
+  using MemberFuncPtr =
+      mf::CopyCV<Return(), Context> std::remove_cv_t<Context>::*;
+
+  constexpr Target() = default;
+  constexpr Target(std::nullptr_t) {}
+
+  template <Return (*func_ptr)(Context&)>
+  static constexpr Target FromFunction() {
+    return Target(&Call<Return (*)(Context&), func_ptr>);
+  }
+
+  template <MemberFuncPtr func_ptr>
+  static constexpr Target FromMemberFunction() {
+    return Target(&Call<MemberFuncPtr, func_ptr>);
+  }
+
+  constexpr explicit operator bool() const { return is_set_; }
+
+  Return operator ()(Context& context) const { return thunk_(context); }
+
+ private:
+  constexpr explicit Target(Return (*thunk)(Context&))
+      : thunk_(thunk), is_set_(true) {}
+
+  template <typename FuncPtr, FuncPtr func_ptr>
+  static Return Call(Context& context) {
+    return mf::make_function<FuncPtr, func_ptr>()(context);
+  }
+
+  Return (*thunk_)(Context&) = nullptr;
+  bool is_set_ = false;
+};
+
+}  // namespace state_machine_internal
+
+// Types used to declare the states and transitions of a state machine.
+//
+// States and events are enumerations with consecutive values starting at 0,
+// and a final kCount value telling how many there are. Context is the type of
+// the object the machine operates on, which is passed to guards and actions.
+template <typename Context, typename State, typename Event>
+struct StateMachineTraits {
+  using ContextType = Context;
+  using StateType = State;
+  using EventType = Event;
+
+  enum : size_t { kNumStates = static_cast<size_t>(State::kCount) };
+  enum : size_t { kNumEvents = static_cast<size_t>(Event::kCount) };
+
+  // Used as parent by top-level states, as initial substate by states without
+  // substates, and as target by internal transitions.
+  static constexpr State kNoState = State::kCount;
+
+  // Actions run on transitions and when entering or exiting states.
+  using Action = state_machine_internal::Target<void(Context&)>;
+
+  // Conditions that must hold for a transition to be taken.
+  using Guard = state_machine_internal::Target<bool(const Context&)>;
+
+  // Declaration of a state.
+  //
+  // Composite states have an initial substate that is entered right after
+  // them. Substates inherit the transitions of their parents.
+  struct StateDecl {
+    State state;
+    State parent = kNoState;
+    State initial = kNoState;
+    Action on_entry = nullptr;
+    Action on_exit = nullptr;
+  };
+
+  // Declaration of a transition taken when an event happens in a state.
+  //
+  // Several transitions can be declared for the same state and event with
+  // different guards. They are tried in declaration order, and the first one
+  // whose guard holds is taken. Internal transitions use kNoState as target
+  // and only run their action, without exiting or entering any states.
+  struct TransitionDecl {
+    State source;
+    Event event;
+    State target;
+    Guard guard = nullptr;
+    Action action = nullptr;
+  };
+};
+
+template <typename Context, typename State, typename Event>
+constexpr State StateMachineTraits<Context, State, Event>::kNoState;
+
+// Hierarchical state machine transition table built at compile time.
+//
+// Declarations are compiled into dense arrays indexed by state and event, so
+// firing an event costs a table read plus calls to the guards and actions
+// involved through their thunks. No heap memory or startup initialization is
+// required. The table holds no runtime state and can be shared by any number
+// of StateMachine objects.
+//
+// Example:
+// using Traits = StateMachineTraits<Door, State, Event>;
+// using Action = Traits::Action;
+//
+// constexpr auto kDoorTable = MakeStateMachineTable<Door, State, Event>({
+//     {State::kOpen},
+//     {State::kClosed},
+// }, {
+//     {State::kOpen, Event::kPush, State::kClosed, nullptr,
+//      Action::FromMemberFunction<&Door::Lock>()},
+//     {State::kClosed, Event::kPull, State::kOpen},
+// });
+template <typename Context, typename State, typename Event,
+          size_t NumTransitions>
+class StateMachineTable : public StateMachineTraits<Context, State, Event> {
+ public:
+  using Traits = StateMachineTraits<Context, State, Event>;
+  using typename Traits::Action;
+  using typename Traits::Guard;
+  using typename Traits::StateDecl;
+  using typename Traits::TransitionDecl;
+  using Traits::kNumStates;
+  using Traits::kNumEvents;
+
+  static_assert(NumTransitions < UINT16_MAX, "Too many transitions.");
+
+  // Builds the table from the declarations of every state and transition.
+  //
+  // Meant to be evaluated at compile time, where invalid declarations make the
+  // build fail. Tables built at runtime check them with MAGIC_FUNC_CHECK,
+  // raising mf::Error::kInvalidObject.
+  constexpr StateMachineTable(const StateDecl (&states)[kNumStates],
+                              const TransitionDecl (&transitions)[
+                                  NumTransitions]);
+
+  // Fires an event in the current state, updating it if a transition is
+  // taken. Returns false if the event is not handled by the current state or
+  // any of its ancestors.
+  bool Fire(State& state, Context& context, Event event) const;
+
+  // Enters a state from outside of the machine, including its initial
+  // substates. Updates the current state to the innermost one entered.
+  void Enter(State& state, Context& context, State target) const;
+
+  // Tells if a state is the given one or any of its descendants.
+  constexpr bool IsIn(State state, State ancestor) const {
+    for (size_t s = Index(state); s != kNone; s = states_[s].parent) {
+      if (s == Index(ancestor))
+        return true;
+    }
+    return false;
+  }
+
+ private:
+  enum : size_t { kNone = kNumStates };
+  enum : uint16_t { kNoTransition = UINT16_MAX };
+
+  struct StateInfo {
+    size_t parent = kNone;
+    size_t initial = kNone;
+    size_t depth = 0;
+    Action on_entry = nullptr;
+    Action on_exit = nullptr;
+  };
+
+  struct TransitionInfo {
+    Guard guard = nullptr;
+    Action action = nullptr;
+    size_t target = kNone;
+
+    // Innermost common ancestor of the source and the target. States are
+    // exited up to it, and entered from below it down to the target.
+    size_t ancestor = kNone;
+
+    // Innermost state entered, after the initial substates of the target.
+    size_t leaf = kNone;
+
+    // Tells if any of the states entered has an entry action.
+    bool has_entry_actions = false;
+
+    // Next transition for the same state and event.
+    uint16_t next = kNoTransition;
+  };
+
+  static constexpr size_t Index(State state) {
+    return static_cast<size_t>(state);
+  }
+
+  // Finds the innermost common ancestor of the source and the target of a
+  // transition. Self transitions exit and enter the source state again.
+  constexpr size_t FindAncestor(size_t source, size_t target) const;
+
+  // Takes a transition.
+  void Transit(State& state, Context& context,
+               const TransitionInfo& transition) const;
+
+  // Enters the states from below an ancestor down to a target.
+  void EnterPath(size_t ancestor, size_t target, Context& context) const;
+
+  // Enters the states from below an ancestor down to a target and then into
+  // its initial substates. Returns the innermost state entered.
+  size_t EnterFrom(size_t ancestor, size_t target, Context& context) const;
+
+  StateInfo states_[kNumStates];
+  TransitionInfo transitions_[NumTransitions];
+
+  // First transition for each state and event.
+  uint16_t first_[kNumStates][kNumEvents];
+};
+
+// Builds a StateMachineTable deducing the number of transitions.
+template <typename Context, typename State, typename Event,
+          size_t NumTransitions>
+constexpr StateMachineTable<Context, State, Event, NumTransitions>
+MakeStateMachineTable(
+    const typename StateMachineTraits<Context, State, Event>::StateDecl (
+        &states)[StateMachineTraits<Context, State, Event>::kNumStates],
+    const typename StateMachineTraits<Context, State, Event>::TransitionDecl (
+        &transitions)[NumTransitions]) {
+  return StateMachineTable<Context, State, Event, NumTransitions>(
+      states, transitions);
+}
+
+// Running instance of a state machine operating on a context object.
+//
+// The caller must ensure that both the table and the context outlive it.
+template <typename Table>
+class StateMachine {
+ public:
+  using Context = typename Table::ContextType;
+  using State = typename Table::StateType;
+  using Event = typename Table::EventType;
+
+  StateMachine(const Table& table, Context* context)
+      : table_(table), context_(context), state_(Table::kNoState) {}
+
+  // Enters the initial state, running its entry actions.
+  void Start(State initial) { table_.Enter(state_, *context_, initial); }
+
+  // Fires an event. Returns false if it was not handled.
+  bool Fire(Event event) { return table_.Fire(state_, *context_, event); }
+
+  // Returns the innermost current state.
+  State state() const { return state_; }
+
+  // Tells if the machine is in a state, directly or in any of its substates.
+  bool IsIn(State state) const {
+    return state_ != Table::kNoState && table_.IsIn(state_, state);
+  }
+
+ private:
+  const Table& table_;
+  Context* context_;
+  State state_;
+};
+
+// Builds the transition table.
+template <typename Context, typename State, typename Event,
+          size_t NumTransitions>
+constexpr StateMachineTable<Context, State, Event, NumTransitions>::
+StateMachineTable(const StateDecl (&states)[kNumStates],
+                  const TransitionDecl (&transitions)[NumTransitions])
+    : states_(), transitions_(), first_() {
+  // Every state must be declared exactly once.
+  bool declared[kNumStates] = {};
+  for (size_t i = 0; i < kNumStates; ++i) {
+    size_t state = Index(states[i].state);
+    MAGIC_FUNC_CHECK(state < kNumStates && !declared[state],
+                     mf::Error::kInvalidObject);
+    declared[state] = true;
+
+    states_[state].parent = Index(states[i].parent);
+    states_[state].initial = Index(states[i].initial);
+    states_[state].on_entry = states[i].on_entry;
+    states_[state].on_exit = states[i].on_exit;
+  }
+
+  // Compute depths, which also detects cycles among parents.
+  for (size_t state = 0; state < kNumStates; ++state) {
+    size_t depth = 0;
+    for (size_t s = states_[state].parent; s != kNone; s = states_[s].parent) {
+      MAGIC_FUNC_CHECK(s < kNumStates && depth + 1 < kNumStates,
+                       mf::Error::kInvalidObject);
+      ++depth;
+    }
+    states_[state].depth = depth;
+
+    // Initial substates must be children of their state.
+    size_t initial = states_[state].initial;
+    MAGIC_FUNC_CHECK(initial == kNone ||
+                     (initial < kNumStates && states_[initial].parent == state),
+                     mf::Error::kInvalidObject);
+  }
+
+  for (size_t state = 0; state < kNumStates; ++state) {
+    for (size_t event = 0; event < kNumEvents; ++event)
+      first_[state][event] = kNoTransition;
+  }
+
+  // Chain transitions of the same state and event in declaration order.
+  for (size_t i = NumTransitions; i-- > 0;) {
+    size_t source = Index(transitions[i].source);
+    size_t event = static_cast<size_t>(transitions[i].event);
+    MAGIC_FUNC_CHECK(source < kNumStates && event < kNumEvents,
+                     mf::Error::kInvalidObject);
+
+    size_t target = Index(transitions[i].target);
+    MAGIC_FUNC_CHECK(target <= kNumStates, mf::Error::kInvalidObject);
+
+    transitions_[i].target = target;
+    if (target != kNone) {
+      size_t ancestor = FindAncestor(source, target);
+      bool has_entry_actions = false;
+      for (size_t s = target; s != ancestor; s = states_[s].parent)
+        has_entry_actions |= static_cast<bool>(states_[s].on_entry);
+
+      size_t leaf = target;
+      while (states_[leaf].initial != kNone) {
+        leaf = states_[leaf].initial;
+        has_entry_actions |= static_cast<bool>(states_[leaf].on_entry);
+      }
+
+      transitions_[i].ancestor = ancestor;
+      transitions_[i].leaf = leaf;
+      transitions_[i].has_entry_actions = has_entry_actions;
+    }
+    transitions_[i].guard = transitions[i].guard;
+    transitions_[i].action = transitions[i].action;
+    transitions_[i].next = first_[source][event];
+    first_[source][event] = static_cast<uint16_t>(i);
+  }
+}
+
+template <typename Context, typename State, typename Event,
+          size_t NumTransitions>
+bool StateMachineTable<Context, State, Event, NumTransitions>::Fire(
+    State& state, Context& context, Event event) const {
+  size_t event_index = static_cast<size_t>(event);
+  for (size_t s = Index(state); s != kNone; s = states_[s].parent) {
+    for (uint16_t i = first_[s][event_index]; i != kNoTransition;
+         i = transitions_[i].next) {
+      const TransitionInfo& transition = transitions_[i];
+      if (transition.guard && !transition.guard(context))
+        continue;
+
+      Transit(state, context, transition);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+template <typename Context, typename State, typename Event,
+          size_t NumTransitions>
+void StateMachineTable<Context, State, Event, NumTransitions>::Enter(
+    State& state, Context& context, State target) const {
+  state = static_cast<State>(EnterFrom(kNone, Index(target), context));
+}
+
+template <typename Context, typename State, typename Event,
+          size_t NumTransitions>
+constexpr size_t
+StateMachineTable<Context, State, Event, NumTransitions>::FindAncestor(
+    size_t source, size_t target) const {
+  size_t ancestor = source;
+  size_t other = target;
+  while (states_[ancestor].depth > states_[other].depth)
+    ancestor = states_[ancestor].parent;
+  while (states_[other].depth > states_[ancestor].depth)
+    other = states_[other].parent;
+  while (ancestor != other) {
+    ancestor = states_[ancestor].parent;
+    other = states_[other].parent;
+  }
+
+  return ancestor == target ? states_[ancestor].parent : ancestor;
+}
+
+template <typename Context, typename State, typename Event,
+          size_t NumTransitions>
+void StateMachineTable<Context, State, Event, NumTransitions>::Transit(
+    State& state, Context& context, const TransitionInfo& transition) const {
+  if (transition.target == kNone) {
+    if (transition.action)
+      transition.action(context);
+    return;
+  }
+
+  size_t ancestor = transition.ancestor;
+  for (size_t s = Index(state); s != ancestor; s = states_[s].parent) {
+    if (states_[s].on_exit)
+      states_[s].on_exit(context);
+  }
+
+  if (transition.action)
+    transition.action(context);
+
+  if (transition.has_entry_actions)
+    EnterFrom(ancestor, transition.target, context);
+  state = static_cast<State>(transition.leaf);
+}
+
+template <typename Context, typename State, typename Event,
+          size_t NumTransitions>
+void StateMachineTable<Context, State, Event, NumTransitions>::EnterPath(
+    size_t ancestor, size_t target, Context& context) const {
+  // Entry actions run from the outermost state inwards.
+  size_t parent = states_[target].parent;
+  if (parent != ancestor)
+    EnterPath(ancestor, parent, context);
+  if (states_[target].on_entry)
+    states_[target].on_entry(context);
+}
+
+template <typename Context, typename State, typename Event,
+          size_t NumTransitions>
+size_t StateMachineTable<Context, State, Event, NumTransitions>::EnterFrom(
+    size_t ancestor, size_t target, Context& context) const {
+  EnterPath(ancestor, target, context);
+  while (states_[target].initial != kNone) {
+    target = states_[target].initial;
+    if (states_[target].on_entry)
+      states_[target].on_entry(context);
+  }
+
+  return target;
+}
+
+#endif  // MAGIC_FUNC_EXAMPLES_STATE_MACHINE_STATE_MACHINE_H_
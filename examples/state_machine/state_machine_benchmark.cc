@@ -0,0 +1,189 @@
+// Copyright (c) 2020, Leandro Graciá Gil
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <utility>
+
+#include <magic_func/function.h>
+
+#include "state_machine.h"
+
+static constexpr size_t kNumExperiments = 20;
+static constexpr size_t kNumEvents = 1000000;
+static constexpr size_t kNumSequenceEvents = 1024;
+
+using Clock = std::chrono::high_resolution_clock;
+
+enum class State {
+  k0, k1, k2, k3, k4, k5, k6, k7, k8, k9, k10, k11, k12, k13, k14, k15, kCount
+};
+
+enum class Event { kNext, kSkip, kBack, kCount };
+
+static constexpr size_t kNumStates = static_cast<size_t>(State::kCount);
+static constexpr size_t kNumEventTypes = static_cast<size_t>(Event::kCount);
+
+struct Counter {
+  void Increment() { ++count; }
+  size_t count = 0;
+};
+
+using Traits = StateMachineTraits<Counter, State, Event>;
+using Action = Traits::Action;
+
+// Target state of each event in a ring of states.
+constexpr State GetTarget(size_t state, size_t event) {
+  return static_cast<State>(
+      (state + (event == 0 ? 1 : event == 1 ? 2 : kNumStates - 1)) %
+      kNumStates);
+}
+
+struct Declarations {
+  Traits::StateDecl states[kNumStates];
+  Traits::TransitionDecl transitions[kNumStates * kNumEventTypes];
+};
+
+constexpr Declarations MakeDeclarations() {
+  Declarations declarations{};
+  for (size_t state = 0; state < kNumStates; ++state) {
+    declarations.states[state].state = static_cast<State>(state);
+    for (size_t event = 0; event < kNumEventTypes; ++event) {
+      Traits::TransitionDecl& transition =
+          declarations.transitions[state * kNumEventTypes + event];
+      transition.source = static_cast<State>(state);
+      transition.event = static_cast<Event>(event);
+      transition.target = GetTarget(state, event);
+      transition.action = Action::FromMemberFunction<&Counter::Increment>();
+    }
+  }
+  return declarations;
+}
+
+constexpr Declarations kDeclarations = MakeDeclarations();
+constexpr auto kTable = MakeStateMachineTable<Counter, State, Event>(
+    kDeclarations.states, kDeclarations.transitions);
+
+namespace {
+
+// Measures the mean time and standard deviation in nanoseconds per event of
+// running a provided experiment that fires kNumEvents events.
+template <typename Experiment>
+void TestEvents(double& mean, double& stdev, Experiment&& experiment) {
+  std::unique_ptr<double[]> experiment_mean(new double[kNumExperiments]);
+  mean = 0.0;
+
+  for (size_t i = 0; i < kNumExperiments; ++i) {
+    auto start = Clock::now();
+    experiment();
+    auto end = Clock::now();
+
+    Clock::duration duration =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+    experiment_mean[i] = (long double) duration.count() / kNumEvents;
+    mean += experiment_mean[i];
+  }
+
+  mean /= (double) kNumExperiments;
+  stdev = 0.0;
+  for (size_t i = 0; i < kNumExperiments; ++i) {
+    double diff = experiment_mean[i] - mean;
+    stdev += diff * diff;
+  }
+
+  stdev = sqrt(stdev / (double)(kNumExperiments - 1));
+}
+
+}  // anonymous namespace
+
+void BenchmarkFireEvents() {
+  std::cout << "# Firing state machine events (mean, stdev)." << std::endl;
+
+  // Pseudo-random sequence of events, so that transitions are not trivially
+  // predictable.
+  Event events[kNumSequenceEvents];
+  uint32_t seed = 1;
+  for (auto& event : events) {
+    seed = seed * 1103515245 + 12345;
+    event = static_cast<Event>((seed >> 16) % kNumEventTypes);
+  }
+
+  // Transitions stored in a map of functions returning the next state.
+  double mean_map = 0.0, stdev_map = 0.0;
+  {
+    Counter counter;
+    std::map<std::pair<State, Event>, mf::Function<State()>> transitions;
+    for (size_t state = 0; state < kNumStates; ++state) {
+      for (size_t event = 0; event < kNumEventTypes; ++event) {
+        State target = GetTarget(state, event);
+        transitions[std::make_pair(static_cast<State>(state),
+                                   static_cast<Event>(event))] =
+            [&counter, target]() {
+              counter.Increment();
+              return target;
+            };
+      }
+    }
+
+    State state = State::k0;
+    TestEvents(mean_map, stdev_map, [&]() {
+      for (size_t i = 0; i < kNumEvents; ++i) {
+        Event event = events[i % kNumSequenceEvents];
+        auto it = transitions.find(std::make_pair(state, event));
+        if (it != transitions.end())
+          state = it->second();
+      }
+    });
+  }
+  std::cout << "std::map " << mean_map << " " << stdev_map << std::endl;
+
+  double mean_table = 0.0, stdev_table = 0.0;
+  {
+    Counter counter;
+    StateMachine<decltype(kTable)> machine(kTable, &counter);
+    machine.Start(State::k0);
+    TestEvents(mean_table, stdev_table, [&]() {
+      for (size_t i = 0; i < kNumEvents; ++i)
+        machine.Fire(events[i % kNumSequenceEvents]);
+    });
+  }
+  std::cout << "StateMachine " << mean_table << " " << stdev_table
+            << std::endl;
+  std::cout << "Speed-up " << (mean_map / mean_table) << "x (map)\n"
+            << std::endl;
+}
+
+int main() {
+  BenchmarkFireEvents();
+  return 0;
+}
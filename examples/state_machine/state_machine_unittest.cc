@@ -0,0 +1,227 @@
+// Copyright (c) 2020, Leandro Graciá Gil
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <string>
+#include <vector>
+
+#include <magic_func/error.h>
+#include <gtest/gtest.h>
+
+#include "state_machine.h"
+
+namespace {
+
+enum class State { kOff, kOn, kIdle, kRunning, kCount };
+enum class Event { kPowerOn, kPowerOff, kStart, kStop, kTick, kReset,
+                   kCount };
+
+// Records everything the state machine does.
+struct Engine {
+  void EnterOn() { trace.push_back("enter on"); }
+  void ExitOn() { trace.push_back("exit on"); }
+  void EnterIdle() { trace.push_back("enter idle"); }
+  void ExitIdle() { trace.push_back("exit idle"); }
+  void EnterRunning() { trace.push_back("enter running"); }
+  void ExitRunning() { trace.push_back("exit running"); }
+  void Ignite() { trace.push_back("ignite"); }
+  void Refuse() { trace.push_back("refuse"); }
+  bool HasFuel() const { return fuel > 0; }
+
+  int fuel = 0;
+  int ticks = 0;
+  std::vector<std::string> trace;
+};
+
+void Tick(Engine& engine) { ++engine.ticks; }
+
+using Traits = StateMachineTraits<Engine, State, Event>;
+using Action = Traits::Action;
+using Guard = Traits::Guard;
+
+constexpr auto kEngineTable = MakeStateMachineTable<Engine, State, Event>({
+    {State::kOff},
+    {State::kOn, Traits::kNoState, State::kIdle,
+     Action::FromMemberFunction<&Engine::EnterOn>(),
+     Action::FromMemberFunction<&Engine::ExitOn>()},
+    {State::kIdle, State::kOn, Traits::kNoState,
+     Action::FromMemberFunction<&Engine::EnterIdle>(),
+     Action::FromMemberFunction<&Engine::ExitIdle>()},
+    {State::kRunning, State::kOn, Traits::kNoState,
+     Action::FromMemberFunction<&Engine::EnterRunning>(),
+     Action::FromMemberFunction<&Engine::ExitRunning>()},
+}, {
+    {State::kOff, Event::kPowerOn, State::kOn},
+    {State::kOn, Event::kPowerOff, State::kOff},
+    {State::kOn, Event::kReset, State::kOn},
+    {State::kIdle, Event::kStart, State::kRunning,
+     Guard::FromMemberFunction<&Engine::HasFuel>(),
+     Action::FromMemberFunction<&Engine::Ignite>()},
+    {State::kIdle, Event::kStart, Traits::kNoState, nullptr,
+     Action::FromMemberFunction<&Engine::Refuse>()},
+    {State::kRunning, Event::kStop, State::kIdle},
+    {State::kRunning, Event::kTick, Traits::kNoState, nullptr,
+     Action::FromFunction<&Tick>()},
+});
+
+using EngineStateMachine = StateMachine<decltype(kEngineTable)>;
+
+static_assert(kEngineTable.IsIn(State::kRunning, State::kOn), "Not in On.");
+static_assert(!kEngineTable.IsIn(State::kOff, State::kOn), "In On.");
+
+}  // anonymous namespace
+
+TEST(StateMachine, EnterInitialSubstates) {
+  Engine engine;
+  EngineStateMachine machine(kEngineTable, &engine);
+  machine.Start(State::kOn);
+
+  EXPECT_EQ(machine.state(), State::kIdle);
+  EXPECT_TRUE(machine.IsIn(State::kOn));
+  EXPECT_TRUE(machine.IsIn(State::kIdle));
+  EXPECT_FALSE(machine.IsIn(State::kRunning));
+  EXPECT_EQ(engine.trace,
+            std::vector<std::string>({"enter on", "enter idle"}));
+}
+
+TEST(StateMachine, Transitions) {
+  Engine engine;
+  EngineStateMachine machine(kEngineTable, &engine);
+  machine.Start(State::kOff);
+  EXPECT_TRUE(engine.trace.empty());
+
+  EXPECT_TRUE(machine.Fire(Event::kPowerOn));
+  EXPECT_EQ(machine.state(), State::kIdle);
+
+  engine.fuel = 1;
+  engine.trace.clear();
+  EXPECT_TRUE(machine.Fire(Event::kStart));
+  EXPECT_EQ(machine.state(), State::kRunning);
+  EXPECT_EQ(engine.trace, std::vector<std::string>(
+      {"exit idle", "ignite", "enter running"}));
+
+  // Not handled by Running or any of its ancestors.
+  engine.trace.clear();
+  EXPECT_FALSE(machine.Fire(Event::kStart));
+  EXPECT_FALSE(machine.Fire(Event::kPowerOn));
+  EXPECT_EQ(machine.state(), State::kRunning);
+  EXPECT_TRUE(engine.trace.empty());
+}
+
+TEST(StateMachine, InheritedTransitions) {
+  Engine engine;
+  engine.fuel = 1;
+  EngineStateMachine machine(kEngineTable, &engine);
+  machine.Start(State::kOn);
+  ASSERT_TRUE(machine.Fire(Event::kStart));
+
+  // Declared in On, taken from Running.
+  engine.trace.clear();
+  EXPECT_TRUE(machine.Fire(Event::kPowerOff));
+  EXPECT_EQ(machine.state(), State::kOff);
+  EXPECT_EQ(engine.trace,
+            std::vector<std::string>({"exit running", "exit on"}));
+}
+
+TEST(StateMachine, SelfTransitions) {
+  Engine engine;
+  engine.fuel = 1;
+  EngineStateMachine machine(kEngineTable, &engine);
+  machine.Start(State::kOn);
+  ASSERT_TRUE(machine.Fire(Event::kStart));
+
+  // Exits and enters On again, going back to its initial substate.
+  engine.trace.clear();
+  EXPECT_TRUE(machine.Fire(Event::kReset));
+  EXPECT_EQ(machine.state(), State::kIdle);
+  EXPECT_EQ(engine.trace, std::vector<std::string>(
+      {"exit running", "exit on", "enter on", "enter idle"}));
+}
+
+TEST(StateMachine, Guards) {
+  Engine engine;
+  EngineStateMachine machine(kEngineTable, &engine);
+  machine.Start(State::kIdle);
+
+  // Without fuel the second transition for the same event is taken.
+  engine.trace.clear();
+  EXPECT_TRUE(machine.Fire(Event::kStart));
+  EXPECT_EQ(machine.state(), State::kIdle);
+  EXPECT_EQ(engine.trace, std::vector<std::string>({"refuse"}));
+
+  engine.fuel = 1;
+  EXPECT_TRUE(machine.Fire(Event::kStart));
+  EXPECT_EQ(machine.state(), State::kRunning);
+}
+
+TEST(StateMachine, InternalTransitions) {
+  Engine engine;
+  engine.fuel = 1;
+  EngineStateMachine machine(kEngineTable, &engine);
+  machine.Start(State::kRunning);
+
+  engine.trace.clear();
+  EXPECT_TRUE(machine.Fire(Event::kTick));
+  EXPECT_TRUE(machine.Fire(Event::kTick));
+  EXPECT_EQ(engine.ticks, 2);
+  EXPECT_EQ(machine.state(), State::kRunning);
+  EXPECT_TRUE(engine.trace.empty());
+}
+
+TEST(StateMachine, InvalidDeclarations) {
+  using Table = decltype(kEngineTable);
+  const Traits::TransitionDecl transitions[] = {
+      {State::kOff, Event::kPowerOn, State::kOn},
+      {State::kOn, Event::kPowerOff, State::kOff},
+      {State::kOn, Event::kReset, State::kOn},
+      {State::kIdle, Event::kStart, State::kRunning},
+      {State::kIdle, Event::kStart, Traits::kNoState},
+      {State::kRunning, Event::kStop, State::kIdle},
+      {State::kRunning, Event::kTick, Traits::kNoState},
+  };
+
+  // Tables built at runtime cannot fail to compile, so they check instead.
+  const Traits::StateDecl valid[] = {
+      {State::kOff}, {State::kOn, Traits::kNoState, State::kIdle},
+      {State::kIdle, State::kOn}, {State::kRunning, State::kOn}};
+  EXPECT_NO_THROW(Table(valid, transitions));
+
+  const Traits::StateDecl duplicate[] = {
+      {State::kOff}, {State::kOn}, {State::kOn}, {State::kRunning}};
+  EXPECT_THROW(Table(duplicate, transitions), mf::Error);
+
+  const Traits::StateDecl cycle[] = {
+      {State::kOff}, {State::kOn, State::kIdle},
+      {State::kIdle, State::kOn}, {State::kRunning, State::kOn}};
+  EXPECT_THROW(Table(cycle, transitions), mf::Error);
+
+  const Traits::StateDecl initial[] = {
+      {State::kOff}, {State::kOn, Traits::kNoState, State::kOff},
+      {State::kIdle, State::kOn}, {State::kRunning, State::kOn}};
+  EXPECT_THROW(Table(initial, transitions), mf::Error);
+}
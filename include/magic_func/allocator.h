@@ -30,7 +30,10 @@
 #ifndef MAGIC_FUNC_ALLOCATOR_H_
 #define MAGIC_FUNC_ALLOCATOR_H_
 
-#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
 #include <utility>
 
 namespace mf {
@@ -90,6 +93,42 @@ inline void SetCustomAllocator(
   CustomDeallocator() = std::make_pair(deallocation_func, deallocation_context);
 }
 
+// Tells if a type has a stricter alignment than the one guaranteed by the
+// default operator new. Before C++17 such types need to be explicitly aligned
+// when allocated in the heap.
+template <typename T>
+using IsOverAligned = std::integral_constant<bool,
+    (alignof(T) > alignof(std::max_align_t))>;
+
+// Allocates memory with an alignment stricter than the default one using the
+// regular operator new, failing in the same way. Memory must be released with
+// AlignedDeallocate.
+//
+// @param size The number of bytes to allocate.
+// @param alignment The alignment of the memory. Must be a power of two.
+// @return A pointer to the allocated memory.
+inline void* AlignedAllocate(size_t size, size_t alignment) {
+  // Over-allocate and store the original address right before the aligned one.
+  if (alignment < alignof(std::max_align_t))
+    alignment = alignof(std::max_align_t);
+
+  void* memory = ::operator new(size + alignment);
+
+  // There is always room for the original address because operator new
+  // returns memory already aligned to at least alignof(std::max_align_t).
+  uintptr_t address = reinterpret_cast<uintptr_t>(memory) + alignment;
+  address &= ~(static_cast<uintptr_t>(alignment) - 1);
+  void* aligned = reinterpret_cast<void*>(address);
+  reinterpret_cast<void**>(aligned)[-1] = memory;
+  return aligned;
+}
+
+// Releases memory allocated by AlignedAllocate.
+inline void AlignedDeallocate(void* address) {
+  if (address)
+    ::operator delete(reinterpret_cast<void**>(address)[-1]);
+}
+
 }  // namespace mf
 
 #endif  // MAGIC_FUNC_ALLOCATOR_H_
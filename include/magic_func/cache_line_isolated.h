@@ -0,0 +1,105 @@
+// Copyright (c) 2020, Leandro Graciá Gil
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MAGIC_FUNC_CACHE_LINE_ISOLATED_H_
+#define MAGIC_FUNC_CACHE_LINE_ISOLATED_H_
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include <magic_func/type_traits.h>
+
+// Size in bytes of the cache lines of the target platform.
+// Can be defined before including MagicFunc to override the default value.
+#ifndef MF_CACHE_LINE_SIZE
+#define MF_CACHE_LINE_SIZE 64
+#endif
+
+namespace mf {
+
+constexpr size_t kCacheLineSize = MF_CACHE_LINE_SIZE;
+
+// Wraps a callable object so that it is stored in cache lines of its own.
+//
+// Callable objects stored in Functions are allocated in the heap, often next to
+// other unrelated allocations. If a callable has mutable state that is updated
+// frequently by one thread while other nearby objects are used by different
+// threads, they will suffer from false sharing and keep invalidating each
+// other's cache lines.
+//
+// This wrapper aligns the callable to a cache line boundary and pads its size
+// to a multiple of the cache line size, so that no other allocation can share
+// cache lines with it. This comes at the cost of extra memory, so it should be
+// used only for callables that are actually hot.
+//
+// Example:
+// size_t count = 0;
+// Function<void()> counter = MakeIsolated([count]() mutable { ++count; });
+template <typename Callable>
+class CacheLineIsolated {
+ public:
+  explicit CacheLineIsolated(const Callable& callable) : callable_(callable) {}
+  explicit CacheLineIsolated(Callable&& callable)
+      : callable_(std::move(callable)) {}
+
+  template <typename... Args>
+  auto operator ()(Args&&... args)
+      -> decltype(std::declval<Callable&>()(std::forward<Args>(args)...)) {
+    return callable_(std::forward<Args>(args)...);
+  }
+
+  template <typename... Args>
+  auto operator ()(Args&&... args) const
+      -> decltype(std::declval<const Callable&>()(
+          std::forward<Args>(args)...)) {
+    return callable_(std::forward<Args>(args)...);
+  }
+
+  // Returns the wrapped callable object.
+  Callable& get() { return callable_; }
+  const Callable& get() const { return callable_; }
+
+ private:
+  // Aligned to cache lines unless the callable requires a stricter alignment.
+  alignas(kCacheLineSize > alignof(Callable) ? kCacheLineSize
+                                             : alignof(Callable))
+  Callable callable_;
+};
+
+// Creates a CacheLineIsolated wrapper for a callable object.
+template <typename Callable>
+CacheLineIsolated<std::decay_t<Callable>> MakeIsolated(Callable&& callable) {
+  return CacheLineIsolated<std::decay_t<Callable>>(
+      std::forward<Callable>(callable));
+}
+
+}  // namespace mf
+
+#endif  // MAGIC_FUNC_CACHE_LINE_ISOLATED_H_
@@ -0,0 +1,198 @@
+// Copyright (c) 2020, Leandro Graciá Gil
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MAGIC_FUNC_CLOSED_FUNCTION_H_
+#define MAGIC_FUNC_CLOSED_FUNCTION_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include <magic_func/function.h>
+#include <magic_func/port.h>
+#include <magic_func/type_traits.h>
+
+namespace mf {
+
+// Function object that can only hold one of a closed set of free or static
+// functions, all known at compile time.
+//
+// Instead of a function pointer, only a small index is stored to tell which
+// function of the set is selected. Calls are dispatched by comparing the index
+// against each candidate and calling the matching function directly, which
+// compilers usually lower to a jump table or a short chain of conditional
+// branches. This avoids indirect calls altogether, which is valuable when they
+// are expensive (for example, when built with retpolines) or when the set is
+// small enough for the candidates to be inlined.
+//
+// Call syntax is the same as in mf::Function, and ClosedFunction objects can
+// be converted into mf::Function objects of the same signature when an open
+// set of targets is required later on.
+//
+// Example:
+// int Add(int a, int b) { return a + b; }
+// int Sub(int a, int b) { return a - b; }
+//
+// using Op = ClosedFunction<int(int, int), &Add, &Sub>;
+// Op op = Op::From<&Sub>();  // Checked at compile time.
+// op(5, 3);                  // Returns 2, calling Sub directly.
+// op = &Add;                 // Checked at runtime.
+// Function<int(int, int)> function = op;
+template <typename FunctionType, FunctionType*... func_ptrs>
+class ClosedFunction;
+
+template <typename Return, typename... Args, Return (*... func_ptrs)(Args...)>
+class ClosedFunction<Return(Args...), func_ptrs...> {
+ public:
+  static_assert(sizeof...(func_ptrs) > 0,
+                "At least one function is required.");
+
+  using FunctionPointerType = Return (*)(Args...);
+  using ReturnType = Return;
+
+  enum : size_t { kNumArgs = sizeof...(Args) };
+  enum : size_t { kNumFunctions = sizeof...(func_ptrs) };
+
+  // Smallest unsigned type able to represent the index of every function in
+  // the set plus the empty state.
+  using IndexType = std::conditional_t<(kNumFunctions < UINT8_MAX), uint8_t,
+      std::conditional_t<(kNumFunctions < UINT16_MAX), uint16_t, size_t>>;
+
+  // Index used by empty objects.
+  static constexpr IndexType kEmpty = static_cast<IndexType>(kNumFunctions);
+
+  // Returns the index of a function within the set, or kEmpty if not present.
+  template <FunctionPointerType func_ptr>
+  static constexpr IndexType IndexOf() MF_NOEXCEPT {
+    return static_cast<IndexType>(Find<func_ptr, 0, func_ptrs...>::value);
+  }
+
+  // Creates an empty ClosedFunction.
+  constexpr ClosedFunction() MF_NOEXCEPT : index_(kEmpty) {}
+  constexpr ClosedFunction(std::nullptr_t) MF_NOEXCEPT : index_(kEmpty) {}
+
+  // Creates a ClosedFunction from a function pointer.
+  //
+  // Raises an error if the function does not belong to the set. Prefer From
+  // when the function is known at compile time.
+  //
+  // This constructor is intentionally non-explicit, like the mf::Function one.
+  ClosedFunction(FunctionPointerType func_ptr);
+
+  // Creates a ClosedFunction from a function of the set known at compile time.
+  // Fails to build if the function does not belong to the set.
+  template <FunctionPointerType func_ptr>
+  static constexpr ClosedFunction From() MF_NOEXCEPT {
+    static_assert(IndexOf<func_ptr>() != kEmpty,
+                  "The function is not part of the closed set.");
+    return ClosedFunction(IndexOf<func_ptr>(), IndexTag());
+  }
+
+  // Assignment to nullptr. Clears the object.
+  ClosedFunction& operator =(std::nullptr_t) MF_NOEXCEPT {
+    index_ = kEmpty;
+    return *this;
+  }
+
+  // Calls the selected function directly. Calling an empty object raises a
+  // kInvalidFunction error.
+  inline Return operator ()(Args... args) const;
+
+  // Converts the object into a regular Function of the same signature.
+  operator Function<Return(Args...)>() const MF_NOEXCEPT;
+
+  // Tells if the object holds a function.
+  explicit operator bool() const MF_NOEXCEPT { return index_ != kEmpty; }
+
+  bool operator ==(std::nullptr_t) const MF_NOEXCEPT {
+    return index_ == kEmpty;
+  }
+
+  bool operator !=(std::nullptr_t) const MF_NOEXCEPT {
+    return index_ != kEmpty;
+  }
+
+  bool operator ==(const ClosedFunction& other) const MF_NOEXCEPT {
+    return index_ == other.index_;
+  }
+
+  bool operator !=(const ClosedFunction& other) const MF_NOEXCEPT {
+    return index_ != other.index_;
+  }
+
+  // Returns the index of the selected function within the set, or kEmpty.
+  IndexType index() const MF_NOEXCEPT { return index_; }
+
+ private:
+  struct IndexTag {};
+
+  constexpr ClosedFunction(IndexType index, IndexTag) MF_NOEXCEPT
+      : index_(index) {}
+
+  // Finds the index of a function pointer within a set at compile time.
+  template <FunctionPointerType target, size_t Index,
+            FunctionPointerType... candidates>
+  struct Find : std::integral_constant<size_t, Index> {};
+
+  template <FunctionPointerType target, size_t Index,
+            FunctionPointerType first, FunctionPointerType... rest>
+  struct Find<target, Index, first, rest...>
+      : std::integral_constant<size_t, target == first ? Index :
+            Find<target, Index + 1, rest...>::value> {};
+
+  // Recursively compares the index against each function of the set and
+  // calls the matching one directly.
+  template <size_t Index, FunctionPointerType... candidates>
+  struct Dispatcher;
+
+  template <size_t Index, FunctionPointerType last>
+  struct Dispatcher<Index, last> {
+    static Return Call(size_t index, Args... args);
+    static Function<Return(Args...)> ToFunction(size_t index) MF_NOEXCEPT;
+  };
+
+  template <size_t Index, FunctionPointerType first,
+            FunctionPointerType second, FunctionPointerType... rest>
+  struct Dispatcher<Index, first, second, rest...> {
+    static Return Call(size_t index, Args... args);
+    static Function<Return(Args...)> ToFunction(size_t index) MF_NOEXCEPT;
+  };
+
+  IndexType index_;
+};
+
+template <typename Return, typename... Args, Return (*... func_ptrs)(Args...)>
+constexpr typename ClosedFunction<Return(Args...), func_ptrs...>::IndexType
+    ClosedFunction<Return(Args...), func_ptrs...>::kEmpty;
+
+}  // namespace mf
+
+#include <magic_func/closed_function.hpp>
+
+#endif  // MAGIC_FUNC_CLOSED_FUNCTION_H_
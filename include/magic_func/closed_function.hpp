@@ -0,0 +1,116 @@
+// Copyright (c) 2020, Leandro Graciá Gil
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MAGIC_FUNC_CLOSED_FUNCTION_HPP_
+#define MAGIC_FUNC_CLOSED_FUNCTION_HPP_
+
+#include <magic_func/error.h>
+
+namespace mf {
+
+// Constructor from a function pointer.
+template <typename Return, typename... Args, Return (*... func_ptrs)(Args...)>
+ClosedFunction<Return(Args...), func_ptrs...>::ClosedFunction(
+    FunctionPointerType func_ptr) : index_(kEmpty) {
+  if (!func_ptr)
+    return;
+
+  const FunctionPointerType functions[] = { func_ptrs... };
+  for (size_t i = 0; i < kNumFunctions; ++i) {
+    if (functions[i] == func_ptr) {
+      index_ = static_cast<IndexType>(i);
+      return;
+    }
+  }
+
+  MAGIC_FUNC_CHECK(false, Error::kInvalidFunction);
+}
+
+// Parenthesis operator.
+template <typename Return, typename... Args, Return (*... func_ptrs)(Args...)>
+Return ClosedFunction<Return(Args...), func_ptrs...>::operator ()(
+    Args... args) const {
+  // Empty objects are detected when dispatching to the last function.
+  return Dispatcher<0, func_ptrs...>::Call(index_,
+                                           std::forward<Args>(args)...);
+}
+
+// Conversion into a regular Function.
+template <typename Return, typename... Args, Return (*... func_ptrs)(Args...)>
+ClosedFunction<Return(Args...), func_ptrs...>::operator
+    Function<Return(Args...)>() const MF_NOEXCEPT {
+  if (index_ == kEmpty)
+    return Function<Return(Args...)>();
+  return Dispatcher<0, func_ptrs...>::ToFunction(index_);
+}
+
+// Last function of the set. Any index reaching it must be its own, so this
+// also rejects calls to empty objects, even in release builds.
+template <typename Return, typename... Args, Return (*... func_ptrs)(Args...)>
+template <size_t Index, Return (*last)(Args...)>
+Return ClosedFunction<Return(Args...), func_ptrs...>::Dispatcher<Index, last>::
+Call(size_t index, Args... args) {
+  MAGIC_FUNC_CHECK(index == Index, Error::kInvalidFunction);
+  return last(std::forward<Args>(args)...);
+}
+
+template <typename Return, typename... Args, Return (*... func_ptrs)(Args...)>
+template <size_t Index, Return (*last)(Args...)>
+Function<Return(Args...)> ClosedFunction<Return(Args...), func_ptrs...>::
+Dispatcher<Index, last>::ToFunction(size_t index) MF_NOEXCEPT {
+  (void) index;
+  return Function<Return(Args...)>::template FromFunction<last>();
+}
+
+// Any other function of the set.
+template <typename Return, typename... Args, Return (*... func_ptrs)(Args...)>
+template <size_t Index, Return (*first)(Args...), Return (*second)(Args...),
+          Return (*... rest)(Args...)>
+Return ClosedFunction<Return(Args...), func_ptrs...>::Dispatcher<
+    Index, first, second, rest...>::Call(size_t index, Args... args) {
+  if (index == Index)
+    return first(std::forward<Args>(args)...);
+  return Dispatcher<Index + 1, second, rest...>::Call(
+      index, std::forward<Args>(args)...);
+}
+
+template <typename Return, typename... Args, Return (*... func_ptrs)(Args...)>
+template <size_t Index, Return (*first)(Args...), Return (*second)(Args...),
+          Return (*... rest)(Args...)>
+Function<Return(Args...)> ClosedFunction<Return(Args...), func_ptrs...>::
+Dispatcher<Index, first, second, rest...>::ToFunction(
+    size_t index) MF_NOEXCEPT {
+  if (index == Index)
+    return Function<Return(Args...)>::template FromFunction<first>();
+  return Dispatcher<Index + 1, second, rest...>::ToFunction(index);
+}
+
+}  // namespace mf
+
+#endif  // MAGIC_FUNC_CLOSED_FUNCTION_HPP_
@@ -0,0 +1,272 @@
+// Copyright (c) 2020, Leandro Graciá Gil
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MAGIC_FUNC_COROUTINE_H_
+#define MAGIC_FUNC_COROUTINE_H_
+
+// Coroutines require C++20. Nothing is defined otherwise.
+#if defined(__cpp_impl_coroutine)
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <optional>
+#include <utility>
+
+#include <magic_func/allocator.h>
+#include <magic_func/error.h>
+#include <magic_func/function.h>
+
+#define MF_HAS_COROUTINES 1
+
+namespace mf {
+
+// Promise base used by default, allocating coroutine frames with the global
+// operator new.
+struct DefaultPromiseBase {};
+
+// Promise base allocating coroutine frames with the MagicFunc custom allocator
+// if any, like mf::Function does with the callables it stores. See
+// SetCustomAllocator in allocator.h.
+//
+// As with functions, the custom allocator must not change while there are
+// coroutine frames allocated.
+struct CustomAllocatorPromiseBase {
+  static void* operator new(size_t size);
+  static void operator delete(void* memory, size_t size) noexcept;
+};
+
+// Lightweight coroutine task returning a value of type T.
+//
+// Tasks are lazy: coroutines start suspended, and only run when the task is
+// awaited by another coroutine or explicitly resumed. Tasks own their
+// coroutine frame and destroy it when they are destroyed.
+//
+// The promise type derives from PromiseBase, which allows to customize how
+// coroutine frames are allocated. Exceptions escaping the coroutine terminate
+// the program.
+//
+// Example:
+// Task<int> Add(int a, int b) { co_return a + b; }
+//
+// Task<int> Twice(int a) {
+//   int sum = co_await Add(a, a);
+//   co_return sum;
+// }
+//
+// Task<int> task = Twice(5);
+// task.Resume();
+// int result = task.Result();  // 10.
+template <typename T = void, typename PromiseBase = DefaultPromiseBase>
+class Task;
+
+namespace internal {
+
+// Stores the value returned by a coroutine.
+template <typename T>
+class TaskResult {
+ public:
+  template <typename U>
+  void return_value(U&& value) { result_.emplace(std::forward<U>(value)); }
+
+  T TakeResult() { return std::move(*result_); }
+
+ private:
+  std::optional<T> result_;
+};
+
+template <>
+class TaskResult<void> {
+ public:
+  void return_void() noexcept {}
+  void TakeResult() noexcept {}
+};
+
+// Resumes the coroutine awaiting a task when the task completes.
+struct TaskFinalAwaiter {
+  bool await_ready() const noexcept { return false; }
+
+  template <typename Promise>
+  std::coroutine_handle<> await_suspend(
+      std::coroutine_handle<Promise> handle) noexcept {
+    std::coroutine_handle<> continuation = handle.promise().continuation;
+    return continuation ? continuation : std::noop_coroutine();
+  }
+
+  void await_resume() const noexcept {}
+};
+
+}  // namespace internal
+
+template <typename T, typename PromiseBase>
+class Task {
+ public:
+  class promise_type : public PromiseBase, public internal::TaskResult<T> {
+   public:
+    Task get_return_object() noexcept {
+      return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    internal::TaskFinalAwaiter final_suspend() const noexcept { return {}; }
+    void unhandled_exception() const noexcept { std::terminate(); }
+
+    // Coroutine to resume when the task completes, if any.
+    std::coroutine_handle<> continuation;
+  };
+
+  using Handle = std::coroutine_handle<promise_type>;
+
+  Task() noexcept = default;
+  Task(Task&& task) noexcept : handle_(std::exchange(task.handle_, nullptr)) {}
+  ~Task() { Reset(); }
+
+  Task& operator =(Task&& task) noexcept {
+    if (this != &task) {
+      Reset();
+      handle_ = std::exchange(task.handle_, nullptr);
+    }
+    return *this;
+  }
+
+  // Tells if the task has a coroutine.
+  explicit operator bool() const noexcept { return static_cast<bool>(handle_); }
+
+  // Tells if the coroutine has completed.
+  bool done() const noexcept { return handle_ && handle_.done(); }
+
+  // Runs the coroutine until it suspends or completes. Used to start tasks
+  // that are not awaited by other coroutines.
+  void Resume() {
+    MAGIC_FUNC_DCHECK(handle_ && !handle_.done(), Error::kInvalidObject);
+    handle_.resume();
+  }
+
+  // Returns the result of a completed coroutine.
+  T Result() {
+    MAGIC_FUNC_DCHECK(done(), Error::kInvalidObject);
+    return handle_.promise().TakeResult();
+  }
+
+  // Destroys the coroutine, if any.
+  void Reset() noexcept {
+    if (handle_)
+      std::exchange(handle_, nullptr).destroy();
+  }
+
+  // Awaits the task from another coroutine, starting it and resuming the
+  // awaiting coroutine when done without going through the caller stack.
+  //
+  // The task must have a coroutine. Awaiting an empty or moved-from task is
+  // an error.
+  auto operator co_await() && {
+    MAGIC_FUNC_CHECK(handle_, Error::kInvalidObject);
+
+    struct Awaiter {
+      bool await_ready() const noexcept { return handle.done(); }
+
+      Handle await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        handle.promise().continuation = awaiting;
+        return handle;
+      }
+
+      T await_resume() { return handle.promise().TakeResult(); }
+
+      Handle handle;
+    };
+
+    return Awaiter{handle_};
+  }
+
+ private:
+  explicit Task(Handle handle) noexcept : handle_(handle) {}
+
+  Handle handle_;
+};
+
+namespace internal {
+
+template <typename Signature, typename PromiseBase>
+struct AsyncFunctionType;
+
+template <typename T, typename... Args, typename PromiseBase>
+struct AsyncFunctionType<T(Args...), PromiseBase> {
+  using Type = Function<Task<T, PromiseBase>(Args...)>;
+};
+
+}  // namespace internal
+
+// Function object wrapping coroutines that return Task<T> for a signature
+// T(Args...). Coroutines can be free functions, member functions or lambdas,
+// like with any other mf::Function.
+//
+// Coroutine frames refer to the captures of lambdas through the lambda object
+// stored in the function, so functions wrapping lambdas with captures must
+// outlive the tasks they return. Arguments are copied into the frame instead.
+//
+// Example:
+// AsyncFunction<int(int)> function = [](int x) -> Task<int> {
+//   co_return x + 1;
+// };
+// Task<int> task = function(1);
+template <typename Signature, typename PromiseBase = DefaultPromiseBase>
+using AsyncFunction =
+    typename internal::AsyncFunctionType<Signature, PromiseBase>::Type;
+
+inline void* CustomAllocatorPromiseBase::operator new(size_t size) {
+  const auto& allocator = CustomAllocator();
+  if (allocator.first) {
+    void* memory = (*allocator.first)(
+        size, __STDCPP_DEFAULT_NEW_ALIGNMENT__, allocator.second);
+    MAGIC_FUNC_CHECK(memory, Error::kCustomAllocator);
+    return memory;
+  }
+
+  return ::operator new(size);
+}
+
+inline void CustomAllocatorPromiseBase::operator delete(
+    void* memory, size_t size) noexcept {
+  const auto& deallocator = CustomDeallocator();
+  if (deallocator.first) {
+    // Errors cannot be raised from operator delete.
+    if (!(*deallocator.first)(memory, size, __STDCPP_DEFAULT_NEW_ALIGNMENT__,
+                              deallocator.second)) {
+      std::terminate();
+    }
+  } else {
+    ::operator delete(memory);
+  }
+}
+
+}  // namespace mf
+
+#endif  // defined(__cpp_impl_coroutine)
+
+#endif  // MAGIC_FUNC_COROUTINE_H_
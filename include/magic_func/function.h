@@ -30,6 +30,9 @@
 #ifndef MAGIC_FUNC_FUNCTION_H_
 #define MAGIC_FUNC_FUNCTION_H_
 
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <tuple>
 
 #include <magic_func/function_traits.h>
@@ -186,6 +189,38 @@ class Function<Return(Args...)> : public TypeErasedFunction {
   template <typename Object, CopyCV<FunctionType, Object> Object::*func_ptr>
   static Function FromMemberFunction(const std::shared_ptr<Object>& object);
 
+  // Function returning the address of the function to call.
+  using Resolver = Function<FunctionPointerType()>;
+
+  // Creates a new Function whose target is only resolved when first called.
+  //
+  // Useful for binding large numbers of functions to symbols of dynamically
+  // loaded libraries without paying the cost of looking them up at startup.
+  // The resolver is invoked during the first call, and released as soon as it
+  // returns a valid address. Later calls use that address directly. Copies of
+  // the Function share the resolved address, so each symbol is resolved once.
+  //
+  // Calls made concurrently from multiple threads are safe. Only one of them
+  // invokes the resolver while the others wait for the result.
+  //
+  // Raises an error when called if the resolver returns nullptr. In that case
+  // the resolver is kept and invoked again in the next call.
+  //
+  // Lazy resolution is not free after the first call. Creating the Function
+  // allocates the shared resolution state, and every call goes through an
+  // extra indirect call and an atomic load of the resolved address. The
+  // address is not cached in the Function itself because that would race
+  // with calls made concurrently from other threads. For functions called in
+  // hot loops, resolve the address once and wrap it in a Function instead.
+  // See BenchmarkLazyFunction for the measured costs.
+  //
+  // Example:
+  // void* library = dlopen("libplugin.so", RTLD_LAZY);
+  // auto function = Function<int(int)>::FromResolver([library]() {
+  //   return reinterpret_func<int (*)(int)>(dlsym(library, "PluginFoo"));
+  // });
+  static Function FromResolver(Resolver resolver);
+
   // Creates a new Function that binds a MemberFunction to a pointer of an
   // externally managed object. The caller is responsible to ensure the pointer
   // is valid by the time any call is made. No object ownership is taken.
@@ -260,9 +295,27 @@ class Function<Return(Args...)> : public TypeErasedFunction {
             typename = std::enable_if_t<
                 !IsFunction<Callable>::value &&
                 !IsMemberFunction<Callable>::value &&
+                !IsClosedFunction<Callable>::value &&
+                !IsInPlaceType<Callable>::value &&
                 !std::is_base_of<TypeErasedFunction, Callable>::value>>
   Function(Callable&& callable);
 
+  // Constructs a callable object of type Callable directly in the heap from
+  // the provided arguments. Unlike the constructor above, the callable object
+  // is never copied or moved, so it can also be used with callables that are
+  // expensive to move or not movable at all.
+  //
+  // Example:
+  // struct Adder {
+  //   explicit Adder(int value) : value(value) {}
+  //   int operator ()(int x) const { return x + value; }
+  //   int value;
+  // };
+  //
+  // Function<int(int)> function(InPlaceType<Adder>(), 5);
+  template <typename Callable, typename... CallableArgs>
+  explicit Function(InPlaceType<Callable>, CallableArgs&&... args);
+
   // Universal reference assignment operator for compatible callable objects.
   //
   // Callable objects are stored in the heap, either copied or moved depending
@@ -270,6 +323,9 @@ class Function<Return(Args...)> : public TypeErasedFunction {
   // and implement an operator () that has argument and return types that are
   // convertible to the function ones.
   //
+  // If the function already stores a callable object of the same type, its
+  // heap memory is reused for the new one instead of allocating more.
+  //
   // Since this method takes a universal reference, the callable object can be
   // a lvalue reference or a rvalue reference. Similarly the Callable type can
   // be a reference type.
@@ -281,12 +337,27 @@ class Function<Return(Args...)> : public TypeErasedFunction {
             typename = std::enable_if_t<
                 !IsFunction<Callable>::value &&
                 !IsMemberFunction<Callable>::value &&
+                !IsClosedFunction<Callable>::value &&
                 !std::is_base_of<TypeErasedFunction, Callable>::value>>
   Function& operator =(Callable&& callable);
 
   // Assignment to nullptr. Clears the function object.
   Function& operator =(std::nullptr_t null);
 
+  // Destroys any stored callable object and constructs one of type Callable
+  // in its place from the provided arguments, without any temporaries nor
+  // moves. Returns a reference to the new callable object.
+  //
+  // Like assignments, this reuses the heap memory of the previous callable
+  // object if it has the same type. Callables re-armed in a loop are therefore
+  // only allocated once.
+  //
+  // Example:
+  // Function<int(int)> function;
+  // function.emplace<Adder>(5);
+  template <typename Callable, typename... CallableArgs>
+  Callable& emplace(CallableArgs&&... args);
+
   // Invokes the function returning its result.
   Return operator ()(Args... args) const;
 
@@ -314,6 +385,12 @@ class Function<Return(Args...)> : public TypeErasedFunction {
   // Calls the appropriate operator () of a callable object.
   template <typename Callable>
   static Return CallCallable(void* object, Args... args);
+
+  // State of a lazily resolved function. Shared by all its copies.
+  class LazyTarget;
+
+  // Calls the target of a lazily resolved function, resolving it if needed.
+  static Return CallLazyTarget(void* object, Args... args);
 };
 
 }  // namespace mf
@@ -78,6 +78,50 @@ Function<Return(Args...)> Function<Return(Args...)>::FromMemberFunction(
   return function;
 }
 
+// State of a lazily resolved function.
+template <typename Return, typename... Args>
+class Function<Return(Args...)>::LazyTarget {
+ public:
+  explicit LazyTarget(Resolver&& resolver)
+      : resolver_(std::move(resolver)), target_(nullptr) {}
+
+  // Returns the target function, resolving it if this was not done yet.
+  FunctionPointerType Get() {
+    FunctionPointerType target = target_.load(std::memory_order_acquire);
+    return target ? target : Resolve();
+  }
+
+ private:
+  FunctionPointerType Resolve() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    FunctionPointerType target = target_.load(std::memory_order_relaxed);
+    if (target)
+      return target;
+
+    target = resolver_();
+    MAGIC_FUNC_CHECK(target, Error::kInvalidFunction);
+    target_.store(target, std::memory_order_release);
+    resolver_ = nullptr;
+    return target;
+  }
+
+  Resolver resolver_;
+  std::atomic<FunctionPointerType> target_;
+  std::mutex mutex_;
+};
+
+// Factory function for lazily resolved functions.
+template <typename Return, typename... Args>
+Function<Return(Args...)> Function<Return(Args...)>::FromResolver(
+    Resolver resolver) {
+  MAGIC_FUNC_DCHECK(resolver, Error::kInvalidFunction);
+  auto function = Function(reinterpret_func<TypeErasedFuncPtr>(
+      &CallLazyTarget));
+  function.object_.StoreObject(
+      std::make_shared<LazyTarget>(std::move(resolver)));
+  return function;
+}
+
 // Constructor for MemberFunction objects bound to an object pointer.
 template <typename Return, typename... Args>
 template <typename MemberFuncPtr, typename Object, typename>
@@ -119,6 +163,17 @@ Function<Return(Args...)>::Function(Callable&& callable)
   object_.StoreObject(std::forward<Callable>(callable));
 }
 
+// Constructor for callable objects built in place.
+template <typename Return, typename... Args>
+template <typename Callable, typename... CallableArgs>
+Function<Return(Args...)>::Function(InPlaceType<Callable>,
+                                    CallableArgs&&... args)
+    : TypeErasedFunction(
+        get_type_id<FunctionType>(),
+        reinterpret_func<TypeErasedFuncPtr>(&CallCallable<Callable>)) {
+  object_.EmplaceObject<Callable>(std::forward<CallableArgs>(args)...);
+}
+
 // Auxiliary constructor for factory methods based on function addresses and
 // member function addresses bound to objects.
 template <typename Return, typename... Args>
@@ -144,6 +199,15 @@ Function<Return(Args...)>& Function<Return(Args...)>::operator =(
   return *this;
 }
 
+// Constructs a callable object in place.
+template <typename Return, typename... Args>
+template <typename Callable, typename... CallableArgs>
+Callable& Function<Return(Args...)>::emplace(CallableArgs&&... args) {
+  func_ptr_ = reinterpret_func<TypeErasedFuncPtr>(&CallCallable<Callable>);
+  object_.EmplaceObject<Callable>(std::forward<CallableArgs>(args)...);
+  return *static_cast<Callable*>(object_.GetObject());
+}
+
 // Parenthesis operator for calling functions.
 template <typename Return, typename... Args>
 Return Function<Return(Args...)>::operator ()(Args... args) const {
@@ -163,6 +227,14 @@ Return Function<Return(Args...)>::CallFunctionAddress(void*, Args... args) {
   return func_ptr(std::forward<Args>(args)...);
 }
 
+// Auxiliary function to call the target of lazily resolved functions.
+template <typename Return, typename... Args>
+Return Function<Return(Args...)>::CallLazyTarget(void* object, Args... args) {
+  MAGIC_FUNC_DCHECK(object, Error::kInvalidObject);
+  return (*reinterpret_cast<LazyTarget*>(object)->Get())(
+      std::forward<Args>(args)...);
+}
+
 // Auxiliary function to recover from type erasure and call a member function
 // address with the provided object.
 template <typename Return, typename... Args>
@@ -0,0 +1,189 @@
+// Copyright (c) 2020, Leandro Graciá Gil
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MAGIC_FUNC_FUNCTION_QUEUE_H_
+#define MAGIC_FUNC_FUNCTION_QUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+#include <magic_func/cache_line_isolated.h>
+#include <magic_func/port.h>
+#include <magic_func/type_traits.h>
+
+namespace mf {
+
+// Forward declaration.
+template <typename Signature>
+class FunctionQueue;
+
+// Queue of callable objects for a single producer and a single consumer.
+//
+// Unlike a container of mf::Function objects, where each callable is stored
+// in its own heap allocation, callables are constructed directly into a ring
+// buffer allocated once by the queue. Each one is stored as a variable-length
+// record made of a small header and the callable itself. The consumer calls
+// the callables and destroys them in place, so pushing and running closures
+// requires no heap allocations at all.
+//
+// One thread can push callables while another one runs them concurrently,
+// without locks. Pushing fails if there is not enough space left in the
+// buffer, in which case the producer can retry later or fall back to some
+// other mechanism.
+//
+// Callables must be invocable with the signature arguments, and cannot
+// require an alignment stricter than std::max_align_t.
+//
+// Example:
+// FunctionQueue<void()> queue(64 * 1024);
+//
+// // Producer thread.
+// std::string message = "hello";
+// queue.TryPush([message]() { std::cout << message << std::endl; });
+//
+// // Consumer thread.
+// queue.InvokeAll();
+template <typename... Args>
+class FunctionQueue<void(Args...)> {
+ public:
+  // Creates a queue with a buffer of at least the given size in bytes.
+  // The buffer size is rounded up to a power of two.
+  explicit FunctionQueue(size_t capacity);
+
+  // Destroys any pending callables without calling them.
+  ~FunctionQueue();
+
+  FunctionQueue(const FunctionQueue&) = delete;
+  FunctionQueue& operator =(const FunctionQueue&) = delete;
+
+  // Copies or moves a callable into the queue. Returns false if there is not
+  // enough space for it, in which case the callable is left untouched.
+  // Must only be called by the producer.
+  template <typename Callable>
+  bool TryPush(Callable&& callable);
+
+  // Constructs a callable of type Callable directly into the queue from the
+  // provided arguments. Returns false if there is not enough space for it.
+  // Must only be called by the producer.
+  template <typename Callable, typename... CallableArgs>
+  bool TryEmplace(CallableArgs&&... args);
+
+  // Calls the oldest callable in the queue and destroys it. Returns false if
+  // the queue is empty. Must only be called by the consumer.
+  bool InvokeOne(Args... args);
+
+  // Calls and destroys all the callables in the queue at the time of the call,
+  // passing the same arguments to each one. Returns how many were called.
+  // Must only be called by the consumer.
+  size_t InvokeAll(Args... args);
+
+  // Tells if the queue has no callables. Only accurate for the consumer.
+  bool empty() const MF_NOEXCEPT;
+
+  // Size of the buffer in bytes.
+  size_t capacity() const MF_NOEXCEPT { return mask_ + 1; }
+
+  // Alignment of records in the buffer.
+  enum : size_t { kAlignment = alignof(std::max_align_t) };
+
+ private:
+  using InvokeFuncPtr = void (*)(void*, Args...);
+  using DestroyFuncPtr = void (*)(void*);
+
+  // Header preceding each callable in the buffer. Headers without an invoke
+  // function mark the unused space at the end of the buffer before wrapping.
+  struct Header {
+    InvokeFuncPtr invoke;
+    DestroyFuncPtr destroy;
+    size_t size;
+  };
+
+  // Unit of allocation of the buffer.
+  struct alignas(kAlignment) Block {
+    unsigned char bytes[kAlignment];
+  };
+
+  enum : size_t {
+    kHeaderSize = (sizeof(Header) + kAlignment - 1) & ~(kAlignment - 1)
+  };
+
+  // Size of the record holding a callable of type T, including its header.
+  template <typename T>
+  static constexpr size_t RecordSize() {
+    return kHeaderSize + ((sizeof(T) + kAlignment - 1) & ~(kAlignment - 1));
+  }
+
+  template <typename T>
+  static void Invoke(void* object, Args... args);
+
+  template <typename T>
+  static void Destroy(void* object);
+
+  // Returns a pointer to space for a record of the given size, or nullptr if
+  // there is not enough. Writes a wrap marker if the record needs to be placed
+  // at the start of the buffer.
+  void* Reserve(size_t record_size);
+
+  // Publishes the record last reserved.
+  void Commit(size_t record_size);
+
+  // Finds the header of the next record to run, skipping any wrap marker.
+  // Returns nullptr if there are none.
+  Header* NextRecord();
+
+  // Destroys the callable of a record and releases its space.
+  void Release(Header* header);
+
+  unsigned char* data() { return buffer_[0].bytes; }
+
+  std::unique_ptr<Block[]> buffer_;
+  size_t mask_;
+
+  // Bytes consumed. Written by the consumer. Padded to avoid false sharing.
+  char padding0_[kCacheLineSize];
+  std::atomic<size_t> head_;
+  size_t cached_tail_;
+
+  // Bytes produced, including any skipped at the end of the buffer.
+  // Written by the producer.
+  char padding1_[kCacheLineSize];
+  std::atomic<size_t> tail_;
+  size_t cached_head_;
+  size_t pending_skip_;
+  char padding2_[kCacheLineSize];
+};
+
+}  // namespace mf
+
+#include <magic_func/function_queue.hpp>
+
+#endif  // MAGIC_FUNC_FUNCTION_QUEUE_H_
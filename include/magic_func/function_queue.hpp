@@ -0,0 +1,227 @@
+// Copyright (c) 2020, Leandro Graciá Gil
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MAGIC_FUNC_FUNCTION_QUEUE_HPP_
+#define MAGIC_FUNC_FUNCTION_QUEUE_HPP_
+
+#include <new>
+#include <utility>
+
+namespace mf {
+
+// Constructor.
+template <typename... Args>
+FunctionQueue<void(Args...)>::FunctionQueue(size_t capacity)
+    : head_(0), cached_tail_(0), tail_(0), cached_head_(0), pending_skip_(0) {
+  size_t size = kAlignment;
+  while (size < capacity)
+    size <<= 1;
+  buffer_.reset(new Block[size / kAlignment]);
+  mask_ = size - 1;
+}
+
+// Destructor.
+template <typename... Args>
+FunctionQueue<void(Args...)>::~FunctionQueue() {
+  while (Header* header = NextRecord())
+    Release(header);
+}
+
+// Pushes a callable.
+template <typename... Args>
+template <typename Callable>
+bool FunctionQueue<void(Args...)>::TryPush(Callable&& callable) {
+  return TryEmplace<std::decay_t<Callable>>(std::forward<Callable>(callable));
+}
+
+// Constructs a callable in place.
+template <typename... Args>
+template <typename Callable, typename... CallableArgs>
+bool FunctionQueue<void(Args...)>::TryEmplace(CallableArgs&&... args) {
+  static_assert(alignof(Callable) <= kAlignment,
+                "Over-aligned callables are not supported.");
+  constexpr size_t record_size = RecordSize<Callable>();
+
+  void* record = Reserve(record_size);
+  if (!record)
+    return false;
+
+  // Construct first, so that nothing is published if the constructor throws.
+  unsigned char* bytes = static_cast<unsigned char*>(record);
+  new (bytes + kHeaderSize) Callable(std::forward<CallableArgs>(args)...);
+
+  Header* header = reinterpret_cast<Header*>(bytes);
+  header->invoke = &Invoke<Callable>;
+  header->destroy = std::is_trivially_destructible<Callable>::value ?
+      nullptr : &Destroy<Callable>;
+  header->size = record_size;
+
+  Commit(record_size);
+  return true;
+}
+
+// Runs the oldest callable.
+template <typename... Args>
+bool FunctionQueue<void(Args...)>::InvokeOne(Args... args) {
+  Header* header = NextRecord();
+  if (!header)
+    return false;
+
+  // Released even if the call throws.
+  struct Releaser {
+    ~Releaser() { queue->Release(header); }
+    FunctionQueue* queue;
+    Header* header;
+  } releaser = { this, header };
+
+  header->invoke(reinterpret_cast<unsigned char*>(header) + kHeaderSize,
+                 std::forward<Args>(args)...);
+  return true;
+}
+
+// Runs all the callables.
+template <typename... Args>
+size_t FunctionQueue<void(Args...)>::InvokeAll(Args... args) {
+  // Only run the callables present at the start, even if more are pushed.
+  size_t end = tail_.load(std::memory_order_acquire);
+  size_t count = 0;
+  while (head_.load(std::memory_order_relaxed) != end) {
+    Header* header = NextRecord();
+    if (!header)
+      break;
+
+    struct Releaser {
+      ~Releaser() { queue->Release(header); }
+      FunctionQueue* queue;
+      Header* header;
+    } releaser = { this, header };
+
+    header->invoke(reinterpret_cast<unsigned char*>(header) + kHeaderSize,
+                   args...);
+    ++count;
+  }
+
+  return count;
+}
+
+// Tells if the queue is empty.
+template <typename... Args>
+bool FunctionQueue<void(Args...)>::empty() const MF_NOEXCEPT {
+  return head_.load(std::memory_order_relaxed) ==
+         tail_.load(std::memory_order_acquire);
+}
+
+// Calls a stored callable.
+template <typename... Args>
+template <typename T>
+void FunctionQueue<void(Args...)>::Invoke(void* object, Args... args) {
+  (*static_cast<T*>(object))(std::forward<Args>(args)...);
+}
+
+// Destroys a stored callable.
+template <typename... Args>
+template <typename T>
+void FunctionQueue<void(Args...)>::Destroy(void* object) {
+  static_cast<T*>(object)->~T();
+}
+
+// Finds space for a record.
+template <typename... Args>
+void* FunctionQueue<void(Args...)>::Reserve(size_t record_size) {
+  size_t tail = tail_.load(std::memory_order_relaxed);
+  size_t offset = tail & mask_;
+
+  // Records are never split, so skip the end of the buffer if needed.
+  size_t skip = capacity() - offset;
+  if (skip >= record_size)
+    skip = 0;
+
+  size_t needed = skip + record_size;
+  if (capacity() - (tail - cached_head_) < needed) {
+    cached_head_ = head_.load(std::memory_order_acquire);
+    if (capacity() - (tail - cached_head_) < needed)
+      return nullptr;
+  }
+
+  // Mark the skipped space so that the consumer also wraps. Space too small
+  // for a header is skipped implicitly by the consumer.
+  if (skip >= kHeaderSize) {
+    Header* marker = reinterpret_cast<Header*>(data() + offset);
+    marker->invoke = nullptr;
+    marker->destroy = nullptr;
+    marker->size = skip;
+  }
+
+  pending_skip_ = skip;
+  return data() + ((offset + skip) & mask_);
+}
+
+// Publishes a record.
+template <typename... Args>
+void FunctionQueue<void(Args...)>::Commit(size_t record_size) {
+  size_t tail = tail_.load(std::memory_order_relaxed);
+  tail_.store(tail + pending_skip_ + record_size, std::memory_order_release);
+}
+
+// Finds the next record.
+template <typename... Args>
+typename FunctionQueue<void(Args...)>::Header*
+FunctionQueue<void(Args...)>::NextRecord() {
+  size_t head = head_.load(std::memory_order_relaxed);
+  if (head == cached_tail_) {
+    cached_tail_ = tail_.load(std::memory_order_acquire);
+    if (head == cached_tail_)
+      return nullptr;
+  }
+
+  // Skipped space is always followed by a record published with it.
+  size_t offset = head & mask_;
+  size_t remaining = capacity() - offset;
+  if (remaining < kHeaderSize ||
+      !reinterpret_cast<Header*>(data() + offset)->invoke) {
+    head += remaining;
+    head_.store(head, std::memory_order_release);
+  }
+
+  return reinterpret_cast<Header*>(data() + (head & mask_));
+}
+
+// Releases a record.
+template <typename... Args>
+void FunctionQueue<void(Args...)>::Release(Header* header) {
+  size_t size = header->size;
+  if (header->destroy)
+    header->destroy(reinterpret_cast<unsigned char*>(header) + kHeaderSize);
+  head_.store(head_.load(std::memory_order_relaxed) + size,
+              std::memory_order_release);
+}
+
+}  // namespace mf
+
+#endif  // MAGIC_FUNC_FUNCTION_QUEUE_HPP_
@@ -0,0 +1,201 @@
+// Copyright (c) 2020, Leandro Graciá Gil
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MAGIC_FUNC_OVERLOADED_FUNCTION_H_
+#define MAGIC_FUNC_OVERLOADED_FUNCTION_H_
+
+#include <cstddef>
+#include <type_traits>
+
+#include <magic_func/function.h>
+#include <magic_func/port.h>
+#include <magic_func/type_erased_object.h>
+#include <magic_func/type_traits.h>
+
+namespace mf {
+
+// Forward declaration.
+template <typename... Signatures>
+class OverloadedFunction;
+
+namespace internal {
+
+// Data shared by all the overloads of an OverloadedFunction.
+template <size_t NumSignatures>
+class OverloadedFunctionStorage {
+ protected:
+  using TypeErasedFuncPtr = void (*)();
+
+  // The callable object, stored only once for all signatures.
+  TypeErasedObject object_;
+
+  // One type-erased call helper for each signature, in declaration order.
+  TypeErasedFuncPtr func_ptrs_[NumSignatures];
+};
+
+// Recursively defines one operator () for each signature. Every level brings
+// into scope the operators of the next one, so that they can be selected by
+// overload resolution.
+template <typename Storage, size_t Index, typename... Signatures>
+class OverloadedCallOperator;
+
+// Last signature. Derives from the storage.
+template <typename Storage, size_t Index, typename Return, typename... Args>
+class OverloadedCallOperator<Storage, Index, Return(Args...)>
+    : public Storage {
+ public:
+  inline Return operator ()(Args... args) const;
+};
+
+// Any other signature.
+template <typename Storage, size_t Index, typename Return, typename... Args,
+          typename... Signatures>
+class OverloadedCallOperator<Storage, Index, Return(Args...), Signatures...>
+    : public OverloadedCallOperator<Storage, Index + 1, Signatures...> {
+ public:
+  using OverloadedCallOperator<Storage, Index + 1, Signatures...>::operator ();
+  inline Return operator ()(Args... args) const;
+};
+
+}  // namespace internal
+
+// Callable object supporting multiple function signatures.
+//
+// Works like a set of mf::Function objects, one for each signature, that wrap
+// the same callable object. However, the callable is stored only once and
+// only one heap allocation is made. Calls are dispatched to the appropriate
+// signature by regular overload resolution.
+//
+// This is useful for visitors and message handlers that need to handle a set
+// of argument types with the same object.
+//
+// Example:
+// struct Visitor {
+//   void operator ()(int x) { std::cout << "int " << x << std::endl; }
+//   void operator ()(const std::string& str) { std::cout << str << std::endl; }
+// };
+//
+// OverloadedFunction<void(int), void(const std::string&)> visit = Visitor();
+// visit(42);                    // Calls Visitor::operator ()(int).
+// visit(std::string("hello"));  // Calls Visitor::operator ()(const string&).
+//
+// Like with regular function overloads, calls that match more than one
+// signature equally well are ambiguous and produce build errors.
+template <typename... Signatures>
+class OverloadedFunction : public internal::OverloadedCallOperator<
+    internal::OverloadedFunctionStorage<sizeof...(Signatures)>, 0,
+    Signatures...> {
+ public:
+  static_assert(sizeof...(Signatures) > 0,
+                "At least one function signature is required.");
+
+  // Tells if a type can be wrapped by the callable constructor. Excludes
+  // overloaded functions, nullptr and other MagicFunc function objects.
+  template <typename Callable>
+  using IsCallable = std::integral_constant<bool,
+      !std::is_same<std::decay_t<Callable>, OverloadedFunction>::value &&
+      !std::is_same<std::decay_t<Callable>, std::nullptr_t>::value &&
+      !IsFunction<Callable>::value &&
+      !std::is_base_of<TypeErasedFunction, std::decay_t<Callable>>::value>;
+
+  enum : size_t { kNumSignatures = sizeof...(Signatures) };
+
+  using internal::OverloadedCallOperator<
+      internal::OverloadedFunctionStorage<sizeof...(Signatures)>, 0,
+      Signatures...>::operator ();
+
+  // Creates an empty OverloadedFunction.
+  OverloadedFunction() MF_NOEXCEPT;
+
+  // Copies share no state. Moved-from objects are left empty.
+  OverloadedFunction(const OverloadedFunction& function) = default;
+  OverloadedFunction(OverloadedFunction&& function) MF_NOEXCEPT;
+  OverloadedFunction& operator =(const OverloadedFunction& function) = default;
+  OverloadedFunction& operator =(OverloadedFunction&& function) MF_NOEXCEPT;
+
+  // Universal reference constructor for callable objects, including lambdas.
+  //
+  // The callable object is stored in the heap, either copied or moved
+  // depending on how this method is invoked. It must be copy-constructible and
+  // have operators () compatible with every signature of this object.
+  //
+  // This constructor is intentionally non-explicit, like the mf::Function one.
+  template <typename Callable,
+            typename = std::enable_if_t<IsCallable<Callable>::value>>
+  OverloadedFunction(Callable&& callable);
+
+  // Universal reference assignment operator for compatible callable objects.
+  template <typename Callable,
+            typename = std::enable_if_t<IsCallable<Callable>::value>>
+  OverloadedFunction& operator =(Callable&& callable);
+
+  // Assignment to nullptr. Clears the object.
+  OverloadedFunction& operator =(std::nullptr_t);
+
+  // Tells if the object holds a callable.
+  explicit operator bool() const MF_NOEXCEPT {
+    return this->func_ptrs_[0] != nullptr;
+  }
+
+  bool operator ==(std::nullptr_t) const MF_NOEXCEPT {
+    return this->func_ptrs_[0] == nullptr;
+  }
+
+  bool operator !=(std::nullptr_t) const MF_NOEXCEPT {
+    return this->func_ptrs_[0] != nullptr;
+  }
+
+  // Returns a pointer to the stored callable object, if any.
+  void* GetObject() const MF_NOEXCEPT { return this->object_.GetObject(); }
+
+ private:
+  using TypeErasedFuncPtr = void (*)();
+
+  // Calls the operator () of a callable object matching a signature.
+  template <typename Callable, typename Signature>
+  struct CallableThunk;
+
+  template <typename Callable, typename Return, typename... Args>
+  struct CallableThunk<Callable, Return(Args...)> {
+    static Return Call(void* object, Args... args);
+  };
+
+  // Sets the call helpers for a callable type.
+  template <typename Callable>
+  void SetThunks();
+
+  // Clears the call helpers, making the object empty.
+  void ClearThunks() MF_NOEXCEPT;
+};
+
+}  // namespace mf
+
+#include <magic_func/overloaded_function.hpp>
+
+#endif  // MAGIC_FUNC_OVERLOADED_FUNCTION_H_
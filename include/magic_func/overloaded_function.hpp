@@ -0,0 +1,155 @@
+// Copyright (c) 2020, Leandro Graciá Gil
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MAGIC_FUNC_OVERLOADED_FUNCTION_HPP_
+#define MAGIC_FUNC_OVERLOADED_FUNCTION_HPP_
+
+#include <magic_func/error.h>
+
+namespace mf {
+namespace internal {
+
+// Parenthesis operator of the last signature.
+template <typename Storage, size_t Index, typename Return, typename... Args>
+Return OverloadedCallOperator<Storage, Index, Return(Args...)>::operator ()(
+    Args... args) const {
+  MAGIC_FUNC_DCHECK(this->func_ptrs_[Index], Error::kInvalidFunction);
+  return (*reinterpret_func<Return (*)(void*, Args...)>(
+      this->func_ptrs_[Index]))(this->object_.GetObject(),
+                                std::forward<Args>(args)...);
+}
+
+// Parenthesis operator of any other signature.
+template <typename Storage, size_t Index, typename Return, typename... Args,
+          typename... Signatures>
+Return OverloadedCallOperator<Storage, Index, Return(Args...), Signatures...>::
+operator ()(Args... args) const {
+  MAGIC_FUNC_DCHECK(this->func_ptrs_[Index], Error::kInvalidFunction);
+  return (*reinterpret_func<Return (*)(void*, Args...)>(
+      this->func_ptrs_[Index]))(this->object_.GetObject(),
+                                std::forward<Args>(args)...);
+}
+
+}  // namespace internal
+
+// Default constructor.
+template <typename... Signatures>
+OverloadedFunction<Signatures...>::OverloadedFunction() MF_NOEXCEPT {
+  ClearThunks();
+}
+
+// Move constructor. Leaves the moved object empty.
+template <typename... Signatures>
+OverloadedFunction<Signatures...>::OverloadedFunction(
+    OverloadedFunction&& function) MF_NOEXCEPT {
+  this->object_ = std::move(function.object_);
+  for (size_t i = 0; i < kNumSignatures; ++i)
+    this->func_ptrs_[i] = function.func_ptrs_[i];
+  function.ClearThunks();
+}
+
+// Move assignment operator. Leaves the moved object empty.
+template <typename... Signatures>
+OverloadedFunction<Signatures...>&
+OverloadedFunction<Signatures...>::operator =(
+    OverloadedFunction&& function) MF_NOEXCEPT {
+  if (this == &function)
+    return *this;
+
+  this->object_ = std::move(function.object_);
+  for (size_t i = 0; i < kNumSignatures; ++i)
+    this->func_ptrs_[i] = function.func_ptrs_[i];
+  function.ClearThunks();
+  return *this;
+}
+
+// Constructor for compatible callable objects.
+template <typename... Signatures>
+template <typename Callable, typename>
+OverloadedFunction<Signatures...>::OverloadedFunction(Callable&& callable) {
+  // Thunks are only set once the object has been stored.
+  ClearThunks();
+  this->object_.StoreObject(std::forward<Callable>(callable));
+  SetThunks<Callable>();
+}
+
+// Assignment operator for compatible callable objects.
+template <typename... Signatures>
+template <typename Callable, typename>
+OverloadedFunction<Signatures...>&
+OverloadedFunction<Signatures...>::operator =(Callable&& callable) {
+  // Storing releases the previous object first, so the object is left empty
+  // if storing the new one fails.
+  ClearThunks();
+  this->object_.StoreObject(std::forward<Callable>(callable));
+  SetThunks<Callable>();
+  return *this;
+}
+
+// Assignment operator to nullptr.
+template <typename... Signatures>
+OverloadedFunction<Signatures...>&
+OverloadedFunction<Signatures...>::operator =(std::nullptr_t) {
+  ClearThunks();
+  this->object_.Reset();
+  return *this;
+}
+
+// Sets the call helpers of every signature for a callable type.
+template <typename... Signatures>
+template <typename Callable>
+void OverloadedFunction<Signatures...>::SetThunks() {
+  const TypeErasedFuncPtr func_ptrs[] = {
+      reinterpret_func<TypeErasedFuncPtr>(
+          &CallableThunk<Callable, Signatures>::Call)... };
+
+  for (size_t i = 0; i < kNumSignatures; ++i)
+    this->func_ptrs_[i] = func_ptrs[i];
+}
+
+// Clears the call helpers of every signature.
+template <typename... Signatures>
+void OverloadedFunction<Signatures...>::ClearThunks() MF_NOEXCEPT {
+  for (auto& func_ptr : this->func_ptrs_)
+    func_ptr = nullptr;
+}
+
+// Recovers the callable object from type erasure and calls it.
+template <typename... Signatures>
+template <typename Callable, typename Return, typename... Args>
+Return OverloadedFunction<Signatures...>::CallableThunk<
+    Callable, Return(Args...)>::Call(void* object, Args... args) {
+  MAGIC_FUNC_DCHECK(object, Error::kInvalidObject);
+  using Object = std::remove_reference_t<Callable>;
+  return (*reinterpret_cast<Object*>(object))(std::forward<Args>(args)...);
+}
+
+}  // namespace mf
+
+#endif  // MAGIC_FUNC_OVERLOADED_FUNCTION_HPP_
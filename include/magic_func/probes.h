@@ -0,0 +1,120 @@
+// Copyright (c) 2020, Leandro Graciá Gil
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MAGIC_FUNC_PROBES_H_
+#define MAGIC_FUNC_PROBES_H_
+
+#include <cstdint>
+
+// Optional USDT (user-level statically defined tracing) probes.
+//
+// Probes mark points of interest that tools like bpftrace, perf or SystemTap
+// can attach to at runtime without rebuilding, for example:
+//
+// bpftrace -e 'usdt:./app:magic_func:heap_allocate { @[arg0] = count(); }'
+//
+// Probes are disabled unless MAGIC_FUNC_ENABLE_PROBES is defined, in which case
+// each probe compiles to a single NOP instruction and an ELF note describing
+// its location and arguments, in the same format as <sys/sdt.h>. Disabled
+// probes compile to nothing, and their arguments are not evaluated.
+//
+// Probes are only supported in ELF platforms for x86-64 and AArch64 when
+// building with GCC or Clang. All arguments are passed as 64-bit unsigned
+// integers, so they must be integers or pointers.
+//
+// Probes defined by MagicFunc, all under the magic_func provider:
+// - heap_allocate(size, alignment): a function or type-erased object allocates
+//   heap memory to store its callable.
+//
+// Probes can be added to other code using the macros below with any name, as
+// done by some of the examples.
+#if defined(MAGIC_FUNC_ENABLE_PROBES) && defined(__ELF__) && \
+    defined(__GNUC__) && (defined(__x86_64__) || defined(__aarch64__))
+#define MAGIC_FUNC_HAS_PROBES 1
+#endif
+
+#if defined(MAGIC_FUNC_HAS_PROBES)
+
+// Assembly for a probe: a NOP at the probe location, and a stapsdt note with
+// the address of the NOP, the provider, the name and the argument format.
+#define MAGIC_FUNC_PROBE_ASM(name, args) \
+    "990: nop\n" \
+    ".pushsection .note.stapsdt,\"?\",\"note\"\n" \
+    ".balign 4\n" \
+    ".4byte 992f-991f, 994f-993f, 3\n" \
+    "991: .asciz \"stapsdt\"\n" \
+    "992: .balign 4\n" \
+    "993: .8byte 990b\n" \
+    ".8byte _.stapsdt.base\n" \
+    ".8byte 0\n" \
+    ".asciz \"magic_func\"\n" \
+    ".asciz \"" #name "\"\n" \
+    ".asciz \"" args "\"\n" \
+    "994: .balign 4\n" \
+    ".popsection\n" \
+    ".ifndef _.stapsdt.base\n" \
+    ".pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n" \
+    ".weak _.stapsdt.base\n" \
+    ".hidden _.stapsdt.base\n" \
+    "_.stapsdt.base: .space 1\n" \
+    ".size _.stapsdt.base, 1\n" \
+    ".popsection\n" \
+    ".endif\n"
+
+// Probe argument, converted to a 64-bit unsigned integer.
+#define MAGIC_FUNC_PROBE_ARG(arg) "nor"((uint64_t)(arg))
+
+#define MAGIC_FUNC_PROBE0(name) \
+    __asm__ __volatile__(MAGIC_FUNC_PROBE_ASM(name, ""))
+
+#define MAGIC_FUNC_PROBE1(name, arg1) \
+    __asm__ __volatile__(MAGIC_FUNC_PROBE_ASM(name, "8@%0") \
+                         :: MAGIC_FUNC_PROBE_ARG(arg1))
+
+#define MAGIC_FUNC_PROBE2(name, arg1, arg2) \
+    __asm__ __volatile__(MAGIC_FUNC_PROBE_ASM(name, "8@%0 8@%1") \
+                         :: MAGIC_FUNC_PROBE_ARG(arg1), \
+                            MAGIC_FUNC_PROBE_ARG(arg2))
+
+#define MAGIC_FUNC_PROBE3(name, arg1, arg2, arg3) \
+    __asm__ __volatile__(MAGIC_FUNC_PROBE_ASM(name, "8@%0 8@%1 8@%2") \
+                         :: MAGIC_FUNC_PROBE_ARG(arg1), \
+                            MAGIC_FUNC_PROBE_ARG(arg2), \
+                            MAGIC_FUNC_PROBE_ARG(arg3))
+
+#else
+
+#define MAGIC_FUNC_PROBE0(name) ((void) 0)
+#define MAGIC_FUNC_PROBE1(name, arg1) ((void) 0)
+#define MAGIC_FUNC_PROBE2(name, arg1, arg2) ((void) 0)
+#define MAGIC_FUNC_PROBE3(name, arg1, arg2, arg3) ((void) 0)
+
+#endif
+
+#endif  // MAGIC_FUNC_PROBES_H_
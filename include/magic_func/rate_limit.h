@@ -0,0 +1,236 @@
+// Copyright (c) 2020, Leandro Graciá Gil
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MAGIC_FUNC_RATE_LIMIT_H_
+#define MAGIC_FUNC_RATE_LIMIT_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <tuple>
+
+#include <magic_func/function.h>
+#include <magic_func/function_traits.h>
+#include <magic_func/make_function.h>
+#include <magic_func/type_traits.h>
+
+// Wrappers limiting how often functions are called.
+//
+// Callbacks such as sensor readings or UI events often arrive much faster than
+// their handlers need them. The wrappers below return a new mf::Function with
+// the same signature that forwards only some of the calls to the original one.
+//
+// Calling the returned functions is lock-free and does not allocate memory,
+// besides any copies of the arguments that need it. Calls only check a
+// timestamp and, when calls are deferred, atomically replace the latest
+// arguments. They can be called from multiple threads at the same time.
+//
+// All wrappers take a Clock type template argument following the requirements
+// of the standard chrono clocks, which allows using fake clocks in tests.
+//
+// Only functions returning void are supported, since calls may be dropped or
+// deferred.
+
+namespace mf {
+
+// Runs tasks after a delay, for wrappers that defer calls. Executors are
+// expected to run each task once, on any thread, at some point after the
+// provided delay. Tasks can be copied without allocating memory.
+template <typename Clock = std::chrono::steady_clock>
+using DelayedExecutor = Function<void(const Function<void()>&,
+                                      typename Clock::duration)>;
+
+// Returns a function forwarding calls to the provided one at most once per
+// interval. The first call is always forwarded, and any other calls made
+// before the interval elapses are dropped.
+//
+// Example:
+// auto throttled = Throttle(on_position, std::chrono::milliseconds(16));
+// throttled(x, y);  // Calls on_position.
+// throttled(x, y);  // Dropped if within 16 ms of the previous call.
+template <typename Clock = std::chrono::steady_clock, typename... Args>
+Function<void(Args...)> Throttle(Function<void(Args...)> function,
+                                 typename Clock::duration interval);
+
+// Like Throttle, but deduces the function type from a callable object such as
+// a lambda, which Throttle cannot do. Like make_function, this only works if
+// the operator () of the callable is not overloaded.
+//
+// Example:
+// auto throttled = MakeThrottle([](int x, int y) { Move(x, y); },
+//                               std::chrono::milliseconds(16));
+template <typename Clock = std::chrono::steady_clock, typename Callable>
+Function<typename FunctionTraits<CallableType<Callable>>::FunctionType>
+MakeThrottle(Callable&& callable, typename Clock::duration interval);
+
+// Returns a function forwarding only the last of a burst of calls to the
+// provided one. The function is called with the latest arguments once no new
+// calls are made for the provided delay. The calls are deferred using the
+// provided executor, which is used at most once per burst.
+//
+// Example:
+// auto debounced = Debounce(on_resize, std::chrono::milliseconds(100),
+//                           executor);
+// debounced(640, 480);
+// debounced(800, 600);  // Calls on_resize(800, 600) in 100 ms if not called.
+template <typename Clock = std::chrono::steady_clock, typename... Args>
+Function<void(Args...)> Debounce(Function<void(Args...)> function,
+                                 typename Clock::duration delay,
+                                 DelayedExecutor<Clock> executor);
+
+// Returns a function that coalesces calls made before the executor gets to run
+// them, calling the provided function only once with the latest arguments.
+// Equivalent to a Debounce with no delay.
+template <typename Clock = std::chrono::steady_clock, typename... Args>
+Function<void(Args...)> Coalesce(Function<void(Args...)> function,
+                                 DelayedExecutor<Clock> executor);
+
+namespace internal {
+
+// Sequence of indices used to unpack stored arguments.
+template <size_t... Is>
+struct IndexSequence {};
+
+template <size_t N, size_t... Is>
+struct MakeIndexSequence : MakeIndexSequence<N - 1, N - 1, Is...> {};
+
+template <size_t... Is>
+struct MakeIndexSequence<0, Is...> {
+  using Type = IndexSequence<Is...>;
+};
+
+// Holds the latest arguments of a function, replacing them without locks.
+//
+// Arguments are written into one of a fixed set of slots, which is then
+// published by exchanging the index of the latest slot. Writers claim free
+// slots, so concurrent writers never write into the same one. If all the slots
+// are taken by concurrent writers, the new arguments are dropped in favour of
+// theirs.
+template <typename... Args>
+class LatestArgs {
+ public:
+  LatestArgs() MF_NOEXCEPT;
+  ~LatestArgs();
+
+  LatestArgs(const LatestArgs&) = delete;
+  LatestArgs& operator =(const LatestArgs&) = delete;
+
+  // Replaces the latest arguments with the provided ones.
+  void Store(Args... args);
+
+  // Calls a function with the latest arguments and clears them. Returns false
+  // if there were no arguments.
+  bool Take(const Function<void(Args...)>& function);
+
+  // Tells if there are arguments stored and not taken yet.
+  bool HasArgs() const MF_NOEXCEPT;
+
+ private:
+  using Tuple = std::tuple<std::decay_t<Args>...>;
+
+  enum : size_t { kNumSlots = 8, kNone = kNumSlots };
+
+  struct Slot {
+    std::atomic<bool> used;
+    typename std::aligned_storage<sizeof(Tuple), alignof(Tuple)>::type tuple;
+  };
+
+  template <size_t... Is>
+  static void Call(const Function<void(Args...)>& function, Tuple& tuple,
+                   IndexSequence<Is...>);
+
+  // Destroys the arguments in a slot and makes it available again.
+  void Release(size_t index);
+
+  Tuple& TupleAt(size_t index) {
+    return *reinterpret_cast<Tuple*>(&slots_[index].tuple);
+  }
+
+  Slot slots_[kNumSlots];
+  std::atomic<size_t> latest_;
+};
+
+// State of functions returned by Throttle.
+template <typename Clock, typename... Args>
+class ThrottledFunction {
+ public:
+  ThrottledFunction(Function<void(Args...)> function,
+                    typename Clock::duration interval);
+
+  void Call(Args... args);
+
+ private:
+  using Rep = typename Clock::rep;
+
+  Function<void(Args...)> function_;
+  const Rep interval_;
+
+  // Time since the clock epoch when the next call can be forwarded.
+  std::atomic<Rep> next_call_;
+};
+
+// State of functions returned by Debounce and Coalesce.
+template <typename Clock, typename... Args>
+class DebouncedFunction
+    : public std::enable_shared_from_this<DebouncedFunction<Clock, Args...>> {
+ public:
+  DebouncedFunction(Function<void(Args...)> function,
+                    typename Clock::duration delay,
+                    DelayedExecutor<Clock> executor);
+
+  void Call(Args... args);
+
+ private:
+  using Rep = typename Clock::rep;
+
+  // Run by the executor when the delay since the call scheduling it elapses.
+  void Fire();
+
+  void Schedule(typename Clock::duration delay);
+
+  Function<void(Args...)> function_;
+  const Rep delay_;
+  DelayedExecutor<Clock> executor_;
+  LatestArgs<Args...> args_;
+
+  // Time since the clock epoch of the latest call.
+  std::atomic<Rep> last_call_;
+
+  // Tells if a task is scheduled in the executor.
+  std::atomic<bool> scheduled_;
+};
+
+}  // namespace internal
+
+}  // namespace mf
+
+#include <magic_func/rate_limit.hpp>
+
+#endif  // MAGIC_FUNC_RATE_LIMIT_H_
@@ -0,0 +1,225 @@
+// Copyright (c) 2020, Leandro Graciá Gil
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MAGIC_FUNC_RATE_LIMIT_HPP_
+#define MAGIC_FUNC_RATE_LIMIT_HPP_
+
+#include <new>
+#include <utility>
+
+namespace mf {
+
+template <typename Clock, typename... Args>
+Function<void(Args...)> Throttle(Function<void(Args...)> function,
+                                 typename Clock::duration interval) {
+  using State = internal::ThrottledFunction<Clock, Args...>;
+  return Function<void(Args...)>::template FromMemberFunction<
+      State, &State::Call>(
+          std::make_shared<State>(std::move(function), interval));
+}
+
+template <typename Clock, typename Callable>
+Function<typename FunctionTraits<CallableType<Callable>>::FunctionType>
+MakeThrottle(Callable&& callable, typename Clock::duration interval) {
+  return Throttle<Clock>(make_function(std::forward<Callable>(callable)),
+                         interval);
+}
+
+template <typename Clock, typename... Args>
+Function<void(Args...)> Debounce(Function<void(Args...)> function,
+                                 typename Clock::duration delay,
+                                 DelayedExecutor<Clock> executor) {
+  using State = internal::DebouncedFunction<Clock, Args...>;
+  return Function<void(Args...)>::template FromMemberFunction<
+      State, &State::Call>(
+          std::make_shared<State>(std::move(function), delay,
+                                  std::move(executor)));
+}
+
+template <typename Clock, typename... Args>
+Function<void(Args...)> Coalesce(Function<void(Args...)> function,
+                                 DelayedExecutor<Clock> executor) {
+  return Debounce<Clock>(std::move(function), Clock::duration::zero(),
+                         std::move(executor));
+}
+
+namespace internal {
+
+template <typename... Args>
+LatestArgs<Args...>::LatestArgs() MF_NOEXCEPT : latest_(kNone) {
+  for (auto& slot : slots_)
+    slot.used.store(false, std::memory_order_relaxed);
+}
+
+template <typename... Args>
+LatestArgs<Args...>::~LatestArgs() {
+  size_t latest = latest_.load(std::memory_order_acquire);
+  if (latest != kNone)
+    Release(latest);
+}
+
+template <typename... Args>
+void LatestArgs<Args...>::Store(Args... args) {
+  for (size_t i = 0; i < kNumSlots; ++i) {
+    Slot& slot = slots_[i];
+    if (slot.used.load(std::memory_order_relaxed) ||
+        slot.used.exchange(true, std::memory_order_acquire)) {
+      continue;
+    }
+
+    new (&slot.tuple) Tuple(std::forward<Args>(args)...);
+
+    // The replaced slot is no longer reachable by anyone else. Sequentially
+    // consistent, since callers can check other flags after storing.
+    size_t previous = latest_.exchange(i, std::memory_order_seq_cst);
+    if (previous != kNone)
+      Release(previous);
+    return;
+  }
+}
+
+template <typename... Args>
+bool LatestArgs<Args...>::Take(const Function<void(Args...)>& function) {
+  size_t latest = latest_.exchange(kNone, std::memory_order_acq_rel);
+  if (latest == kNone)
+    return false;
+
+  // Released even if the call throws.
+  struct Releaser {
+    ~Releaser() { args->Release(index); }
+    LatestArgs* args;
+    size_t index;
+  } releaser = { this, latest };
+
+  Call(function, TupleAt(latest),
+       typename MakeIndexSequence<sizeof...(Args)>::Type());
+  return true;
+}
+
+template <typename... Args>
+bool LatestArgs<Args...>::HasArgs() const MF_NOEXCEPT {
+  return latest_.load(std::memory_order_seq_cst) != kNone;
+}
+
+template <typename... Args>
+template <size_t... Is>
+void LatestArgs<Args...>::Call(const Function<void(Args...)>& function,
+                               Tuple& tuple, IndexSequence<Is...>) {
+  // Arguments taken by value are moved, since they are not used again.
+  function(static_cast<Args&&>(std::get<Is>(tuple))...);
+}
+
+template <typename... Args>
+void LatestArgs<Args...>::Release(size_t index) {
+  TupleAt(index).~Tuple();
+  slots_[index].used.store(false, std::memory_order_release);
+}
+
+template <typename Clock, typename... Args>
+ThrottledFunction<Clock, Args...>::ThrottledFunction(
+    Function<void(Args...)> function, typename Clock::duration interval)
+    : function_(std::move(function)),
+      interval_(interval.count()),
+      next_call_(Clock::time_point::min().time_since_epoch().count()) {}
+
+template <typename Clock, typename... Args>
+void ThrottledFunction<Clock, Args...>::Call(Args... args) {
+  Rep now = Clock::now().time_since_epoch().count();
+  Rep next_call = next_call_.load(std::memory_order_relaxed);
+  if (now < next_call)
+    return;
+
+  // Only one of the threads calling at the same time gets through.
+  if (!next_call_.compare_exchange_strong(next_call, now + interval_,
+                                          std::memory_order_relaxed)) {
+    return;
+  }
+
+  function_(std::forward<Args>(args)...);
+}
+
+template <typename Clock, typename... Args>
+DebouncedFunction<Clock, Args...>::DebouncedFunction(
+    Function<void(Args...)> function, typename Clock::duration delay,
+    DelayedExecutor<Clock> executor)
+    : function_(std::move(function)),
+      delay_(delay.count()),
+      executor_(std::move(executor)),
+      last_call_(0),
+      scheduled_(false) {}
+
+template <typename Clock, typename... Args>
+void DebouncedFunction<Clock, Args...>::Call(Args... args) {
+  args_.Store(std::forward<Args>(args)...);
+  last_call_.store(Clock::now().time_since_epoch().count(),
+                   std::memory_order_release);
+
+  // Tasks already scheduled take care of the new arguments.
+  if (scheduled_.load(std::memory_order_seq_cst) ||
+      scheduled_.exchange(true, std::memory_order_acq_rel)) {
+    return;
+  }
+
+  Schedule(typename Clock::duration(delay_));
+}
+
+template <typename Clock, typename... Args>
+void DebouncedFunction<Clock, Args...>::Fire() {
+  Rep elapsed = Clock::now().time_since_epoch().count() -
+                last_call_.load(std::memory_order_acquire);
+  if (elapsed < delay_) {
+    Schedule(typename Clock::duration(delay_ - elapsed));
+    return;
+  }
+
+  // Take the arguments before clearing the flag, so that calls made in
+  // between do not schedule a new task while these arguments are forwarded.
+  args_.Take(function_);
+  scheduled_.store(false, std::memory_order_seq_cst);
+
+  // Calls made after taking the arguments but before clearing the flag saw a
+  // task scheduled, so they rely on this one to schedule the next.
+  if (args_.HasArgs() && !scheduled_.exchange(true, std::memory_order_acq_rel))
+    Schedule(typename Clock::duration(delay_));
+}
+
+template <typename Clock, typename... Args>
+void DebouncedFunction<Clock, Args...>::Schedule(
+    typename Clock::duration delay) {
+  // Tasks keep the state alive, even if the debounced function is destroyed.
+  executor_(Function<void()>::FromMemberFunction<
+      DebouncedFunction, &DebouncedFunction::Fire>(this->shared_from_this()),
+      delay);
+}
+
+}  // namespace internal
+
+}  // namespace mf
+
+#endif  // MAGIC_FUNC_RATE_LIMIT_HPP_
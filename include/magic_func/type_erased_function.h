@@ -30,6 +30,8 @@
 #ifndef MAGIC_FUNC_TYPE_ERASED_FUNCTION_H_
 #define MAGIC_FUNC_TYPE_ERASED_FUNCTION_H_
 
+#include <type_traits>
+
 #include <magic_func/port.h>
 #include <magic_func/type_erased_object.h>
 #include <magic_func/type_id.h>
@@ -44,9 +46,12 @@ class TypeErasedFunction {
   // Trying to function_cast it to another object will fail.
   inline TypeErasedFunction() MF_NOEXCEPT;
 
-  // Default copy and move constructors.
+  // Default copy constructor.
   inline TypeErasedFunction(const TypeErasedFunction&) = default;
-  inline TypeErasedFunction(TypeErasedFunction&&);
+
+  // Moves another function, leaving it empty and without a type.
+  // Never throws, so containers of functions can move them when growing.
+  inline TypeErasedFunction(TypeErasedFunction&& function) MF_NOEXCEPT;
 
   // Copies another function into the current object.
   //
@@ -104,6 +109,11 @@ class TypeErasedFunction {
   TypeId type_id_;
 };
 
+#if !defined(MF_DISABLE_NOEXCEPT)
+static_assert(std::is_nothrow_move_constructible<TypeErasedFunction>::value,
+              "TypeErasedFunction moves must not throw.");
+#endif
+
 }  // namespace mf
 
 #include <magic_func/type_erased_function.hpp>
@@ -41,11 +41,13 @@ TypeErasedFunction::TypeErasedFunction(TypeId type_id,
     : func_ptr_(func_ptr),
       type_id_(type_id) {}
 
-TypeErasedFunction::TypeErasedFunction(TypeErasedFunction&& function)
-    : func_ptr_(nullptr), type_id_(0) {
-  std::swap(object_, function.object_);
-  std::swap(func_ptr_, function.func_ptr_);
-  std::swap(type_id_, function.type_id_);
+TypeErasedFunction::TypeErasedFunction(
+    TypeErasedFunction&& function) MF_NOEXCEPT
+    : object_(std::move(function.object_)),
+      func_ptr_(function.func_ptr_),
+      type_id_(function.type_id_) {
+  function.func_ptr_ = nullptr;
+  function.type_id_ = 0;
 }
 
 TypeErasedFunction& TypeErasedFunction::operator =(
@@ -68,13 +70,12 @@ TypeErasedFunction& TypeErasedFunction::operator =(
 
   MAGIC_FUNC_CHECK(type_id_ == 0 || type_id_ == function.type_id_,
                    Error::kIncompatibleType);
-  object_.Reset();
-  func_ptr_ = nullptr;
-  type_id_ = 0;
+  object_ = std::move(function.object_);
+  func_ptr_ = function.func_ptr_;
+  type_id_ = function.type_id_;
 
-  std::swap(object_, function.object_);
-  std::swap(func_ptr_, function.func_ptr_);
-  std::swap(type_id_, function.type_id_);
+  function.func_ptr_ = nullptr;
+  function.type_id_ = 0;
   return *this;
 }
 
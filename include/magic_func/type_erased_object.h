@@ -30,11 +30,15 @@
 #ifndef MAGIC_FUNC_TYPE_ERASED_OBJECT_H_
 #define MAGIC_FUNC_TYPE_ERASED_OBJECT_H_
 
+#include <cstring>
+#include <memory>
+#include <new>
 #include <type_traits>
 
 #include <magic_func/allocator.h>
 #include <magic_func/error.h>
 #include <magic_func/port.h>
+#include <magic_func/probes.h>
 #include <magic_func/type_traits.h>
 
 namespace mf {
@@ -48,11 +52,14 @@ namespace mf {
 // 2. The class contains a provided shared pointer in its data buffer.
 //    Happens when calling StoreObject explicitly with a shared pointer.
 //
-// 3. The class contains a unique pointer in its data buffer that points to the
-//    real object in heap memory. Happens when calling StoreObject otherwise.
+// 3. The class contains a pointer in its data buffer that owns the real object
+//    in heap memory. Happens when calling StoreObject otherwise.
 //
 // Stored objects get their copy constructors and destructors called when
 // appropriate despite type erasure. See StoreObject for more details.
+//
+// Moving never throws. Objects stored in the heap are moved by transferring
+// their owning pointer without any indirect calls.
 class TypeErasedObject {
  public:
   inline TypeErasedObject() MF_NOEXCEPT;
@@ -61,7 +68,7 @@ class TypeErasedObject {
   inline ~TypeErasedObject();
 
   inline TypeErasedObject& operator =(const TypeErasedObject& object);
-  inline TypeErasedObject& operator =(TypeErasedObject&& object);
+  inline TypeErasedObject& operator =(TypeErasedObject&& object) MF_NOEXCEPT;
 
   // Tells if an object is being encapsulatd or referenced.
   explicit operator bool() const MF_NOEXCEPT { return object_ptr_ != nullptr; }
@@ -74,7 +81,7 @@ class TypeErasedObject {
   void* GetObject() const MF_NOEXCEPT { return object_ptr_; }
 
   // Deletes any stored object and cleans any object references.
-  inline void Reset();
+  inline void Reset() MF_NOEXCEPT;
 
   // Stores a reference to an object. Any previously stored object is destroyed.
   // Constness and volatility are casted away and must be added back if desired
@@ -93,16 +100,15 @@ class TypeErasedObject {
   //    will also copy and move the shared pointer.
   //
   // 2. For any other case, the object will be copied or moved depending on the
-  //    argument into a std::unique_ptr stored within the TypeErasedObject.
-  //    Copying the TypeErasedObject will create new copies of the stored object
-  //    using its copy constructor. Moving it will just move the std::unique_ptr
-  //    containing it.
+  //    argument into heap memory owned by the TypeErasedObject. Copying the
+  //    TypeErasedObject will create new copies of the stored object using its
+  //    copy constructor. Moving it will just transfer the owning pointer.
   //
   // To ensure correct copyability and moveability of TypeErasedObjects, objects
   // stored within them must be copy constructible. Trying to make a copy of a
   // TypeErasedObject encapsulating an object that is not copy constructible
   // will raise a kNonCopyable fatal error at runtime. No move constructors are
-  // needed, as only the smart pointers containing them will be moved.
+  // needed, as only the pointers owning them will be moved.
   //
   // Note that copy-assignment is not used. Assigning two TypeErasedObjects will
   // will make use of the object destructor and copy constructor instead of its
@@ -114,6 +120,18 @@ class TypeErasedObject {
   template <typename T, typename = std::enable_if_t<!IsSharedPtr<T>::value>>
   void StoreObject(T&& object);
 
+  // Constructs an object of type T in the heap from the provided arguments,
+  // type-erasing it. Behaves like StoreObject, but the object is never copied
+  // or moved. Any previously stored object is destroyed.
+  //
+  // If the previously stored object also has type T, its heap memory is reused
+  // for the new object instead of allocating more. Because of this, arguments
+  // must not refer to the stored object.
+  //
+  // T must not be a reference type nor a std::shared_ptr.
+  template <typename T, typename... Args>
+  void EmplaceObject(Args&&... args);
+
   // Special version of StoreObject for shared pointers to objects.
   // Stores a shared_ptr object locally.
   //
@@ -137,36 +155,60 @@ class TypeErasedObject {
   static std::enable_if_t<!std::is_copy_constructible<T>::value, void*>
   CopyHeapObject(void* dest, const void* src);
 
-  // Moves a type-erased smart pointer.
-  // T is either a std::unique_ptr or a std::shared_ptr.
+  // Moves a type-erased shared pointer.
+  template <typename T>
+  static void* MoveSharedPointer(void* dest, void* src);
+
+  // Destroys a type-erased shared pointer.
+  template <typename T>
+  static void DestroySharedPointer(void* obj_erased);
+
+  // Destroys a type-erased stored object in the heap.
+  template <typename T>
+  static void DestroyHeapObject(void* obj_erased);
+
+  // Allocates heap memory for an object of type T and constructs it.
+  // Uses the custom allocator if any and respects the alignment of T even if
+  // stricter than the default one.
+  template <typename T, typename... Args>
+  static T* NewHeapObject(Args&&... args);
+
+  // Destroys an object created by NewHeapObject and releases its memory.
+  template <typename T>
+  static void DeleteHeapObject(T* object);
+
+  // Destroys any stored object and clears the instance. Returns the heap memory
+  // of the object without releasing it if it had type T, or nullptr otherwise.
+  template <typename T>
+  void* ReleaseObject() MF_NOEXCEPT;
+
+  // Allocates and releases heap memory for an object of type T.
   template <typename T>
-  static void* MoveSmartPointer(void* dest, void* src);
+  static void* AllocateHeapMemory();
 
-  // Destroys a type-erased stored object.
   template <typename T>
-  static void DestroyObject(void* obj_erased);
+  static void FreeHeapMemory(void* memory);
+
+  // Moves the stored object of another instance into this one.
+  // The other instance is left empty.
+  inline void MoveFrom(TypeErasedObject& object) MF_NOEXCEPT;
 
   using TypeErasedDestructor = void (*)(void*);
   using TypeErasedCopyConstructor = void* (*)(void*, const void*);
   using TypeErasedMoveConstructor = void* (*)(void*, void*);
 
-  // Deleter for std::unique_ptr that uses the current custom deallocation
-  // function if any is set.
+  // Deleter for std::unique_ptr that releases the heap memory of an object of
+  // type T, without destroying any object.
   template <typename T>
-  struct CustomAllocatorDeleter {
-    void operator ()(T* ptr);
+  struct HeapMemoryDeleter {
+    void operator ()(void* memory) { FreeHeapMemory<T>(memory); }
   };
 
-  // Version of std::unique_ptr that uses a deleter compatible with custom
-  // allocators.
-  template <typename T>
-  using CustomUniquePtr = std::unique_ptr<T, CustomAllocatorDeleter<T>>;
-
   // Possible contents of the data buffer.
   template <typename T>
   union DataBuffer {
     ~DataBuffer() = delete;
-    CustomUniquePtr<T> unique_ptr;
+    T* heap_ptr;
     std::shared_ptr<T> shared_ptr;
   };
 
@@ -193,10 +235,16 @@ class TypeErasedObject {
   TypeErasedCopyConstructor copy_constructor_;
 
   // When not null, points to a functions that moves the object represented
-  // in a data buffer into another.
+  // in a data buffer into another. Otherwise, the data buffer is trivially
+  // relocatable and can be moved by just copying it.
   TypeErasedMoveConstructor move_constructor_;
 };
 
+#if !defined(MF_DISABLE_NOEXCEPT)
+static_assert(std::is_nothrow_move_constructible<TypeErasedObject>::value,
+              "TypeErasedObject moves must not throw.");
+#endif
+
 }  // namespace mf
 
 #include <magic_func/type_erased_object.hpp>
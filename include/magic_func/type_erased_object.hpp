@@ -48,15 +48,8 @@ TypeErasedObject::TypeErasedObject(const TypeErasedObject& object)
       object.object_ptr_;
 }
 
-TypeErasedObject::TypeErasedObject(TypeErasedObject&& object) MF_NOEXCEPT
-    : TypeErasedObject() {
-  std::swap(object_ptr_, object.object_ptr_);
-  std::swap(destructor_, object.destructor_);
-  std::swap(copy_constructor_, object.copy_constructor_);
-  std::swap(move_constructor_, object.move_constructor_);
-
-  if (HasStoredObject())
-    object_ptr_ = (*move_constructor_)(data_, object.data_);
+TypeErasedObject::TypeErasedObject(TypeErasedObject&& object) MF_NOEXCEPT {
+  MoveFrom(object);
 }
 
 TypeErasedObject::~TypeErasedObject() {
@@ -83,30 +76,40 @@ TypeErasedObject& TypeErasedObject::operator =(
   return *this;
 }
 
-TypeErasedObject& TypeErasedObject::operator =(TypeErasedObject&& object) {
+TypeErasedObject& TypeErasedObject::operator =(
+    TypeErasedObject&& object) MF_NOEXCEPT {
   if (this == &object)
     return *this;
 
   if (destructor_)
     (*destructor_)(data_);
 
-  object_ptr_ = nullptr;
-  destructor_ = nullptr;
-  copy_constructor_ = nullptr;
-  move_constructor_ = nullptr;
+  MoveFrom(object);
+  return *this;
+}
 
-  std::swap(object_ptr_, object.object_ptr_);
-  std::swap(destructor_, object.destructor_);
-  std::swap(copy_constructor_, object.copy_constructor_);
-  std::swap(move_constructor_, object.move_constructor_);
+void TypeErasedObject::MoveFrom(TypeErasedObject& object) MF_NOEXCEPT {
+  object_ptr_ = object.object_ptr_;
+  destructor_ = object.destructor_;
+  copy_constructor_ = object.copy_constructor_;
+  move_constructor_ = object.move_constructor_;
 
-  if (HasStoredObject())
+  // Objects in the heap are owned by a raw pointer, so it is enough to copy
+  // the data buffer. Only shared pointers need their move constructor.
+  if (move_constructor_) {
     object_ptr_ = (*move_constructor_)(data_, object.data_);
+    (*object.destructor_)(object.data_);
+  } else if (destructor_) {
+    std::memcpy(data_, object.data_, sizeof(data_));
+  }
 
-  return *this;
+  object.object_ptr_ = nullptr;
+  object.destructor_ = nullptr;
+  object.copy_constructor_ = nullptr;
+  object.move_constructor_ = nullptr;
 }
 
-void TypeErasedObject::Reset() {
+void TypeErasedObject::Reset() MF_NOEXCEPT {
   if (destructor_)
     (*destructor_)(data_);
 
@@ -124,36 +127,51 @@ void TypeErasedObject::StorePointer(const T* object) {
 
 template <typename T, typename>
 void TypeErasedObject::StoreObject(T&& object) {
-  // Delete any previously stored object.
-  Reset();
+  // Storing the object already stored would destroy it before its copy.
+  if (HasStoredObject() && object_ptr_ == std::addressof(object))
+    return;
 
-  // Store a unique_ptr locally that owns the object in the heap.
-  using U = std::decay_t<T>;
-  static_assert(sizeof(data_) >= sizeof(CustomUniquePtr<U>),
-                "Buffer is too small.");
+  EmplaceObject<std::decay_t<T>>(std::forward<T>(object));
+}
 
-  static_assert(alignof(DataBuffer<void>) >= alignof(CustomUniquePtr<U>),
-                "Incompatible unique_ptr type alignments.");
+template <typename U, typename... Args>
+void TypeErasedObject::EmplaceObject(Args&&... args) {
+  static_assert(!std::is_reference<U>::value && !IsSharedPtr<U>::value,
+                "Type must not be a reference nor a shared_ptr.");
 
-  const auto& allocator = CustomAllocator();
-  CustomUniquePtr<U> heap_obj(nullptr, CustomAllocatorDeleter<U>());
+  // Delete any previously stored object, reusing its memory if possible.
+  // The memory is released if the constructor of the new object throws.
+  std::unique_ptr<void, HeapMemoryDeleter<U>> memory(ReleaseObject<U>());
+  if (!memory)
+    memory.reset(AllocateHeapMemory<U>());
 
-  if (allocator.first) {
-    // Use the custom allocator for the object heap data if set.
-    void* heap = (*allocator.first)(sizeof(U), alignof(U), allocator.second);
-    MAGIC_FUNC_CHECK(heap, Error::kCustomAllocator);
-    heap_obj.reset(new (heap) U(std::forward<T>(object)));
-  } else {
-    // Otherwise use the regular new operator.
-    heap_obj.reset(new U(std::forward<T>(object)));
-  }
+  // Store a pointer locally that owns the object in the heap.
+  static_assert(sizeof(data_) >= sizeof(U*), "Buffer is too small.");
 
-  auto local_unique_ptr = new (data_) CustomUniquePtr<U>(std::move(heap_obj));
-  object_ptr_ = const_cast<std::remove_cv_t<U>*>(local_unique_ptr->get());
+  auto local_ptr = new (data_) U*(
+      new (memory.get()) U(std::forward<Args>(args)...));
+  memory.release();
+  object_ptr_ = const_cast<std::remove_cv_t<U>*>(*local_ptr);
 
   copy_constructor_ = &CopyHeapObject<U>;
-  move_constructor_ = &MoveSmartPointer<CustomUniquePtr<U>>;
-  destructor_ = &DestroyObject<CustomUniquePtr<U>>;
+  move_constructor_ = nullptr;
+  destructor_ = &DestroyHeapObject<U>;
+}
+
+template <typename T>
+void* TypeErasedObject::ReleaseObject() MF_NOEXCEPT {
+  // Objects of the same type stored in the heap always come from an
+  // allocation of the same size and alignment.
+  void* memory = nullptr;
+  if (destructor_ == &DestroyHeapObject<T>) {
+    T* object = *reinterpret_cast<T**>(data_);
+    object->~T();
+    memory = const_cast<std::remove_cv_t<T>*>(object);
+    destructor_ = nullptr;
+  }
+
+  Reset();
+  return memory;
 }
 
 template <typename T>
@@ -172,8 +190,8 @@ void TypeErasedObject::StoreObject(const std::shared_ptr<T>& object) {
   object_ptr_ = const_cast<std::remove_cv_t<T>*>(ptr->get());
 
   copy_constructor_ = &CopySharedPointer<std::shared_ptr<T>>;
-  move_constructor_ = &MoveSmartPointer<std::shared_ptr<T>>;
-  destructor_ = &DestroyObject<std::shared_ptr<T>>;
+  move_constructor_ = &MoveSharedPointer<std::shared_ptr<T>>;
+  destructor_ = &DestroySharedPointer<std::shared_ptr<T>>;
 }
 
 template <typename T>
@@ -190,23 +208,12 @@ void* TypeErasedObject::CopySharedPointer(
 template <typename T>
 std::enable_if_t<std::is_copy_constructible<T>::value, void*>
 TypeErasedObject::CopyHeapObject(void* dest, const void* src) {
-  auto src_obj = reinterpret_cast<const CustomUniquePtr<T>*>(src);
+  auto src_obj = *reinterpret_cast<const T* const*>(src);
   MAGIC_FUNC_DCHECK(dest, Error::kInvalidObject);
   MAGIC_FUNC_DCHECK(src_obj, Error::kInvalidObject);
 
-  const auto& allocator = CustomAllocator();
-  CustomUniquePtr<T> heap_obj(nullptr, CustomAllocatorDeleter<T>());
-
-  if (allocator.first) {
-    void* heap = (*allocator.first)(sizeof(T), alignof(T), allocator.second);
-    MAGIC_FUNC_CHECK(heap, Error::kCustomAllocator);
-    heap_obj.reset(new (heap) T(*src_obj->get()));
-  } else {
-    heap_obj.reset(new T(*src_obj->get()));
-  }
-
-  auto ptr = new (dest) CustomUniquePtr<T>(std::move(heap_obj));
-  return const_cast<std::remove_cv_t<T>*>(ptr->get());
+  auto ptr = new (dest) T*(NewHeapObject<T>(*src_obj));
+  return const_cast<std::remove_cv_t<T>*>(*ptr);
 }
 
 template <typename T>
@@ -218,9 +225,8 @@ TypeErasedObject::CopyHeapObject(void*, const void*) {
 }
 
 template <typename T>
-void* TypeErasedObject::MoveSmartPointer(void* dest, void* src) {
-  static_assert(IsUniquePtr<T>::value || IsSharedPtr<T>::value,
-                "Type is not a unique_ptr or shared_ptr.");
+void* TypeErasedObject::MoveSharedPointer(void* dest, void* src) {
+  static_assert(IsSharedPtr<T>::value, "Type is not a shared_ptr.");
   auto src_obj = reinterpret_cast<T*>(src);
   MAGIC_FUNC_DCHECK(dest, Error::kInvalidObject);
   MAGIC_FUNC_DCHECK(src_obj, Error::kInvalidObject);
@@ -229,21 +235,67 @@ void* TypeErasedObject::MoveSmartPointer(void* dest, void* src) {
 }
 
 template <typename T>
-void TypeErasedObject::DestroyObject(void* obj_erased) {
+void TypeErasedObject::DestroySharedPointer(void* obj_erased) {
+  static_assert(IsSharedPtr<T>::value, "Type is not a shared_ptr.");
   auto obj = reinterpret_cast<T*>(obj_erased);
   MAGIC_FUNC_DCHECK(obj, Error::kInvalidObject);
   obj->~T();
 }
 
 template <typename T>
-void TypeErasedObject::CustomAllocatorDeleter<T>::operator ()(T* ptr) {
+void TypeErasedObject::DestroyHeapObject(void* obj_erased) {
+  auto obj = *reinterpret_cast<T**>(obj_erased);
+  MAGIC_FUNC_DCHECK(obj, Error::kInvalidObject);
+  DeleteHeapObject(obj);
+}
+
+template <typename T, typename... Args>
+T* TypeErasedObject::NewHeapObject(Args&&... args) {
+  // The memory is released if the constructor of the object throws.
+  std::unique_ptr<void, HeapMemoryDeleter<T>> memory(AllocateHeapMemory<T>());
+  T* object = new (memory.get()) T(std::forward<Args>(args)...);
+  memory.release();
+  return object;
+}
+
+template <typename T>
+void TypeErasedObject::DeleteHeapObject(T* object) {
+  object->~T();
+  FreeHeapMemory<T>(const_cast<std::remove_cv_t<T>*>(object));
+}
+
+template <typename T>
+void* TypeErasedObject::AllocateHeapMemory() {
+  MAGIC_FUNC_PROBE2(heap_allocate, sizeof(T), alignof(T));
+
+  // Use the custom allocator for the object heap data if set.
+  const auto& allocator = CustomAllocator();
+  if (allocator.first) {
+    void* memory = (*allocator.first)(sizeof(T), alignof(T), allocator.second);
+    MAGIC_FUNC_CHECK(memory, Error::kCustomAllocator);
+    return memory;
+  }
+
+  // The default operator new ignores extended alignments before C++17.
+  if (IsOverAligned<T>::value)
+    return AlignedAllocate(sizeof(T), alignof(T));
+
+  // Otherwise use the regular new operator.
+  return ::operator new(sizeof(T));
+}
+
+template <typename T>
+void TypeErasedObject::FreeHeapMemory(void* memory) {
   const auto& deallocator = CustomDeallocator();
   if (deallocator.first) {
-    if (!(*deallocator.first)(ptr, sizeof(T), alignof(T), deallocator.second)) {
+    if (!(*deallocator.first)(memory, sizeof(T), alignof(T),
+                              deallocator.second)) {
       MAGIC_FUNC_CHECK(false, Error::kCustomAllocator);
     }
+  } else if (IsOverAligned<T>::value) {
+    AlignedDeallocate(memory);
   } else {
-    delete ptr;
+    ::operator delete(memory);
   }
 }
 
@@ -75,6 +75,17 @@ class Function;
 template <typename FuncPtr>
 class MemberFunction;
 
+// Forward-declaration of closed functions.
+template <typename FunctionType, FunctionType*... func_ptrs>
+class ClosedFunction;
+
+// Tag type used to construct objects of type T in place.
+// Equivalent to C++17's std::in_place_type_t.
+template <typename T>
+struct InPlaceType {
+  explicit InPlaceType() = default;
+};
+
 namespace internal {
 
 template <typename T>
@@ -89,6 +100,13 @@ struct IsMemberFunctionImpl : public std::false_type {};
 template <typename T>
 struct IsMemberFunctionImpl<MemberFunction<T>> : public std::true_type {};
 
+template <typename T>
+struct IsClosedFunctionImpl : public std::false_type {};
+
+template <typename T, T*... func_ptrs>
+struct IsClosedFunctionImpl<ClosedFunction<T, func_ptrs...>>
+    : public std::true_type {};
+
 template <typename T>
 struct IsUniquePtrImpl : public std::false_type {};
 
@@ -101,6 +119,12 @@ struct IsSharedPtrImpl : public std::false_type {};
 template <typename T>
 struct IsSharedPtrImpl<std::shared_ptr<T>> : public std::true_type {};
 
+template <typename T>
+struct IsInPlaceTypeImpl : public std::false_type {};
+
+template <typename T>
+struct IsInPlaceTypeImpl<InPlaceType<T>> : public std::true_type {};
+
 } // namespace internal
 
 // Tells if a provided type is a mf::Function.
@@ -113,6 +137,11 @@ template <typename T>
 using IsMemberFunction = internal::IsMemberFunctionImpl<
     std::remove_cv_t<std::decay_t<T>>>;
 
+// Tells if a provided type is a mf::ClosedFunction.
+template <typename T>
+using IsClosedFunction = internal::IsClosedFunctionImpl<
+    std::remove_cv_t<std::decay_t<T>>>;
+
 // Tells if a provided type is a std::unique_ptr.
 template <typename T>
 using IsUniquePtr = internal::IsUniquePtrImpl<
@@ -123,6 +152,11 @@ template <typename T>
 using IsSharedPtr = internal::IsSharedPtrImpl<
     std::remove_cv_t<std::decay_t<T>>>;
 
+// Tells if a provided type is a mf::InPlaceType tag.
+template <typename T>
+using IsInPlaceType = internal::IsInPlaceTypeImpl<
+    std::remove_cv_t<std::decay_t<T>>>;
+
 // Tells if a provided type is a free function pointer.
 template <typename T>
 using IsFunctionPointer =
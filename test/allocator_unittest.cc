@@ -188,3 +188,32 @@ TEST(Allocator, CallStoredLambda) {
   // Reset the custom allocator so it does not affect other unit tests.
   mf::SetCustomAllocator(nullptr, nullptr, nullptr, nullptr);
 }
+
+TEST(Allocator, DestroyStoredLambda) {
+  TestAllocator allocator;
+
+  mf::SetCustomAllocator(
+      [](size_t size, size_t alignment, void* context) {
+        auto allocator = reinterpret_cast<TestAllocator*>(context);
+        return allocator->Allocate(size, alignment);
+      }, &allocator,
+
+      [](void* address, size_t size, size_t alignment, void* context) {
+        auto allocator = reinterpret_cast<TestAllocator*>(context);
+        return allocator->Deallocate(address, size, alignment);
+      }, &allocator);
+
+  // Objects are destroyed before their memory is released.
+  auto shared = std::make_shared<int>(0);
+  {
+    mf::Function<int()> function = [shared]() { return *shared; };
+    EXPECT_EQ(2, shared.use_count());
+    EXPECT_GT(allocator.UsedMemory(), 0U);
+  }
+
+  EXPECT_EQ(1, shared.use_count());
+  EXPECT_EQ(0U, allocator.UsedMemory());
+
+  // Reset the custom allocator so it does not affect other unit tests.
+  mf::SetCustomAllocator(nullptr, nullptr, nullptr, nullptr);
+}
@@ -0,0 +1,82 @@
+// Copyright (c) 2020, Leandro Graciá Gil
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <cstdint>
+
+#include <magic_func/cache_line_isolated.h>
+#include <magic_func/function.h>
+#include <gtest/gtest.h>
+
+using namespace mf;
+
+namespace {
+
+// Tells if an address is aligned to a cache line boundary.
+bool IsCacheLineAligned(const void* address) {
+  return reinterpret_cast<uintptr_t>(address) % kCacheLineSize == 0;
+}
+
+}  // anonymous namespace
+
+TEST(CacheLineIsolated, Layout) {
+  auto lambda = [](int x) { return x + 1; };
+  using Isolated = CacheLineIsolated<decltype(lambda)>;
+  static_assert(alignof(Isolated) == kCacheLineSize,
+                "Isolated callables must be aligned to cache lines.");
+  static_assert(sizeof(Isolated) % kCacheLineSize == 0,
+                "Isolated callables must fill whole cache lines.");
+}
+
+TEST(CacheLineIsolated, CallMutableLambda) {
+  size_t count = 0;
+  Function<size_t()> counter = MakeIsolated([count]() mutable {
+    return ++count;
+  });
+
+  EXPECT_EQ(1U, counter());
+  EXPECT_EQ(2U, counter());
+  EXPECT_EQ(3U, counter());
+}
+
+TEST(CacheLineIsolated, StoredInSeparateCacheLines) {
+  static constexpr size_t kNumFunctions = 16;
+  Function<int(int)> functions[kNumFunctions];
+  for (size_t i = 0; i < kNumFunctions; ++i)
+    functions[i] = MakeIsolated([i](int x) { return x + int(i); });
+
+  // Each callable starts its own cache line, including copies of them.
+  for (size_t i = 0; i < kNumFunctions; ++i) {
+    EXPECT_TRUE(IsCacheLineAligned(functions[i].GetObject()));
+    EXPECT_EQ(int(i) + 1, functions[i](1));
+
+    Function<int(int)> copy = functions[i];
+    EXPECT_TRUE(IsCacheLineAligned(copy.GetObject()));
+    EXPECT_NE(functions[i].GetObject(), copy.GetObject());
+  }
+}
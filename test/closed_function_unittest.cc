@@ -0,0 +1,134 @@
+// Copyright (c) 2020, Leandro Graciá Gil
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// This test needs C++ exceptions thrown by MagicFunc exceptions to work.
+// These exceptions are turned off in release builds that define NDEBUG.
+#undef NDEBUG
+
+#include <string>
+
+#include <magic_func/closed_function.h>
+#include <magic_func/error.h>
+#include <magic_func/function.h>
+#include <gtest/gtest.h>
+
+using namespace mf;
+
+namespace {
+
+int Add(int a, int b) { return a + b; }
+int Sub(int a, int b) { return a - b; }
+int Mul(int a, int b) { return a * b; }
+int Div(int a, int b) { return a / b; }
+
+using BinaryOp = ClosedFunction<int(int, int), &Add, &Sub, &Mul>;
+
+void Append(std::string& str, std::string&& suffix) {
+  str += std::move(suffix);
+}
+
+void Clear(std::string& str, std::string&&) { str.clear(); }
+
+}  // anonymous namespace
+
+TEST(ClosedFunction, Empty) {
+  BinaryOp op;
+  EXPECT_FALSE(op);
+  EXPECT_EQ(op, nullptr);
+  EXPECT_EQ(op.index(), BinaryOp::kEmpty);
+
+  BinaryOp null_op = nullptr;
+  EXPECT_EQ(op, null_op);
+  EXPECT_THROW(op(1, 2), Error);
+
+  // Sets with a single function also reject calls to empty objects.
+  ClosedFunction<int(int, int), &Add> single_op;
+  EXPECT_THROW(single_op(1, 2), Error);
+}
+
+TEST(ClosedFunction, CompileTimeSelection) {
+  static_assert(BinaryOp::IndexOf<&Add>() == 0, "Unexpected index.");
+  static_assert(BinaryOp::IndexOf<&Mul>() == 2, "Unexpected index.");
+  static_assert(BinaryOp::IndexOf<&Div>() == BinaryOp::kEmpty,
+                "Unexpected index.");
+  static_assert(sizeof(BinaryOp) == 1, "Unexpected size.");
+
+  BinaryOp op = BinaryOp::From<&Sub>();
+  EXPECT_TRUE(op);
+  EXPECT_NE(op, nullptr);
+  EXPECT_EQ(op.index(), 1u);
+  EXPECT_EQ(op(5, 3), 2);
+
+  op = BinaryOp::From<&Mul>();
+  EXPECT_EQ(op(5, 3), 15);
+
+  op = nullptr;
+  EXPECT_FALSE(op);
+}
+
+TEST(ClosedFunction, RuntimeSelection) {
+  BinaryOp op = &Add;
+  EXPECT_EQ(op(5, 3), 8);
+  EXPECT_EQ(op, BinaryOp::From<&Add>());
+  EXPECT_NE(op, BinaryOp::From<&Sub>());
+
+  op = &Mul;
+  EXPECT_EQ(op(5, 3), 15);
+
+  int (*null_func)(int, int) = nullptr;
+  op = null_func;
+  EXPECT_FALSE(op);
+
+  EXPECT_THROW(op = &Div, Error);
+}
+
+TEST(ClosedFunction, ForwardArguments) {
+  using Edit = ClosedFunction<void(std::string&, std::string&&),
+                              &Append, &Clear>;
+  std::string str = "foo";
+  Edit edit = Edit::From<&Append>();
+  edit(str, "bar");
+  EXPECT_EQ(str, "foobar");
+
+  edit = &Clear;
+  edit(str, "baz");
+  EXPECT_TRUE(str.empty());
+}
+
+TEST(ClosedFunction, ConvertToFunction) {
+  Function<int(int, int)> function = BinaryOp::From<&Mul>();
+  ASSERT_TRUE(function);
+  EXPECT_EQ(function(5, 3), 15);
+
+  function = BinaryOp::From<&Add>();
+  EXPECT_EQ(function(5, 3), 8);
+
+  function = BinaryOp();
+  EXPECT_FALSE(function);
+}
@@ -0,0 +1,232 @@
+// Copyright (c) 2020, Leandro Graciá Gil
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// This test needs C++ exceptions thrown by MagicFunc exceptions to work.
+// These exceptions are turned off in release builds that define NDEBUG.
+#undef NDEBUG
+
+#include <magic_func/coroutine.h>
+#include <gtest/gtest.h>
+
+#if defined(MF_HAS_COROUTINES)
+
+#include <memory>
+#include <string>
+
+#include <magic_func/allocator.h>
+#include <magic_func/function.h>
+
+using namespace mf;
+
+namespace {
+
+Task<int> Add(int a, int b) { co_return a + b; }
+
+Task<int> AddTwice(int a, int b) {
+  int first = co_await Add(a, b);
+  int second = co_await Add(first, b);
+  co_return second;
+}
+
+Task<> Append(std::string& text, std::string suffix) {
+  text += suffix;
+  co_return;
+}
+
+struct Counter {
+  Task<int> Increment(int delta) {
+    value += delta;
+    co_return value;
+  }
+
+  int value = 0;
+};
+
+// Counts the allocations made through the custom allocator.
+struct AllocationCounter {
+  size_t allocations = 0;
+  size_t deallocations = 0;
+  size_t allocated_bytes = 0;
+};
+
+void SetCountingAllocator(AllocationCounter* counter) {
+  mf::SetCustomAllocator(
+      [](size_t size, size_t, void* context) {
+        auto counter = static_cast<AllocationCounter*>(context);
+        ++counter->allocations;
+        counter->allocated_bytes += size;
+        return ::operator new(size);
+      }, counter,
+
+      [](void* address, size_t size, size_t, void* context) {
+        auto counter = static_cast<AllocationCounter*>(context);
+        ++counter->deallocations;
+        counter->allocated_bytes -= size;
+        ::operator delete(address);
+        return true;
+      }, counter);
+}
+
+Task<int, CustomAllocatorPromiseBase> AllocatedAdd(int a, int b) {
+  co_return a + b;
+}
+
+Task<int, CustomAllocatorPromiseBase> AllocatedAddTwice(int a, int b) {
+  int first = co_await AllocatedAdd(a, b);
+  co_return co_await AllocatedAdd(first, b);
+}
+
+}  // anonymous namespace
+
+TEST(Coroutine, Task) {
+  Task<int> task = Add(2, 3);
+  EXPECT_TRUE(task);
+  EXPECT_FALSE(task.done());
+
+  task.Resume();
+  EXPECT_TRUE(task.done());
+  EXPECT_EQ(5, task.Result());
+
+  Task<int> moved = std::move(task);
+  EXPECT_FALSE(task);
+  EXPECT_TRUE(moved.done());
+}
+
+TEST(Coroutine, AwaitTask) {
+  Task<int> task = AddTwice(1, 10);
+  task.Resume();
+  EXPECT_TRUE(task.done());
+  EXPECT_EQ(21, task.Result());
+}
+
+TEST(Coroutine, AwaitEmptyTask) {
+  EXPECT_THROW(Task<int>().operator co_await(), Error);
+
+  Task<int> task = Add(1, 2);
+  Task<int> moved = std::move(task);
+  EXPECT_THROW(std::move(task).operator co_await(), Error);
+  EXPECT_FALSE(std::move(moved).operator co_await().await_ready());
+}
+
+TEST(Coroutine, VoidTask) {
+  std::string text = "a";
+  Task<> task = Append(text, "b");
+  EXPECT_EQ("a", text);
+
+  task.Resume();
+  EXPECT_TRUE(task.done());
+  EXPECT_EQ("ab", text);
+}
+
+TEST(Coroutine, AsyncFunction) {
+  AsyncFunction<int(int, int)> function =
+      AsyncFunction<int(int, int)>::FromFunction<&Add>();
+  Task<int> task = function(4, 5);
+  task.Resume();
+  EXPECT_EQ(9, task.Result());
+
+  // Lambdas returning tasks.
+  int offset = 100;
+  function = [offset](int a, int b) -> Task<int> { co_return a + b + offset; };
+  task = function(1, 2);
+  task.Resume();
+  EXPECT_EQ(103, task.Result());
+
+  // Member functions bound to objects.
+  Counter counter;
+  auto increment = AsyncFunction<int(int)>::FromMemberFunction<
+      Counter, &Counter::Increment>(&counter);
+  Task<int> first = increment(2);
+  Task<int> second = increment(3);
+  first.Resume();
+  second.Resume();
+  EXPECT_EQ(2, first.Result());
+  EXPECT_EQ(5, second.Result());
+}
+
+TEST(Coroutine, DestroyUnfinishedTask) {
+  auto shared = std::make_shared<int>(0);
+  auto coroutine = [](std::shared_ptr<int> value) -> Task<int> {
+    co_return *value;
+  };
+
+  // The frame and its arguments are destroyed with the task.
+  {
+    Task<int> task = coroutine(shared);
+    EXPECT_EQ(2, shared.use_count());
+  }
+  EXPECT_EQ(1, shared.use_count());
+}
+
+TEST(Coroutine, CustomAllocatorPromiseBase) {
+  AllocationCounter counter;
+  SetCountingAllocator(&counter);
+
+  // Frames of default tasks do not use the custom allocator.
+  {
+    Task<int> task = AddTwice(1, 2);
+    task.Resume();
+    EXPECT_EQ(5, task.Result());
+  }
+  EXPECT_EQ(0U, counter.allocations);
+
+  {
+    Task<int, CustomAllocatorPromiseBase> task = AllocatedAddTwice(1, 2);
+    EXPECT_EQ(1U, counter.allocations);
+    task.Resume();
+    EXPECT_EQ(5, task.Result());
+    EXPECT_EQ(3U, counter.allocations);
+    EXPECT_EQ(2U, counter.deallocations);
+  }
+
+  EXPECT_EQ(3U, counter.allocations);
+  EXPECT_EQ(3U, counter.deallocations);
+  EXPECT_EQ(0U, counter.allocated_bytes);
+
+  // Reset the custom allocator so it does not affect other unit tests.
+  mf::SetCustomAllocator(nullptr, nullptr, nullptr, nullptr);
+}
+
+TEST(Coroutine, CustomAllocatorFailure) {
+  mf::SetCustomAllocator(
+      [](size_t, size_t, void*) -> void* { return nullptr; }, nullptr,
+      [](void*, size_t, size_t, void*) { return true; }, nullptr);
+
+  try {
+    AllocatedAdd(1, 2);
+    FAIL();
+  } catch (Error error) {
+    EXPECT_EQ(Error::kCustomAllocator, error);
+  }
+
+  // Reset the custom allocator so it does not affect other unit tests.
+  mf::SetCustomAllocator(nullptr, nullptr, nullptr, nullptr);
+}
+
+#endif  // defined(MF_HAS_COROUTINES)
@@ -0,0 +1,206 @@
+// Copyright (c) 2020, Leandro Graciá Gil
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <magic_func/function_queue.h>
+#include <gtest/gtest.h>
+
+using namespace mf;
+
+namespace {
+
+// Counts how many instances are alive.
+struct Counted {
+  Counted(int* alive) : alive(alive) { ++*alive; }
+  Counted(const Counted& other) : alive(other.alive) { ++*alive; }
+  ~Counted() { --*alive; }
+  void operator ()(int& calls) const { ++calls; }
+  int* alive;
+};
+
+// Callable with a configurable amount of captured data.
+template <size_t N>
+struct Padded {
+  void operator ()(std::vector<size_t>& sizes) const { sizes.push_back(N); }
+  char data[N];
+};
+
+template <size_t N>
+bool Push(FunctionQueue<void(std::vector<size_t>&)>& queue,
+          std::vector<size_t>& expected) {
+  if (!queue.TryPush(Padded<N>()))
+    return false;
+  expected.push_back(N);
+  return true;
+}
+
+}  // anonymous namespace
+
+TEST(FunctionQueue, PushAndInvoke) {
+  FunctionQueue<void(int&)> queue(1024);
+  EXPECT_TRUE(queue.empty());
+  EXPECT_EQ(queue.capacity(), 1024u);
+  int value = 0;
+  EXPECT_FALSE(queue.InvokeOne(value));
+
+  std::string text;
+  ASSERT_TRUE(queue.TryPush([&text](int& value) { text += "a"; value += 1; }));
+  ASSERT_TRUE(queue.TryPush([&text](int& value) { text += "b"; value *= 10; }));
+  EXPECT_FALSE(queue.empty());
+
+  EXPECT_TRUE(queue.InvokeOne(value));
+  EXPECT_EQ(text, "a");
+  EXPECT_EQ(value, 1);
+
+  EXPECT_EQ(queue.InvokeAll(value), 1u);
+  EXPECT_EQ(text, "ab");
+  EXPECT_EQ(value, 10);
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST(FunctionQueue, CapacityRoundedUp) {
+  FunctionQueue<void()> queue(1000);
+  EXPECT_EQ(queue.capacity(), 1024u);
+}
+
+TEST(FunctionQueue, Emplace) {
+  FunctionQueue<void(int&)> queue(1024);
+  int alive = 0;
+  ASSERT_TRUE(queue.TryEmplace<Counted>(&alive));
+  EXPECT_EQ(alive, 1);
+
+  int calls = 0;
+  EXPECT_EQ(queue.InvokeAll(calls), 1u);
+  EXPECT_EQ(calls, 1);
+  EXPECT_EQ(alive, 0);
+}
+
+TEST(FunctionQueue, Full) {
+  FunctionQueue<void(std::vector<size_t>&)> queue(256);
+  size_t pushed = 0;
+  while (queue.TryPush(Padded<40>()))
+    ++pushed;
+  EXPECT_GT(pushed, 0u);
+  EXPECT_FALSE(queue.TryPush(Padded<40>()));
+
+  // Consuming frees the space again.
+  std::vector<size_t> sizes;
+  EXPECT_EQ(queue.InvokeAll(sizes), pushed);
+
+  // Callables larger than the buffer never fit.
+  EXPECT_FALSE(queue.TryPush(Padded<512>()));
+  EXPECT_TRUE(queue.TryPush(Padded<40>()));
+}
+
+TEST(FunctionQueue, VariableSizesWrapAround) {
+  FunctionQueue<void(std::vector<size_t>&)> queue(512);
+  std::vector<size_t> expected;
+  std::vector<size_t> sizes;
+
+  // Interleave pushes of different sizes so that records wrap around the
+  // end of the buffer at many different offsets.
+  for (int i = 0; i < 1000; ++i) {
+    bool pushed = false;
+    switch (i % 4) {
+      case 0: pushed = Push<1>(queue, expected); break;
+      case 1: pushed = Push<24>(queue, expected); break;
+      case 2: pushed = Push<100>(queue, expected); break;
+      case 3: pushed = Push<7>(queue, expected); break;
+    }
+    if (!pushed || i % 3 == 0)
+      queue.InvokeOne(sizes);
+  }
+  queue.InvokeAll(sizes);
+
+  EXPECT_EQ(sizes, expected);
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST(FunctionQueue, MoveOnlyCapture) {
+  struct MoveOnly {
+    void operator ()(int& out) const { out = *value; }
+    std::unique_ptr<int> value;
+  };
+
+  FunctionQueue<void(int&)> queue(256);
+  MoveOnly callable = { std::unique_ptr<int>(new int(42)) };
+  ASSERT_TRUE(queue.TryPush(std::move(callable)));
+  EXPECT_FALSE(callable.value);
+
+  int out = 0;
+  EXPECT_TRUE(queue.InvokeOne(out));
+  EXPECT_EQ(out, 42);
+}
+
+TEST(FunctionQueue, DestroysPendingCallables) {
+  int alive = 0;
+  {
+    FunctionQueue<void(int&)> queue(1024);
+    Counted counted(&alive);
+    for (int i = 0; i < 10; ++i)
+      ASSERT_TRUE(queue.TryPush(counted));
+    EXPECT_EQ(alive, 11);
+
+    int calls = 0;
+    queue.InvokeOne(calls);
+    EXPECT_EQ(alive, 10);
+  }
+  EXPECT_EQ(alive, 0);
+}
+
+TEST(FunctionQueue, Threads) {
+  constexpr int kNumCallables = 100000;
+  FunctionQueue<void(std::vector<int>&)> queue(4096);
+
+  std::thread producer([&queue]() {
+    for (int i = 0; i < kNumCallables; ++i) {
+      std::string padding(i % 3 == 0 ? 40 : 0, 'x');
+      while (!queue.TryPush([i, padding](std::vector<int>& values) {
+        values.push_back(i);
+      })) {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  std::vector<int> values;
+  while (values.size() < static_cast<size_t>(kNumCallables)) {
+    if (!queue.InvokeAll(values))
+      std::this_thread::yield();
+  }
+  producer.join();
+
+  ASSERT_EQ(values.size(), static_cast<size_t>(kNumCallables));
+  for (int i = 0; i < kNumCallables; ++i)
+    ASSERT_EQ(values[i], i);
+}
@@ -31,8 +31,15 @@
 // These exceptions are turned off in release builds that define NDEBUG.
 #undef NDEBUG
 
+#include <atomic>
 #include <functional>
+#include <thread>
 #include <type_traits>
+#include <vector>
+
+#ifdef MF_TEST_PLUGIN_PATH
+#include <dlfcn.h>
+#endif
 
 #include <magic_func/error.h>
 #include <magic_func/function.h>
@@ -1484,6 +1491,98 @@ TEST(Function, MoveConstructFunction) {
   EXPECT_FALSE(func4);
 }
 
+// Functions must be moved instead of copied by containers when growing.
+#if !defined(MF_DISABLE_NOEXCEPT)
+static_assert(std::is_nothrow_move_constructible<Function<int(int)>>::value,
+              "Function moves must not throw.");
+static_assert(
+    std::is_nothrow_move_constructible<
+        MemberFunction<decltype(&Object::Function)>>::value,
+    "MemberFunction moves must not throw.");
+#endif
+
+TEST(Function, ContainerGrowth) {
+  size_t copies = 0;
+  struct CopyCounter {
+    explicit CopyCounter(size_t* copies) : copies(copies) {}
+    CopyCounter(const CopyCounter& counter) : copies(counter.copies) {
+      ++*copies;
+    }
+    int operator ()(int x) const { return x + 1; }
+    size_t* copies;
+  };
+
+  std::vector<Function<int(int)>> functions;
+  for (int i = 0; i < 100; ++i)
+    functions.emplace_back(CopyCounter(&copies));
+
+  // Only the initial copies into the heap should happen.
+  EXPECT_EQ(100U, copies);
+  for (int i = 0; i < 100; ++i)
+    EXPECT_EQ(i + 1, functions[i](i));
+}
+
+TEST(Function, InPlaceCallable) {
+  // Callable that can be neither copied nor moved.
+  struct Adder {
+    explicit Adder(int value) : value(value) {}
+    Adder(const Adder&) = delete;
+    Adder(Adder&&) = delete;
+    int operator ()(int x) const { return x + value; }
+    int value;
+  };
+
+  Function<int(int)> function(InPlaceType<Adder>(), 5);
+  EXPECT_TRUE(function);
+  EXPECT_EQ(8, function(3));
+  EXPECT_EQ(5, reinterpret_cast<Adder*>(function.GetObject())->value);
+
+  // Moving the function does not need to move the callable.
+  Function<int(int)> moved = std::move(function);
+  EXPECT_FALSE(function);
+  EXPECT_EQ(8, moved(3));
+}
+
+TEST(Function, AssignmentReusesStorage) {
+  // Callbacks re-armed with the same lambda type keep their heap memory.
+  Function<int()> function;
+  void* memory = nullptr;
+  for (int i = 0; i < 10; ++i) {
+    function = [i]() { return i; };
+    if (!memory)
+      memory = function.GetObject();
+    EXPECT_EQ(memory, function.GetObject());
+    EXPECT_EQ(i, function());
+  }
+
+  function = []() { return -1; };
+  EXPECT_EQ(-1, function());
+}
+
+TEST(Function, Emplace) {
+  // Callable that can be neither copied nor moved.
+  struct Adder {
+    explicit Adder(int value) : value(value) {}
+    Adder(const Adder&) = delete;
+    Adder(Adder&&) = delete;
+    int operator ()(int x) const { return x + value; }
+    int value;
+  };
+
+  Function<int(int)> function = [](int x) { return x; };
+  Adder& adder = function.emplace<Adder>(5);
+  EXPECT_EQ(&adder, function.GetObject());
+  EXPECT_EQ(8, function(3));
+
+  adder.value = 10;
+  EXPECT_EQ(13, function(3));
+
+  // Emplacing the same type again reuses the memory.
+  Adder& other = function.emplace<Adder>(1);
+  EXPECT_EQ(&adder, &other);
+  EXPECT_EQ(4, function(3));
+}
+
 TEST(Function, CopyAssignFunction) {
   Function<int(int)> func1 = [](int x) { return x + 1; };
   Function<int(int)> func2;
@@ -1513,3 +1612,85 @@ TEST(Function, MoveAssignFunction) {
   EXPECT_FALSE(func3);
   EXPECT_FALSE(func4);
 }
+
+namespace {
+
+int Triple(int x) { return x * 3; }
+
+}  // anonymous namespace
+
+TEST(Function, LazyResolution) {
+  int num_resolutions = 0;
+  auto function = Function<int(int)>::FromResolver([&num_resolutions]() {
+    ++num_resolutions;
+    return &Triple;
+  });
+  auto copy = function;
+  EXPECT_TRUE(function);
+  EXPECT_EQ(num_resolutions, 0);
+
+  EXPECT_EQ(function(2), 6);
+  EXPECT_EQ(num_resolutions, 1);
+  EXPECT_EQ(function(3), 9);
+  EXPECT_EQ(num_resolutions, 1);
+
+  // Copies share the resolved target.
+  EXPECT_EQ(copy(4), 12);
+  EXPECT_EQ(num_resolutions, 1);
+}
+
+TEST(Function, LazyResolutionFailure) {
+  int num_resolutions = 0;
+  auto function = Function<int(int)>::FromResolver([&num_resolutions]() {
+    return ++num_resolutions > 1 ? &Triple : nullptr;
+  });
+
+  EXPECT_THROW(function(2), Error);
+  EXPECT_EQ(num_resolutions, 1);
+
+  // The resolver is tried again until it succeeds.
+  EXPECT_EQ(function(2), 6);
+  EXPECT_EQ(num_resolutions, 2);
+  EXPECT_EQ(function(3), 9);
+  EXPECT_EQ(num_resolutions, 2);
+}
+
+TEST(Function, LazyResolutionThreads) {
+  constexpr size_t kNumThreads = 8;
+  std::atomic<int> num_resolutions(0);
+  auto function = Function<int(int)>::FromResolver([&num_resolutions]() {
+    ++num_resolutions;
+    std::this_thread::yield();
+    return &Triple;
+  });
+
+  std::atomic<int> sum(0);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < kNumThreads; ++i)
+    threads.emplace_back([&function, &sum]() { sum += function(1); });
+  for (auto& thread : threads)
+    thread.join();
+
+  EXPECT_EQ(num_resolutions, 1);
+  EXPECT_EQ(sum, static_cast<int>(3 * kNumThreads));
+}
+
+#ifdef MF_TEST_PLUGIN_PATH
+TEST(Function, LazyResolutionFromPlugin) {
+  void* plugin = dlopen(MF_TEST_PLUGIN_PATH, RTLD_NOW | RTLD_LOCAL);
+  ASSERT_NE(plugin, nullptr) << dlerror();
+
+  auto resolver = [plugin]() {
+    return reinterpret_func<int (*)(int, int)>(dlsym(plugin, "PluginAdd"));
+  };
+  auto function = Function<int(int, int)>::FromResolver(resolver);
+  EXPECT_EQ(function(2, 3), 5);
+
+  auto missing = Function<int(int, int)>::FromResolver([plugin]() {
+    return reinterpret_func<int (*)(int, int)>(dlsym(plugin, "Missing"));
+  });
+  EXPECT_THROW(missing(2, 3), Error);
+
+  dlclose(plugin);
+}
+#endif
@@ -0,0 +1,186 @@
+// Copyright (c) 2020, Leandro Graciá Gil
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// This test needs C++ exceptions thrown by MagicFunc exceptions to work.
+// These exceptions are turned off in release builds that define NDEBUG.
+#undef NDEBUG
+
+#include <memory>
+#include <string>
+#include <type_traits>
+
+#include <magic_func/error.h>
+#include <magic_func/overloaded_function.h>
+#include <gtest/gtest.h>
+
+using namespace mf;
+
+namespace {
+
+// Callable object handling different argument types.
+struct Visitor {
+  explicit Visitor(int* counter) : counter(counter) {}
+
+  int operator ()(int x) { ++*counter; return x * 2; }
+  int operator ()(const std::string& str) {
+    ++*counter;
+    return static_cast<int>(str.size());
+  }
+  int operator ()(int x, int y) const { return x + y; }
+
+  int* counter;
+};
+
+// Callable object with a template operator.
+struct SizeOf {
+  template <typename T>
+  size_t operator ()(T) const { return sizeof(T); }
+};
+
+}  // anonymous namespace
+
+TEST(OverloadedFunction, Empty) {
+  OverloadedFunction<void(int), void(float)> function;
+  EXPECT_FALSE(function);
+  EXPECT_EQ(function, nullptr);
+  EXPECT_EQ(nullptr, function.GetObject());
+
+  try {
+    function(1);
+    FAIL();
+  } catch (Error error) {
+    EXPECT_EQ(Error::kInvalidFunction, error);
+  }
+}
+
+TEST(OverloadedFunction, CallableOverloads) {
+  int counter = 0;
+  OverloadedFunction<int(int), int(const std::string&), int(int, int)>
+      function = Visitor(&counter);
+
+  EXPECT_TRUE(function);
+  EXPECT_NE(function, nullptr);
+  EXPECT_NE(nullptr, function.GetObject());
+
+  EXPECT_EQ(46, function(23));
+  EXPECT_EQ(7, function(std::string("testing")));
+  EXPECT_EQ(5, function(2, 3));
+  EXPECT_EQ(2, counter);
+}
+
+TEST(OverloadedFunction, TemplateOperator) {
+  // A single template operator can provide all the signatures.
+  OverloadedFunction<size_t(char), size_t(double)> function = SizeOf();
+  EXPECT_EQ(sizeof(char), function('a'));
+  EXPECT_EQ(sizeof(double), function(1.0));
+}
+
+TEST(OverloadedFunction, SingleObject) {
+  // The callable object is stored once for all signatures, so state is shared.
+  struct Counter {
+    void operator ()(int) { ++count; }
+    void operator ()(double) { ++count; }
+    int count = 0;
+  };
+
+  OverloadedFunction<void(int), void(double)> function = Counter();
+  function(1);
+  function(1.0);
+  function(2);
+  EXPECT_EQ(3, static_cast<Counter*>(function.GetObject())->count);
+}
+
+TEST(OverloadedFunction, CopyAndMove) {
+  int counter = 0;
+  OverloadedFunction<int(int), int(const std::string&)> function =
+      Visitor(&counter);
+
+  // Copies own a different callable object.
+  auto copy = function;
+  EXPECT_NE(function.GetObject(), copy.GetObject());
+  EXPECT_EQ(4, copy(2));
+  EXPECT_EQ(3, copy(std::string("abc")));
+
+  // Moves keep the same object.
+  void* object = function.GetObject();
+  auto moved = std::move(function);
+  EXPECT_EQ(object, moved.GetObject());
+  EXPECT_FALSE(function.GetObject());
+  EXPECT_FALSE(function);
+  EXPECT_TRUE(function == nullptr);
+  EXPECT_EQ(6, moved(3));
+  EXPECT_EQ(3, counter);
+
+  // Move assignment also leaves the moved object empty.
+  function = std::move(moved);
+  EXPECT_EQ(object, function.GetObject());
+  EXPECT_FALSE(moved.GetObject());
+  EXPECT_FALSE(moved);
+  EXPECT_EQ(8, function(4));
+  EXPECT_EQ(4, counter);
+}
+
+TEST(OverloadedFunction, NonCallableTypes) {
+  using Overloaded = OverloadedFunction<int(int), int(const std::string&)>;
+
+  // Neither nullptr nor other function objects are wrapped as callables.
+  static_assert(!std::is_constructible<Overloaded, std::nullptr_t>::value,
+                "Must not be constructible from nullptr.");
+  static_assert(!std::is_constructible<Overloaded, Function<int(int)>>::value,
+                "Must not wrap a function.");
+  static_assert(
+      !std::is_constructible<Overloaded, const TypeErasedFunction&>::value,
+      "Must not wrap a type-erased function.");
+
+  Overloaded function = Visitor(nullptr);
+  function = nullptr;
+  EXPECT_FALSE(function);
+}
+
+TEST(OverloadedFunction, Assign) {
+  int counter = 0;
+  OverloadedFunction<int(int), int(int, int)> function;
+  function = Visitor(&counter);
+  EXPECT_EQ(2, function(1));
+  EXPECT_EQ(3, function(1, 2));
+
+  function = nullptr;
+  EXPECT_FALSE(function);
+  EXPECT_EQ(nullptr, function.GetObject());
+}
+
+TEST(OverloadedFunction, SharedPointerCallable) {
+  // Shared pointers are stored like any other callable.
+  auto callable = std::make_shared<int>(0);
+  OverloadedFunction<void(int), void(float)> function =
+      [callable](float x) { *callable += static_cast<int>(x); };
+  function(2);
+  function(3.5f);
+  EXPECT_EQ(5, *callable);
+}
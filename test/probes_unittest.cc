@@ -0,0 +1,193 @@
+// Copyright (c) 2020, Leandro Graciá Gil
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <elf.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <magic_func/function.h>
+#include <magic_func/probes.h>
+#include <gtest/gtest.h>
+
+using namespace mf;
+
+namespace {
+
+// A USDT probe described by a stapsdt note.
+struct ProbeNote {
+  uint64_t address;
+  std::string provider;
+  std::string name;
+  std::string args;
+};
+
+// Reads the stapsdt notes and the executable address range of the running
+// program from its ELF file.
+bool ReadProbeNotes(std::vector<ProbeNote>& notes, uint64_t& text_begin,
+                    uint64_t& text_end) {
+  std::ifstream file("/proc/self/exe", std::ios::binary);
+  std::vector<char> elf((std::istreambuf_iterator<char>(file)),
+                        std::istreambuf_iterator<char>());
+  if (elf.size() < sizeof(Elf64_Ehdr))
+    return false;
+
+  const auto* header = reinterpret_cast<const Elf64_Ehdr*>(elf.data());
+  if (memcmp(header->e_ident, ELFMAG, SELFMAG) != 0 ||
+      header->e_ident[EI_CLASS] != ELFCLASS64) {
+    return false;
+  }
+
+  const auto* sections =
+      reinterpret_cast<const Elf64_Shdr*>(elf.data() + header->e_shoff);
+  const char* section_names =
+      elf.data() + sections[header->e_shstrndx].sh_offset;
+
+  for (size_t i = 0; i < header->e_shnum; ++i) {
+    const Elf64_Shdr& section = sections[i];
+    std::string name = section_names + section.sh_name;
+    if (name == ".text") {
+      text_begin = section.sh_addr;
+      text_end = section.sh_addr + section.sh_size;
+    }
+
+    if (name != ".note.stapsdt")
+      continue;
+
+    // Each note has a header, the "stapsdt" name and a descriptor with three
+    // addresses followed by the provider, name and argument strings.
+    size_t offset = section.sh_offset;
+    size_t end = section.sh_offset + section.sh_size;
+    while (offset + sizeof(Elf64_Nhdr) <= end) {
+      const auto* note = reinterpret_cast<const Elf64_Nhdr*>(&elf[offset]);
+      size_t name_offset = offset + sizeof(Elf64_Nhdr);
+      size_t desc_offset = name_offset + ((note->n_namesz + 3) & ~3);
+      offset = desc_offset + ((note->n_descsz + 3) & ~3);
+      if (note->n_type != 3 || strcmp(&elf[name_offset], "stapsdt") != 0)
+        continue;
+
+      ProbeNote probe;
+      memcpy(&probe.address, &elf[desc_offset], sizeof(probe.address));
+      const char* strings = &elf[desc_offset + 3 * sizeof(uint64_t)];
+      probe.provider = strings;
+      strings += probe.provider.size() + 1;
+      probe.name = strings;
+      strings += probe.name.size() + 1;
+      probe.args = strings;
+      notes.push_back(probe);
+    }
+  }
+
+  return true;
+}
+
+// Returns the probe note with the provided name, or null if not found.
+const ProbeNote* FindProbe(const std::vector<ProbeNote>& notes,
+                           const std::string& name) {
+  for (const ProbeNote& note : notes) {
+    if (note.provider == "magic_func" && note.name == name)
+      return &note;
+  }
+  return nullptr;
+}
+
+}  // anonymous namespace
+
+#if defined(MAGIC_FUNC_HAS_PROBES)
+
+namespace {
+
+// Emits probes with different numbers of arguments.
+void CustomProbes(int x, const void* pointer) {
+  MAGIC_FUNC_PROBE0(test_probe0);
+  MAGIC_FUNC_PROBE3(test_probe3, x, pointer, sizeof(x));
+}
+
+}  // anonymous namespace
+
+TEST(Probes, HeapAllocateProbe) {
+  // Functions storing large callables allocate heap memory.
+  struct LargeCallable {
+    int operator ()() const { return data[0]; }
+    int data[32];
+  };
+  Function<int()> function = LargeCallable{{1}};
+  EXPECT_EQ(1, function());
+
+  std::vector<ProbeNote> notes;
+  uint64_t text_begin = 0, text_end = 0;
+  ASSERT_TRUE(ReadProbeNotes(notes, text_begin, text_end));
+
+  const ProbeNote* probe = FindProbe(notes, "heap_allocate");
+  ASSERT_NE(nullptr, probe);
+  EXPECT_EQ(0U, probe->args.find("8@"));
+  EXPECT_NE(std::string::npos, probe->args.find(" 8@"));
+
+  // The probe address must be the NOP in the program code.
+  EXPECT_LE(text_begin, probe->address);
+  EXPECT_GT(text_end, probe->address);
+}
+
+TEST(Probes, CustomProbes) {
+  int x = 0;
+  CustomProbes(x, &x);
+
+  std::vector<ProbeNote> notes;
+  uint64_t text_begin = 0, text_end = 0;
+  ASSERT_TRUE(ReadProbeNotes(notes, text_begin, text_end));
+
+  const ProbeNote* probe0 = FindProbe(notes, "test_probe0");
+  ASSERT_NE(nullptr, probe0);
+  EXPECT_EQ("", probe0->args);
+
+  const ProbeNote* probe3 = FindProbe(notes, "test_probe3");
+  ASSERT_NE(nullptr, probe3);
+  EXPECT_EQ(0U, probe3->args.find("8@"));
+  EXPECT_EQ(2, std::count(probe3->args.begin(), probe3->args.end(), ' '));
+}
+
+#else
+
+TEST(Probes, DisabledProbes) {
+  // Disabled probes compile to nothing and must not evaluate their arguments.
+  int evaluated = 0;
+  MAGIC_FUNC_PROBE1(test_probe1, ++evaluated);
+  EXPECT_EQ(0, evaluated);
+
+  std::vector<ProbeNote> notes;
+  uint64_t text_begin = 0, text_end = 0;
+  if (ReadProbeNotes(notes, text_begin, text_end))
+    EXPECT_EQ(nullptr, FindProbe(notes, "test_probe1"));
+}
+
+#endif
@@ -0,0 +1,284 @@
+// Copyright (c) 2020, Leandro Graciá Gil
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <magic_func/rate_limit.h>
+#include <gtest/gtest.h>
+
+using namespace mf;
+
+namespace {
+
+// Clock only advancing when told to.
+struct FakeClock {
+  using rep = int64_t;
+  using period = std::nano;
+  using duration = std::chrono::duration<rep, period>;
+  using time_point = std::chrono::time_point<FakeClock>;
+  static constexpr bool is_steady = true;
+
+  static time_point now() { return time_point(current); }
+  static duration current;
+};
+
+FakeClock::duration FakeClock::current;
+
+using Milliseconds = std::chrono::milliseconds;
+
+// Runs tasks when their delay elapses in the fake clock.
+class FakeExecutor {
+ public:
+  DelayedExecutor<FakeClock> GetExecutor() {
+    return [this](const Function<void()>& task, FakeClock::duration delay) {
+      tasks_.emplace_back(FakeClock::now() + delay, task);
+    };
+  }
+
+  // Advances the fake clock, running any tasks that become due.
+  void Advance(FakeClock::duration duration) {
+    FakeClock::current += duration;
+    for (size_t i = 0; i < tasks_.size();) {
+      if (tasks_[i].first > FakeClock::now()) {
+        ++i;
+        continue;
+      }
+
+      // Tasks can schedule new tasks when run.
+      Function<void()> task = std::move(tasks_[i].second);
+      tasks_.erase(tasks_.begin() + i);
+      task();
+      i = 0;
+    }
+  }
+
+  size_t num_tasks() const { return tasks_.size(); }
+
+ private:
+  std::vector<std::pair<FakeClock::time_point, Function<void()>>> tasks_;
+};
+
+}  // anonymous namespace
+
+TEST(RateLimit, Throttle) {
+  std::vector<int> calls;
+  Function<void(int)> function = [&calls](int value) {
+    calls.push_back(value);
+  };
+
+  auto throttled = Throttle<FakeClock>(function, Milliseconds(10));
+  throttled(1);
+  throttled(2);
+  FakeClock::current += Milliseconds(9);
+  throttled(3);
+  FakeClock::current += Milliseconds(1);
+  throttled(4);
+  throttled(5);
+  FakeClock::current += Milliseconds(25);
+  throttled(6);
+
+  EXPECT_EQ(calls, std::vector<int>({1, 4, 6}));
+}
+
+TEST(RateLimit, MakeThrottle) {
+  std::vector<int> calls;
+  auto throttled = MakeThrottle<FakeClock>(
+      [&calls](int value) { calls.push_back(value); }, Milliseconds(10));
+  static_assert(std::is_same<decltype(throttled), Function<void(int)>>::value,
+                "Unexpected function type.");
+
+  FakeClock::current += Milliseconds(10);
+  throttled(1);
+  throttled(2);
+  EXPECT_EQ(calls, std::vector<int>({1}));
+}
+
+TEST(RateLimit, ThrottleThreads) {
+  std::atomic<int> calls(0);
+  Function<void()> function = [&calls]() { ++calls; };
+
+  // Only one of the calls made at the same time gets through.
+  auto throttled = Throttle<FakeClock>(function, Milliseconds(10));
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&throttled]() {
+      for (int j = 0; j < 1000; ++j)
+        throttled();
+    });
+  }
+
+  for (auto& thread : threads)
+    thread.join();
+  EXPECT_EQ(calls, 1);
+}
+
+TEST(RateLimit, Debounce) {
+  std::vector<std::string> calls;
+  Function<void(const std::string&)> function =
+      [&calls](const std::string& value) { calls.push_back(value); };
+
+  FakeExecutor executor;
+  auto debounced = Debounce<FakeClock>(function, Milliseconds(100),
+                                       executor.GetExecutor());
+
+  // Arguments are copied, since the calls are deferred.
+  std::string value = "a";
+  debounced(value);
+  value = "b";
+  debounced(value);
+  EXPECT_EQ(executor.num_tasks(), 1u);
+
+  // Calls keep postponing the function until they stop for the delay.
+  executor.Advance(Milliseconds(60));
+  debounced("c");
+  executor.Advance(Milliseconds(60));
+  EXPECT_TRUE(calls.empty());
+
+  executor.Advance(Milliseconds(40));
+  EXPECT_EQ(calls, std::vector<std::string>({"c"}));
+  EXPECT_EQ(executor.num_tasks(), 0u);
+
+  // Later bursts schedule new calls.
+  debounced("d");
+  debounced("e");
+  executor.Advance(Milliseconds(100));
+  EXPECT_EQ(calls, std::vector<std::string>({"c", "e"}));
+}
+
+TEST(RateLimit, DebounceCallsWhileForwarding) {
+  std::vector<int> calls;
+  Function<void(int)> debounced;
+  Function<void(int)> function = [&calls, &debounced](int value) {
+    calls.push_back(value);
+    if (value == 1)
+      debounced(2);
+  };
+
+  FakeExecutor executor;
+  debounced = Debounce<FakeClock>(function, Milliseconds(10),
+                                  executor.GetExecutor());
+  debounced(1);
+
+  // Calls made while the arguments are forwarded wait for a new delay.
+  executor.Advance(Milliseconds(10));
+  EXPECT_EQ(calls, std::vector<int>({1}));
+  EXPECT_EQ(executor.num_tasks(), 1u);
+
+  executor.Advance(Milliseconds(10));
+  EXPECT_EQ(calls, std::vector<int>({1, 2}));
+  EXPECT_EQ(executor.num_tasks(), 0u);
+}
+
+TEST(RateLimit, DebounceOutlivesFunction) {
+  int calls = 0;
+  Function<void(int)> function = [&calls](int value) { calls += value; };
+
+  // Scheduled tasks keep the debounced state alive.
+  FakeExecutor executor;
+  {
+    auto debounced = Debounce<FakeClock>(function, Milliseconds(10),
+                                         executor.GetExecutor());
+    debounced(5);
+  }
+
+  executor.Advance(Milliseconds(10));
+  EXPECT_EQ(calls, 5);
+}
+
+TEST(RateLimit, DebounceMoveOnlyArgs) {
+  int result = 0;
+  Function<void(std::unique_ptr<int>)> function =
+      [&result](std::unique_ptr<int> value) { result = *value; };
+
+  FakeExecutor executor;
+  auto debounced = Debounce<FakeClock>(function, Milliseconds(10),
+                                       executor.GetExecutor());
+  debounced(std::unique_ptr<int>(new int(1)));
+  debounced(std::unique_ptr<int>(new int(2)));
+  executor.Advance(Milliseconds(10));
+  EXPECT_EQ(result, 2);
+}
+
+TEST(RateLimit, Coalesce) {
+  std::vector<int> calls;
+  Function<void(int)> function = [&calls](int value) {
+    calls.push_back(value);
+  };
+
+  FakeExecutor executor;
+  auto coalesced = Coalesce<FakeClock>(function, executor.GetExecutor());
+  for (int i = 0; i < 10; ++i)
+    coalesced(i);
+  EXPECT_EQ(executor.num_tasks(), 1u);
+
+  executor.Advance(FakeClock::duration::zero());
+  EXPECT_EQ(calls, std::vector<int>({9}));
+}
+
+TEST(RateLimit, CoalesceThreads) {
+  std::atomic<int> last(-1);
+  Function<void(int)> function = [&last](int value) { last = value; };
+
+  // Tasks are run by the main thread while others keep calling.
+  std::atomic<bool> has_task(false);
+  Function<void()> task;
+  DelayedExecutor<> executor = [&](const Function<void()>& new_task,
+                                   std::chrono::steady_clock::duration) {
+    task = new_task;
+    has_task = true;
+  };
+
+  auto coalesced = Coalesce(function, executor);
+  std::atomic<bool> done(false);
+  std::thread producer([&]() {
+    for (int i = 0; i <= 10000; ++i)
+      coalesced(i);
+    done = true;
+  });
+
+  while (!done || has_task) {
+    if (has_task.exchange(false)) {
+      Function<void()> current = std::move(task);
+      current();
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+
+  EXPECT_EQ(last, 10000);
+}
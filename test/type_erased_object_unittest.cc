@@ -31,6 +31,9 @@
 // These exceptions are turned off in release builds that define NDEBUG.
 #undef NDEBUG
 
+#include <cstdint>
+#include <vector>
+
 #include <magic_func/type_erased_object.h>
 #include <gtest/gtest.h>
 
@@ -311,7 +314,7 @@ TEST(TypeErasedObject, CopyTypeErasedObjects) {
   EXPECT_EQ(0, moved);
   EXPECT_EQ(1, destroyed);
 
-  // The type-erased object is moved, but only the unique_ptr owning the object
+  // The type-erased object is moved, but only the pointer owning the object
   // in the heap is moved. The object itself is not.
   TypeErasedObject test_move = std::move(test_copy);
   EXPECT_EQ(4, copied);
@@ -432,6 +435,123 @@ TEST(TypeErasedObject, CopyTypeErasedObjectsShared) {
   EXPECT_EQ(1, destroyed);
 }
 
+TEST(TypeErasedObject, EmplaceObject) {
+  TypeErasedObject test;
+  size_t copied, moved, destroyed;
+
+  // The object is constructed directly in its heap storage.
+  test.EmplaceObject<Object>(&copied, &moved, &destroyed);
+  EXPECT_TRUE(test);
+  EXPECT_TRUE(test.HasStoredObject());
+  EXPECT_EQ(0, copied);
+  EXPECT_EQ(0, moved);
+  EXPECT_EQ(0, destroyed);
+
+  // Copies still use the copy constructor of the object.
+  TypeErasedObject test_copy = test;
+  EXPECT_EQ(1, copied);
+  EXPECT_EQ(0, moved);
+
+  test.Reset();
+  test_copy.Reset();
+  EXPECT_EQ(2, destroyed);
+}
+
+TEST(TypeErasedObject, ReuseObjectMemory) {
+  TypeErasedObject test;
+  size_t copied, moved, destroyed;
+  Object object(&copied, &moved, &destroyed);
+
+  // Storing an object of the same type reuses the memory of the previous one
+  // after destroying it.
+  test.StoreObject(object);
+  void* memory = test.GetObject();
+  test.StoreObject(object);
+  EXPECT_EQ(memory, test.GetObject());
+  EXPECT_EQ(2, copied);
+  EXPECT_EQ(1, destroyed);
+
+  test.EmplaceObject<Object>(object);
+  EXPECT_EQ(memory, test.GetObject());
+  EXPECT_EQ(3, copied);
+  EXPECT_EQ(2, destroyed);
+
+  // Storing the object already stored does nothing.
+  test.StoreObject(*reinterpret_cast<Object*>(test.GetObject()));
+  EXPECT_EQ(memory, test.GetObject());
+  EXPECT_EQ(3, copied);
+  EXPECT_EQ(2, destroyed);
+
+  // Objects of other types get new memory.
+  test.StoreObject(NonCopyable());
+  EXPECT_TRUE(test.HasStoredObject());
+  EXPECT_EQ(3, destroyed);
+
+  test.Reset();
+}
+
+TEST(TypeErasedObject, ReuseObjectMemoryThrowing) {
+  struct Throwing {
+    explicit Throwing(bool fail) {
+      if (fail)
+        throw Error::kInvalidObject;
+    }
+  };
+
+  // The previous object is already destroyed if the constructor of the new
+  // one throws, so the instance is left empty.
+  TypeErasedObject test;
+  test.EmplaceObject<Throwing>(false);
+  EXPECT_TRUE(test.HasStoredObject());
+
+  try {
+    test.EmplaceObject<Throwing>(true);
+    FAIL();
+  } catch (Error error) {
+    EXPECT_EQ(Error::kInvalidObject, error);
+  }
+
+  EXPECT_FALSE(test);
+  EXPECT_FALSE(test.HasStoredObject());
+}
+
+TEST(TypeErasedObject, OverAlignedObject) {
+  struct alignas(256) OverAligned {
+    int value;
+  };
+
+  // Objects are allocated respecting their alignment, even if stricter than
+  // the one of the default operator new.
+  TypeErasedObject test;
+  test.StoreObject(OverAligned{5});
+  EXPECT_EQ(0U, reinterpret_cast<uintptr_t>(test.GetObject()) % 256);
+  EXPECT_EQ(5, reinterpret_cast<OverAligned*>(test.GetObject())->value);
+
+  TypeErasedObject test_copy = test;
+  EXPECT_EQ(0U, reinterpret_cast<uintptr_t>(test_copy.GetObject()) % 256);
+  EXPECT_EQ(5, reinterpret_cast<OverAligned*>(test_copy.GetObject())->value);
+}
+
+TEST(TypeErasedObject, ContainerGrowth) {
+  size_t copied, moved, destroyed;
+  Object object(&copied, &moved, &destroyed);
+
+  // Growing a container must move the type-erased objects rather than copying
+  // them, which requires their move constructors to be noexcept.
+  std::vector<TypeErasedObject> objects;
+  for (size_t i = 0; i < 100; ++i) {
+    objects.emplace_back();
+    objects.back().StoreObject(object);
+  }
+
+  EXPECT_EQ(100, copied);
+  EXPECT_EQ(0, moved);
+  EXPECT_EQ(0, destroyed);
+
+  objects.clear();
+  EXPECT_EQ(100, destroyed);
+}
+
 TEST(TypeErasedObject, NonCopyableObject) {
   TypeErasedObject test;
   test.StoreObject(NonCopyable());
@@ -75,6 +75,18 @@ TEST(TypeTraits, IsMemberFunction) {
   EXPECT_FALSE(IsMemberFunction<Function<void(int)>>::value);
 }
 
+TEST(TypeTraits, IsClosedFunction) {
+  using FunctionType = std::remove_pointer_t<decltype(&FreeFunction)>;
+  EXPECT_TRUE((IsClosedFunction<
+      ClosedFunction<FunctionType, &FreeFunction>>::value));
+  EXPECT_TRUE((IsClosedFunction<
+      const ClosedFunction<FunctionType, &FreeFunction>&>::value));
+
+  EXPECT_FALSE(IsClosedFunction<int>::value);
+  EXPECT_FALSE(IsClosedFunction<Function<void(int)>>::value);
+  EXPECT_FALSE(IsClosedFunction<decltype(&FreeFunction)>::value);
+}
+
 TEST(TypeTraits, IsSharedPtr) {
   EXPECT_TRUE(IsSharedPtr<std::shared_ptr<int>>::value);
   EXPECT_TRUE(IsSharedPtr<std::shared_ptr<int>&>::value);